@@ -15,7 +15,8 @@ SOURCES += src/Logger.cpp \
            src/AbstractStringAppender.cpp \
            src/ConsoleAppender.cpp \
            src/FileAppender.cpp \
-           src/RollingFileAppender.cpp
+           src/RollingFileAppender.cpp \
+           src/JsonLinesAppender.cpp
 
 HEADERS += include/Logger.h \
            include/CuteLogger_global.h \
@@ -23,7 +24,8 @@ HEADERS += include/Logger.h \
            include/AbstractStringAppender.h \
            include/ConsoleAppender.h \
            include/FileAppender.h \
-           include/RollingFileAppender.h
+           include/RollingFileAppender.h \
+           include/JsonLinesAppender.h
 
 win32 {
     SOURCES += src/OutputDebugAppender.cpp
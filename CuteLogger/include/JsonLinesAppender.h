@@ -0,0 +1,46 @@
+/*
+  Copyright (c) 2019 Meltytech, LLC
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License version 2.1
+  as published by the Free Software Foundation and appearing in the file
+  LICENSE.LGPL included in the packaging of this file.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+*/
+#ifndef JSONLINESAPPENDER_H
+#define JSONLINESAPPENDER_H
+
+// Logger
+#include "CuteLogger_global.h"
+#include <AbstractAppender.h>
+
+// Qt
+#include <QFile>
+
+
+class CUTELOGGERSHARED_EXPORT JsonLinesAppender : public AbstractAppender
+{
+  public:
+    JsonLinesAppender(const QString& fileName = QString());
+    ~JsonLinesAppender();
+
+    QString fileName() const;
+    void setFileName(const QString&);
+
+  protected:
+    virtual void append(const QDateTime& timeStamp, Logger::LogLevel logLevel, const char* file, int line,
+                        const char* function, const QString& category, const QString& message);
+    bool openFile();
+    void closeFile();
+
+  private:
+    QFile m_logFile;
+    qint64 m_epochOffset;
+    mutable QMutex m_logFileMutex;
+};
+
+#endif // JSONLINESAPPENDER_H
@@ -18,6 +18,8 @@
 #include <QString>
 #include <QDebug>
 #include <QDateTime>
+#include <QAtomicInt>
+#include <QVariant>
 
 // Local
 #include "CuteLogger_global.h"
@@ -29,24 +31,37 @@ CUTELOGGERSHARED_EXPORT Logger* cuteLoggerInstance();
 #define cuteLogger cuteLoggerInstance()
 
 
-#define LOG_TRACE            CuteMessageLogger(cuteLoggerInstance(), Logger::Trace,   __FILE__, __LINE__, Q_FUNC_INFO).write
-#define LOG_DEBUG            CuteMessageLogger(cuteLoggerInstance(), Logger::Debug,   __FILE__, __LINE__, Q_FUNC_INFO).write
-#define LOG_INFO             CuteMessageLogger(cuteLoggerInstance(), Logger::Info,    __FILE__, __LINE__, Q_FUNC_INFO).write
-#define LOG_WARNING          CuteMessageLogger(cuteLoggerInstance(), Logger::Warning, __FILE__, __LINE__, Q_FUNC_INFO).write
-#define LOG_ERROR            CuteMessageLogger(cuteLoggerInstance(), Logger::Error,   __FILE__, __LINE__, Q_FUNC_INFO).write
+// Records below this level are removed at compile time, e.g. DEFINES += CUTELOGGER_MIN_LEVEL=1 removes LOG_TRACE
+#ifndef CUTELOGGER_MIN_LEVEL
+#  define CUTELOGGER_MIN_LEVEL 0
+#endif
+
+// Skips the statement, including formatting its arguments, when the level is disabled. The empty if branch keeps
+// an else following the macro attached to the enclosing if.
+#define CUTELOGGER_IF_ENABLED(level) \
+  if (!(int(level) >= CUTELOGGER_MIN_LEVEL && cuteLoggerInstance()->isEnabled(level))) {} else
+
+#define LOG_TRACE            CUTELOGGER_IF_ENABLED(Logger::Trace)   CuteMessageLogger(cuteLoggerInstance(), Logger::Trace,   __FILE__, __LINE__, Q_FUNC_INFO).write
+#define LOG_DEBUG            CUTELOGGER_IF_ENABLED(Logger::Debug)   CuteMessageLogger(cuteLoggerInstance(), Logger::Debug,   __FILE__, __LINE__, Q_FUNC_INFO).write
+#define LOG_INFO             CUTELOGGER_IF_ENABLED(Logger::Info)    CuteMessageLogger(cuteLoggerInstance(), Logger::Info,    __FILE__, __LINE__, Q_FUNC_INFO).write
+#define LOG_WARNING          CUTELOGGER_IF_ENABLED(Logger::Warning) CuteMessageLogger(cuteLoggerInstance(), Logger::Warning, __FILE__, __LINE__, Q_FUNC_INFO).write
+#define LOG_ERROR            CUTELOGGER_IF_ENABLED(Logger::Error)   CuteMessageLogger(cuteLoggerInstance(), Logger::Error,   __FILE__, __LINE__, Q_FUNC_INFO).write
 #define LOG_FATAL            CuteMessageLogger(cuteLoggerInstance(), Logger::Fatal,   __FILE__, __LINE__, Q_FUNC_INFO).write
 
-#define LOG_CTRACE(category)   CuteMessageLogger(cuteLoggerInstance(), Logger::Trace,   __FILE__, __LINE__, Q_FUNC_INFO, category).write()
-#define LOG_CDEBUG(category)   CuteMessageLogger(cuteLoggerInstance(), Logger::Debug,   __FILE__, __LINE__, Q_FUNC_INFO, category).write()
-#define LOG_CINFO(category)    CuteMessageLogger(cuteLoggerInstance(), Logger::Info,    __FILE__, __LINE__, Q_FUNC_INFO, category).write()
-#define LOG_CWARNING(category) CuteMessageLogger(cuteLoggerInstance(), Logger::Warning, __FILE__, __LINE__, Q_FUNC_INFO, category).write()
-#define LOG_CERROR(category)   CuteMessageLogger(cuteLoggerInstance(), Logger::Error,   __FILE__, __LINE__, Q_FUNC_INFO, category).write()
+#define LOG_CTRACE(category)   CUTELOGGER_IF_ENABLED(Logger::Trace)   CuteMessageLogger(cuteLoggerInstance(), Logger::Trace,   __FILE__, __LINE__, Q_FUNC_INFO, category).write()
+#define LOG_CDEBUG(category)   CUTELOGGER_IF_ENABLED(Logger::Debug)   CuteMessageLogger(cuteLoggerInstance(), Logger::Debug,   __FILE__, __LINE__, Q_FUNC_INFO, category).write()
+#define LOG_CINFO(category)    CUTELOGGER_IF_ENABLED(Logger::Info)    CuteMessageLogger(cuteLoggerInstance(), Logger::Info,    __FILE__, __LINE__, Q_FUNC_INFO, category).write()
+#define LOG_CWARNING(category) CUTELOGGER_IF_ENABLED(Logger::Warning) CuteMessageLogger(cuteLoggerInstance(), Logger::Warning, __FILE__, __LINE__, Q_FUNC_INFO, category).write()
+#define LOG_CERROR(category)   CUTELOGGER_IF_ENABLED(Logger::Error)   CuteMessageLogger(cuteLoggerInstance(), Logger::Error,   __FILE__, __LINE__, Q_FUNC_INFO, category).write()
 #define LOG_CFATAL(category)   CuteMessageLogger(cuteLoggerInstance(), Logger::Fatal,   __FILE__, __LINE__, Q_FUNC_INFO, category).write()
 
 #define LOG_TRACE_TIME  LoggerTimingHelper loggerTimingHelper(cuteLoggerInstance(), Logger::Trace, __FILE__, __LINE__, Q_FUNC_INFO); loggerTimingHelper.start
 #define LOG_DEBUG_TIME  LoggerTimingHelper loggerTimingHelper(cuteLoggerInstance(), Logger::Debug, __FILE__, __LINE__, Q_FUNC_INFO); loggerTimingHelper.start
 #define LOG_INFO_TIME   LoggerTimingHelper loggerTimingHelper(cuteLoggerInstance(), Logger::Info,  __FILE__, __LINE__, Q_FUNC_INFO); loggerTimingHelper.start
 
+// Writes a trace event covering the rest of the scope when tracing is on, see Logger::setTracing()
+#define LOG_SPAN(name)  LoggerSpan loggerSpan(cuteLoggerInstance(), name)
+
 #define LOG_ASSERT(cond)        ((!(cond)) ? cuteLoggerInstance()->writeAssert(__FILE__, __LINE__, Q_FUNC_INFO, #cond) : qt_noop())
 #define LOG_ASSERT_X(cond, msg) ((!(cond)) ? cuteLoggerInstance()->writeAssert(__FILE__, __LINE__, Q_FUNC_INFO, msg) : qt_noop())
 
@@ -96,6 +111,14 @@ class CUTELOGGERSHARED_EXPORT Logger
       TimingMs    //!< Always use milliseconds to display
     };
 
+    //! Describes what happens to a log record when the queue of the asynchronous mode is full
+    enum OverflowPolicy
+    {
+      OverflowDrop,  //!< Discard the record
+      OverflowCount, //!< Discard the record and write the number of discarded records later (default)
+      OverflowBlock  //!< Wait until there is room in the queue
+    };
+
     static QString levelToString(LogLevel logLevel);
     static LogLevel levelFromString(const QString& s);
 
@@ -118,11 +141,33 @@ class CUTELOGGERSHARED_EXPORT Logger
 
     void writeAssert(const char* file, int line, const char* function, const char* condition);
 
+    void setMinimumLevel(LogLevel level);
+    LogLevel minimumLevel() const;
+    //! Returns whether records of the level are written. This is cheap enough to call before formatting a message.
+    inline bool isEnabled(LogLevel level) const { return level >= m_minimumLevel.load(); }
+
+    void setAsynchronous(bool asynchronous, int queueSize = 4096, OverflowPolicy overflowPolicy = OverflowCount);
+    bool isAsynchronous() const;
+    void flush();
+
+    void setTracing(bool tracing);
+    //! Returns whether trace events are written. This is cheap enough to call on every frame.
+    inline bool isTracing() const { return m_tracing.load(); }
+    static const char* traceCategory();
+    static qint64 traceTimestamp();
+    void writeTraceEvent(char phase, const char* name, qint64 timestamp, qint64 duration = 0, quint64 id = 0,
+                         const QVariantMap& args = QVariantMap());
+
   private:
+    friend class LogWriter;
     void write(const QDateTime& timeStamp, LogLevel logLevel, const char* file, int line, const char* function, const char* category,
                const QString& message, bool fromLocalInstance);
+    void writeToAppenders(const QDateTime& timeStamp, LogLevel logLevel, const char* file, int line, const char* function,
+                          const QString& category, const QString& message, bool fromLocalInstance);
     Q_DECLARE_PRIVATE(Logger)
     LoggerPrivate* d_ptr;
+    QAtomicInt m_minimumLevel;
+    QAtomicInt m_tracing;
 };
 
 
@@ -215,4 +260,29 @@ class CUTELOGGERSHARED_EXPORT LoggerTimingHelper
 };
 
 
+class CUTELOGGERSHARED_EXPORT LoggerSpan
+{
+  Q_DISABLE_COPY(LoggerSpan)
+
+  public:
+    inline explicit LoggerSpan(Logger* l, const char* name)
+      : m_logger(l),
+        m_name(name),
+        m_start(l->isTracing() ? Logger::traceTimestamp() : -1)
+    {}
+
+    //! Returns whether the span is written, so that arguments that are costly to compute can be skipped.
+    inline bool isActive() const { return m_start >= 0; }
+    void setArgument(const QString& key, const QVariant& value);
+
+    ~LoggerSpan();
+
+  private:
+    Logger* m_logger;
+    const char* m_name;
+    qint64 m_start;
+    QVariantMap m_args;
+};
+
+
 #endif // LOGGER_H
@@ -0,0 +1,136 @@
+/*
+  Copyright (c) 2019 Meltytech, LLC
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License version 2.1
+  as published by the Free Software Foundation and appearing in the file
+  LICENSE.LGPL included in the packaging of this file.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+*/
+// Local
+#include "JsonLinesAppender.h"
+
+// Qt
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// STL
+#include <iostream>
+
+/**
+ * \class JsonLinesAppender
+ *
+ * \brief Appender that writes the log records to a file as one JSON object per line.
+ *
+ * Each record becomes an object with the timestamp in microseconds ("ts"), the level, category ("cat"), function
+ * ("func"), file, line and message ("msg"). The timestamps are on the monotonic clock of Logger::traceTimestamp(), so
+ * the records line up with the trace events. Those are written as they are, so registering the appender for the
+ * Logger::traceCategory() too produces a file that a script can turn into a trace for a trace viewer.
+ *
+ * The file is flushed for warnings and errors and when the appender is destroyed rather than for every record,
+ * because the trace events can number hundreds per second.
+ *
+ * \sa Logger::setTracing()
+ */
+
+
+//! Constructs the new JSON lines appender assigned to file with the given name.
+JsonLinesAppender::JsonLinesAppender(const QString& fileName)
+  : m_epochOffset(QDateTime::currentMSecsSinceEpoch() * 1000 - Logger::traceTimestamp())
+{
+  setFileName(fileName);
+}
+
+
+JsonLinesAppender::~JsonLinesAppender()
+{
+  closeFile();
+}
+
+
+//! Returns the name set by setFileName() or to the JsonLinesAppender constructor.
+/**
+ * \sa setFileName()
+ */
+QString JsonLinesAppender::fileName() const
+{
+  QMutexLocker locker(&m_logFileMutex);
+  return m_logFile.fileName();
+}
+
+
+//! Sets the name of the file. The name can have no path, a relative path, or an absolute path.
+/**
+ * \sa fileName()
+ */
+void JsonLinesAppender::setFileName(const QString& s)
+{
+  QMutexLocker locker(&m_logFileMutex);
+  if (m_logFile.isOpen())
+    m_logFile.close();
+
+  m_logFile.setFileName(s);
+}
+
+
+bool JsonLinesAppender::openFile()
+{
+  bool isOpen = m_logFile.isOpen();
+  if (!isOpen)
+  {
+    isOpen = m_logFile.open(QIODevice::WriteOnly | QIODevice::Append);
+    if (!isOpen)
+      std::cerr << "<JsonLinesAppender::append> Cannot open the log file " << qPrintable(m_logFile.fileName()) << std::endl;
+  }
+  return isOpen;
+}
+
+
+//! Write the log record to the file.
+/**
+ * \sa fileName()
+ */
+void JsonLinesAppender::append(const QDateTime& timeStamp, Logger::LogLevel logLevel, const char* file, int line,
+                               const char* function, const QString& category, const QString& message)
+{
+  QMutexLocker locker(&m_logFileMutex);
+
+  if (openFile())
+  {
+    if (category == QLatin1String(Logger::traceCategory()))
+    {
+      m_logFile.write(message.toUtf8());
+    }
+    else
+    {
+      QJsonObject record;
+      record.insert(QLatin1String("ts"), double(timeStamp.toMSecsSinceEpoch() * 1000 - m_epochOffset));
+      record.insert(QLatin1String("level"), Logger::levelToString(logLevel));
+      if (!category.isEmpty())
+        record.insert(QLatin1String("cat"), category);
+      if (function)
+        record.insert(QLatin1String("func"), QString::fromLatin1(function));
+      if (file)
+      {
+        record.insert(QLatin1String("file"), QString::fromLatin1(file));
+        record.insert(QLatin1String("line"), line);
+      }
+      record.insert(QLatin1String("msg"), message);
+      m_logFile.write(QJsonDocument(record).toJson(QJsonDocument::Compact));
+    }
+    m_logFile.write("\n", 1);
+    if (logLevel >= Logger::Warning)
+      m_logFile.flush();
+  }
+}
+
+
+void JsonLinesAppender::closeFile()
+{
+  QMutexLocker locker(&m_logFileMutex);
+  m_logFile.close();
+}
@@ -23,6 +23,16 @@
 #include <QDateTime>
 #include <QIODevice>
 #include <QTextCodec>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QThreadStorage>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 #if defined(Q_OS_ANDROID)
 #  include <android/log.h>
@@ -431,6 +441,28 @@
  */
 
 
+/**
+ * \def LOG_SPAN(name)
+ *
+ * \brief Writes a trace event covering the rest of the current code block
+ *
+ * When tracing is on, this macro writes a trace event with the given name, the time the block was entered and how long
+ * it took. Typed values can be attached with loggerSpan.setArgument(). While tracing is off, it only checks a flag.
+ *
+ * \code
+ * void Player::seek(int position)
+ * {
+ *   LOG_SPAN("seek");
+ *   loggerSpan.setArgument("position", position);
+ *   ...
+ * }
+ * \endcode
+ *
+ * \sa Logger::setTracing()
+ * \sa LoggerSpan
+ */
+
+
 /**
  * \class Logger
  *
@@ -494,6 +526,263 @@ class LogDevice : public QIODevice
 };
 
 
+//! A log record waiting in the queue of the asynchronous mode
+/**
+ * The file and function names are copied because the Qt message handler passes names that do not outlive the call.
+ */
+struct LogRecord
+{
+  QDateTime timeStamp;
+  Logger::LogLevel logLevel;
+  QByteArray file;
+  int line;
+  QByteArray function;
+  QString category;
+  QString message;
+  bool fromLocalInstance;
+  bool isFlushMarker;
+};
+
+
+//! Bounded lock-free queue with many producers and a single consumer
+/**
+ * Each cell carries a sequence number that tells a producer whether the cell is free for the current lap and the
+ * consumer whether it is filled. Producers only contend on the enqueue position, and neither side takes a lock.
+ * The size must be a power of two.
+ */
+class LogQueue
+{
+  public:
+    explicit LogQueue(int size)
+      : m_mask(quint32(size) - 1),
+        m_cells(new Cell[size]),
+        m_enqueuePos(0),
+        m_dequeuePos(0)
+    {
+      for (int i = 0; i < size; ++i)
+        m_cells[i].sequence.store(quint32(i));
+    }
+
+    ~LogQueue()
+    {
+      delete[] m_cells;
+    }
+
+    //! Returns false if the queue is full. Optionally returns the position of the record in the queue.
+    bool enqueue(const LogRecord& record, quint32* position = 0)
+    {
+      quint32 pos = m_enqueuePos.load();
+      forever
+      {
+        Cell& cell = m_cells[pos & m_mask];
+        qint32 diff = qint32(cell.sequence.loadAcquire() - pos);
+        if (diff == 0)
+        {
+          if (m_enqueuePos.testAndSetRelaxed(pos, pos + 1))
+          {
+            cell.record = record;
+            cell.sequence.storeRelease(pos + 1);
+            if (position)
+              *position = pos;
+            return true;
+          }
+        }
+        else if (diff < 0)
+        {
+          return false;
+        }
+        pos = m_enqueuePos.load();
+      }
+    }
+
+    //! Returns false if the queue is empty. Only the consumer may call this.
+    bool dequeue(LogRecord& record)
+    {
+      Cell& cell = m_cells[m_dequeuePos & m_mask];
+      if (qint32(cell.sequence.loadAcquire() - (m_dequeuePos + 1)) < 0)
+        return false;
+      record = cell.record;
+      // Release the strings here rather than in a producer.
+      cell.record = LogRecord();
+      cell.sequence.storeRelease(m_dequeuePos + m_mask + 1);
+      ++m_dequeuePos;
+      return true;
+    }
+
+    //! Only the consumer may call this.
+    bool isEmpty() const
+    {
+      const Cell& cell = m_cells[m_dequeuePos & m_mask];
+      return qint32(cell.sequence.loadAcquire() - (m_dequeuePos + 1)) < 0;
+    }
+
+  private:
+    Q_DISABLE_COPY(LogQueue)
+
+    struct Cell
+    {
+      QAtomicInteger<quint32> sequence;
+      LogRecord record;
+    };
+
+    quint32 m_mask;
+    Cell* m_cells;
+    QAtomicInteger<quint32> m_enqueuePos;
+    quint32 m_dequeuePos;
+};
+
+
+//! Background thread that writes the queued log records of a Logger to its appenders
+class LogWriter : public QThread
+{
+  public:
+    LogWriter(Logger* logger, int queueSize, Logger::OverflowPolicy overflowPolicy)
+      : m_logger(logger),
+        m_queue(queueSize),
+        m_overflowPolicy(overflowPolicy),
+        m_isStopped(0),
+        m_isSleeping(0),
+        m_dropped(0),
+        m_written(0)
+    {
+      setObjectName(QLatin1String("Logger"));
+    }
+
+    ~LogWriter()
+    {
+      stop();
+    }
+
+    //! Queues a record. Returns false if the writer is stopped and the caller must write the record itself.
+    bool post(const LogRecord& record)
+    {
+      while (!m_isStopped.load())
+      {
+        if (m_queue.enqueue(record))
+        {
+          // Only the producer that clears the flag wakes the writer, so a busy logger locks once per idle period.
+          if (m_isSleeping.testAndSetOrdered(1, 0))
+            wake();
+          return true;
+        }
+        switch (m_overflowPolicy)
+        {
+          case Logger::OverflowDrop:
+            return true;
+          case Logger::OverflowCount:
+            m_dropped.ref();
+            return true;
+          case Logger::OverflowBlock:
+            wake();
+            QThread::usleep(100);
+            break;
+        }
+      }
+      return false;
+    }
+
+    //! Waits until every record queued before the call is written
+    void flush()
+    {
+      // The records are written in queue order, so once a marker queued now is written, so is every record that
+      // claimed an earlier position, even one that was not published yet when the marker was queued.
+      LogRecord marker = LogRecord();
+      marker.isFlushMarker = true;
+      quint32 position;
+      while (!m_queue.enqueue(marker, &position))
+      {
+        if (!isRunning())
+          return;
+        wake();
+        QThread::usleep(100);
+      }
+      if (m_isSleeping.testAndSetOrdered(1, 0))
+        wake();
+      QMutexLocker locker(&m_mutex);
+      while (qint32(m_written - (position + 1)) < 0 && isRunning())
+      {
+        m_wakeCondition.wakeOne();
+        m_flushCondition.wait(&m_mutex, 100);
+      }
+    }
+
+    //! Writes the remaining records and ends the thread
+    void stop()
+    {
+      m_isStopped.store(1);
+      wake();
+      wait();
+    }
+
+  protected:
+    void run()
+    {
+      static const int kBatchSize = 256;
+      QVector<LogRecord> batch;
+      batch.reserve(kBatchSize);
+      LogRecord record;
+
+      forever
+      {
+        while (batch.size() < kBatchSize && m_queue.dequeue(record))
+          batch.append(record);
+
+        if (batch.isEmpty())
+        {
+          QMutexLocker locker(&m_mutex);
+          if (m_isStopped.load())
+            break;
+          // Ordered so that a producer either sees the flag or its record is seen below.
+          m_isSleeping.fetchAndStoreOrdered(1);
+          // The timeout is a fallback for a lost wake-up.
+          if (m_queue.isEmpty())
+            m_wakeCondition.wait(&m_mutex, 100);
+          m_isSleeping.store(0);
+          continue;
+        }
+
+        foreach (const LogRecord& r, batch)
+        {
+          if (!r.isFlushMarker)
+            m_logger->writeToAppenders(r.timeStamp, r.logLevel, r.file.isNull() ? 0 : r.file.constData(), r.line,
+                                       r.function.isNull() ? 0 : r.function.constData(), r.category, r.message,
+                                       r.fromLocalInstance);
+        }
+        int dropped = m_dropped.fetchAndStoreRelaxed(0);
+        if (dropped > 0)
+          m_logger->writeToAppenders(QDateTime::currentDateTime(), Logger::Warning, __FILE__, __LINE__, Q_FUNC_INFO,
+                                     QString(),
+                                     QString(QLatin1String("%1 log records were discarded because the queue was full"))
+                                     .arg(dropped), false);
+
+        QMutexLocker locker(&m_mutex);
+        m_written += quint32(batch.size());
+        m_flushCondition.wakeAll();
+        locker.unlock();
+        batch.resize(0);
+      }
+    }
+
+  private:
+    void wake()
+    {
+      QMutexLocker locker(&m_mutex);
+      m_wakeCondition.wakeOne();
+    }
+
+    Logger* m_logger;
+    LogQueue m_queue;
+    Logger::OverflowPolicy m_overflowPolicy;
+    QAtomicInt m_isStopped;
+    QAtomicInt m_isSleeping;
+    QAtomicInt m_dropped;
+    quint32 m_written; // the records taken from the queue, guarded by m_mutex
+    QMutex m_mutex;
+    QWaitCondition m_wakeCondition;
+    QWaitCondition m_flushCondition;
+};
+
+
 // Forward declarations
 static void cleanupLoggerGlobalInstance();
 
@@ -512,7 +801,7 @@ static void qtLoggerMessageHandler(QtMsgType type, const char* msg);
 class LoggerPrivate
 {
   public:
-    static Logger* globalInstance;
+    static QAtomicPointer<Logger> globalInstance;
     static QReadWriteLock globalInstanceLock;
 
     QList<AbstractAppender*> appenders;
@@ -523,20 +812,25 @@ class LoggerPrivate
     QString defaultCategory;
 
     LogDevice* logDevice;
+    QAtomicPointer<LogWriter> writer;
 };
 
 
 // Static fields initialization
-Logger* LoggerPrivate::globalInstance = 0;
+QAtomicPointer<Logger> LoggerPrivate::globalInstance;
 QReadWriteLock LoggerPrivate::globalInstanceLock;
 
 
 static void cleanupLoggerGlobalInstance()
 {
+  // The background writer looks up the global instance, so drain it while the instance is still set
+  Logger* logger = LoggerPrivate::globalInstance.loadAcquire();
+  if (logger)
+    logger->setAsynchronous(false);
+
   QWriteLocker locker(&LoggerPrivate::globalInstanceLock);
 
-  delete LoggerPrivate::globalInstance;
-  LoggerPrivate::globalInstance = 0;
+  delete LoggerPrivate::globalInstance.fetchAndStoreOrdered(0);
 }
 
 
@@ -598,7 +892,9 @@ static void qtLoggerMessageHandler(QtMsgType type, const char* msg)
  * Consider using [logger](@ref logger) macro instead to access the logger instance
  */
 Logger::Logger()
-  : d_ptr(new LoggerPrivate)
+  : d_ptr(new LoggerPrivate),
+    m_minimumLevel(Trace),
+    m_tracing(0)
 {
   Q_D(Logger);
 
@@ -616,7 +912,9 @@ Logger::Logger()
  * \sa setDefaultCategory()
  */
 Logger::Logger(const QString& defaultCategory)
-  : d_ptr(new LoggerPrivate)
+  : d_ptr(new LoggerPrivate),
+    m_minimumLevel(Trace),
+    m_tracing(0)
 {
   Q_D(Logger);
   d->logDevice = new LogDevice(this);
@@ -634,6 +932,9 @@ Logger::~Logger()
 {
   Q_D(Logger);
 
+  // Write the queued records while the appenders still exist
+  delete d->writer.fetchAndStoreOrdered(0);
+
   // Cleanup appenders
   QMutexLocker appendersLocker(&d->loggerMutex);
   QSet<AbstractAppender*> deleteList(QSet<AbstractAppender*>::fromList(d->appenders));
@@ -718,16 +1019,17 @@ Logger::LogLevel Logger::levelFromString(const QString& s)
  */
 Logger* Logger::globalInstance()
 {
-  Logger* result = 0;
-  {
-    QReadLocker locker(&LoggerPrivate::globalInstanceLock);
-    result = LoggerPrivate::globalInstance;
-  }
+  // Every log statement gets here, so only the first call takes a lock
+  Logger* result = LoggerPrivate::globalInstance.loadAcquire();
+  if (result)
+    return result;
 
+  QWriteLocker locker(&LoggerPrivate::globalInstanceLock);
+  result = LoggerPrivate::globalInstance.loadAcquire();
   if (!result)
   {
-    QWriteLocker locker(&LoggerPrivate::globalInstanceLock);
-    LoggerPrivate::globalInstance = new Logger;
+    result = new Logger;
+    LoggerPrivate::globalInstance.storeRelease(result);
 
 #if QT_VERSION >= 0x050000
     qInstallMessageHandler(qtLoggerMessageHandler);
@@ -735,7 +1037,6 @@ Logger* Logger::globalInstance()
     qInstallMsgHandler(qtLoggerMessageHandler);
 #endif
     qAddPostRoutine(cleanupLoggerGlobalInstance);
-    result = LoggerPrivate::globalInstance;
   }
 
   return result;
@@ -906,9 +1207,50 @@ void Logger::write(const QDateTime& timeStamp, LogLevel logLevel, const char* fi
 {
   Q_D(Logger);
 
+  // Trace events are written as Logger::Debug records but only depend on setTracing()
+  if (!isEnabled(logLevel) && !(isTracing() && qstrcmp(category, traceCategory()) == 0))
+    return;
+
+  LogWriter* writer = d->writer.loadAcquire();
+  if (writer && QThread::currentThread() != writer)
+  {
+    if (logLevel == Logger::Fatal)
+    {
+      // Keep the order of the records and write the fatal one before aborting
+      writer->flush();
+    }
+    else
+    {
+      LogRecord record;
+      record.timeStamp = timeStamp;
+      record.logLevel = logLevel;
+      record.file = file;
+      record.line = line;
+      record.function = function;
+      record.category = QString::fromLatin1(category);
+      record.message = message;
+      record.fromLocalInstance = fromLocalInstance;
+      record.isFlushMarker = false;
+      if (writer->post(record))
+        return;
+    }
+  }
+
+  writeToAppenders(timeStamp, logLevel, file, line, function, QString::fromLatin1(category), message, fromLocalInstance);
+
+  if (logLevel == Logger::Fatal)
+    abort();
+}
+
+
+void Logger::writeToAppenders(const QDateTime& timeStamp, LogLevel logLevel, const char* file, int line, const char* function,
+                              const QString& category, const QString& message, bool fromLocalInstance)
+{
+  Q_D(Logger);
+
   QMutexLocker locker(&d->loggerMutex);
 
-  QString logCategory = QString::fromLatin1(category);
+  QString logCategory = category;
   if (logCategory.isNull() && !d->defaultCategory.isNull())
     logCategory = d->defaultCategory;
 
@@ -973,9 +1315,6 @@ void Logger::write(const QDateTime& timeStamp, LogLevel logLevel, const char* fi
     std::cerr << qPrintable(result) << std::endl;
 #endif
   }
-
-  if (logLevel == Logger::Fatal)
-    abort();
 }
 
 
@@ -1074,6 +1413,207 @@ void Logger::writeAssert(const char* file, int line, const char* function, const
 }
 
 
+//! Sets the lowest level of the log records to write
+/**
+ * Records below the level are discarded. The logging macros check the level before the message is formatted, so a
+ * disabled statement costs about as much as reading an integer; note that its arguments are not evaluated. To remove
+ * the statements below a level from the program entirely, define \c CUTELOGGER_MIN_LEVEL to that level when
+ * compiling the code that logs. Logger::Fatal records are always written.
+ *
+ * \sa minimumLevel()
+ * \sa isEnabled()
+ */
+void Logger::setMinimumLevel(LogLevel level)
+{
+  m_minimumLevel.store(qMin(int(level), int(Fatal)));
+}
+
+
+//! Returns the lowest level of the log records to write
+/**
+ * \sa setMinimumLevel()
+ */
+Logger::LogLevel Logger::minimumLevel() const
+{
+  return LogLevel(m_minimumLevel.load());
+}
+
+
+//! Switches between writing the log records in the calling thread and in a background thread
+/**
+ * In the asynchronous mode, write() puts the record in a bounded lock-free queue and returns without touching the
+ * appenders. It only takes a lock when it is the first to queue a record after the writer went idle, to wake it up. A
+ * single background thread takes the records from the queue in batches and writes them to the appenders, so a thread
+ * that logs never waits for a slow appender such as a file on a busy disk.
+ *
+ * A Logger::Fatal record first waits for the queued records to be written and is then written synchronously before
+ * the application aborts. The queued records are also written by flush(), when the asynchronous mode is switched off
+ * and when the Logger is destroyed.
+ *
+ * \param asynchronous Whether to write in a background thread
+ * \param queueSize The number of records the queue holds, rounded up to a power of two
+ * \param overflowPolicy What to do with a record when the queue is full
+ *
+ * \note Switch the mode while no other thread is logging, usually right after registering the appenders.
+ *
+ * \sa flush()
+ * \sa OverflowPolicy
+ */
+void Logger::setAsynchronous(bool asynchronous, int queueSize, OverflowPolicy overflowPolicy)
+{
+  Q_D(Logger);
+
+  delete d->writer.fetchAndStoreOrdered(0);
+  if (asynchronous)
+  {
+    int size = 2;
+    while (size < queueSize && size < (1 << 20))
+      size <<= 1;
+    LogWriter* writer = new LogWriter(this, size, overflowPolicy);
+    writer->start();
+    d->writer.storeRelease(writer);
+  }
+}
+
+
+//! Returns whether the log records are written in a background thread
+/**
+ * \sa setAsynchronous()
+ */
+bool Logger::isAsynchronous() const
+{
+  Q_D(const Logger);
+  return d->writer.loadAcquire() != 0;
+}
+
+
+//! Waits until the log records written so far reach the appenders
+/**
+ * Call this before terminating the application without destroying the Logger, for example with \c _Exit().
+ * It returns immediately if the Logger is not asynchronous.
+ *
+ * \sa setAsynchronous()
+ */
+void Logger::flush()
+{
+  Q_D(Logger);
+
+  LogWriter* writer = d->writer.loadAcquire();
+  if (writer && QThread::currentThread() != writer)
+    writer->flush();
+}
+
+
+//! Switches writing trace events on or off
+/**
+ * Trace events describe where the time goes in the application in the Trace Event Format understood by trace
+ * viewers such as chrome://tracing. Each event is written as a Logger::Debug record of the traceCategory(), whose
+ * message is one compact JSON object with the phase ("ph"), name, timestamp in microseconds ("ts"), a small
+ * sequential thread number ("tid") and the optional duration ("dur"), id and typed arguments ("args"). The first
+ * event of a thread is preceded by a metadata event naming the thread. Trace events are written whatever the
+ * minimumLevel().
+ *
+ * Tracing is off by default. Register an appender for the traceCategory() before switching it on; LOG_SPAN costs a
+ * single atomic load while it is off.
+ *
+ * \sa isTracing()
+ * \sa writeTraceEvent()
+ * \sa LOG_SPAN
+ */
+void Logger::setTracing(bool tracing)
+{
+  m_tracing.store(tracing);
+}
+
+
+//! Returns the category of the trace event records
+/**
+ * \sa setTracing()
+ */
+const char* Logger::traceCategory()
+{
+  return "trace";
+}
+
+
+//! Returns the monotonic time in microseconds used for the trace event timestamps
+/**
+ * The clock starts the first time this is called and is not affected by changes of the system time.
+ *
+ * \sa writeTraceEvent()
+ */
+qint64 Logger::traceTimestamp()
+{
+  struct TraceClock
+  {
+    TraceClock() { timer.start(); }
+    QElapsedTimer timer;
+  };
+  static TraceClock clock;
+  return clock.timer.nsecsElapsed() / 1000;
+}
+
+
+//! Writes a trace event if tracing is on
+/**
+ * \param phase The event type: 'X' for a span with a duration, 'b' and 'e' for the begin and end of an
+ *              asynchronous span such as a job, or 'i' for an instant
+ * \param name The name of the event
+ * \param timestamp The time of the event, from traceTimestamp()
+ * \param duration The duration in microseconds of an 'X' event
+ * \param id The id that pairs the begin and end of an asynchronous span
+ * \param args Typed values describing the event
+ *
+ * \sa setTracing()
+ */
+void Logger::writeTraceEvent(char phase, const char* name, qint64 timestamp, qint64 duration, quint64 id,
+                             const QVariantMap& args)
+{
+  if (!isTracing())
+    return;
+
+  static QThreadStorage<int> threadIds;
+  if (!threadIds.hasLocalData())
+  {
+    static QAtomicInt lastThreadId;
+    threadIds.setLocalData(lastThreadId.fetchAndAddRelaxed(1) + 1);
+
+    QThread* thread = QThread::currentThread();
+    QString threadName = thread->objectName();
+    if (threadName.isEmpty())
+    {
+      if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+        threadName = QLatin1String("main");
+      else
+        threadName = QString(QLatin1String("thread %1")).arg(threadIds.localData());
+    }
+    QJsonObject threadArgs;
+    threadArgs.insert(QLatin1String("name"), threadName);
+    QJsonObject metadata;
+    metadata.insert(QLatin1String("ph"), QLatin1String("M"));
+    metadata.insert(QLatin1String("name"), QLatin1String("thread_name"));
+    metadata.insert(QLatin1String("ts"), double(timestamp));
+    metadata.insert(QLatin1String("tid"), threadIds.localData());
+    metadata.insert(QLatin1String("args"), threadArgs);
+    write(Debug, 0, 0, "thread_name", traceCategory(),
+          QString::fromUtf8(QJsonDocument(metadata).toJson(QJsonDocument::Compact)));
+  }
+
+  QJsonObject event;
+  event.insert(QLatin1String("ph"), QString(QLatin1Char(phase)));
+  event.insert(QLatin1String("name"), QString::fromUtf8(name));
+  event.insert(QLatin1String("ts"), double(timestamp));
+  if (phase == 'X')
+    event.insert(QLatin1String("dur"), double(duration));
+  if (id)
+    event.insert(QLatin1String("id"), QString(QLatin1String("0x%1")).arg(id, 0, 16));
+  event.insert(QLatin1String("tid"), threadIds.localData());
+  if (!args.isEmpty())
+    event.insert(QLatin1String("args"), QJsonObject::fromVariantMap(args));
+  write(Debug, 0, 0, name, traceCategory(), QString::fromUtf8(QJsonDocument(event).toJson(QJsonDocument::Compact)));
+}
+
+
 Logger* cuteLoggerInstance()
 {
   return Logger::globalInstance();
@@ -1144,3 +1684,24 @@ QDebug CuteMessageLogger::write() const
 {
   return m_l->write(m_level, m_file, m_line, m_function, m_category);
 }
+
+
+//! Adds a typed value to the trace event of the span
+/**
+ * Values are only kept while tracing is on; use isActive() to skip computing them otherwise.
+ */
+void LoggerSpan::setArgument(const QString& key, const QVariant& value)
+{
+  if (isActive())
+    m_args.insert(key, value);
+}
+
+
+LoggerSpan::~LoggerSpan()
+{
+  if (isActive())
+  {
+    qint64 end = Logger::traceTimestamp();
+    m_logger->writeTraceEvent('X', m_name, m_start, end - m_start, 0, m_args);
+  }
+}
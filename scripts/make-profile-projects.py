@@ -0,0 +1,166 @@
+#! /usr/bin/env python
+
+"""
+make-profile-projects.py
+
+Generates synthetic Shotcut projects of N tracks by M clips by F filters for
+measuring how the time to open a project scales:
+
+  python make-profile-projects.py [-o DIR] [-m MEDIA] [-t N,...] [-c M,...] [-f F,...]
+  for p in DIR/*.mlt; do shotcut --profile-open "$p"; done
+
+Without a media file, the clips are color producers, which exercise the XML
+check, MLT and the timeline model without any file I/O. With one, each clip
+is a cut of that file, so the waveforms are computed as well.
+
+Copyright (c) 2019 Meltytech, LLC
+License: GPL version 3 or later
+"""
+
+import sys
+import os
+import getopt
+from xml.sax.saxutils import escape, quoteattr
+
+FILTERS = [
+    ('brightness', [('level', '1')]),
+    ('volume', [('gain', '1'), ('window', '75'), ('max_gain', '20dB')]),
+    ('frei0r.sharpness', [('Amount', '0.5'), ('Size', '0.5')]),
+    ('affine', [('transition.rect', '0/0:100%x100%'), ('transition.fill', '1')]),
+    ('avfilter.hue', [('av.h', '0'), ('av.s', '1')]),
+]
+
+CLIP_FRAMES = 125
+
+
+def err(msg):
+  sys.stderr.write("%s\n" % msg)
+
+
+def usage(err_msg=None):
+  if err_msg is not None:
+    err("\n** ERROR **: %s\n" % err_msg)
+  progname = os.path.basename(sys.argv[0])
+  err("usage: python %s [-o dir] [-m media] [-t tracks,...] [-c clips,...] [-f filters,...]" % progname)
+  sys.exit(1)
+
+
+def prop(name, value):
+  return '    <property name=%s>%s</property>\n' % (quoteattr(name), escape(value))
+
+
+def filter_xml(index):
+  service, props = FILTERS[index % len(FILTERS)]
+  xml = '   <filter>\n'
+  xml += prop('mlt_service', service)
+  xml += prop('shotcut:filter', service)
+  for name, value in props:
+    xml += prop(name, value)
+  xml += '   </filter>\n'
+  return xml
+
+
+def make_project(tracks, clips, filters, media):
+  out = CLIP_FRAMES - 1
+  xml = '<?xml version="1.0" encoding="utf-8"?>\n'
+  xml += '<mlt LC_NUMERIC="C" version="6.14.0" title="Shotcut profile project" producer="main_bin">\n'
+  xml += ' <profile description="HD 1080p 25 fps" width="1920" height="1080" progressive="1"' \
+         ' sample_aspect_num="1" sample_aspect_den="1" display_aspect_num="16" display_aspect_den="9"' \
+         ' frame_rate_num="25" frame_rate_den="1" colorspace="709"/>\n'
+  xml += ' <playlist id="main_bin">\n'
+  xml += prop('xml_retain', '1')
+  xml += ' </playlist>\n'
+  xml += ' <producer id="black" in="0" out="%d">\n' % (clips * CLIP_FRAMES - 1)
+  xml += prop('length', str(clips * CLIP_FRAMES))
+  xml += prop('eof', 'pause')
+  xml += prop('resource', 'black')
+  xml += prop('mlt_service', 'color')
+  xml += ' </producer>\n'
+  xml += ' <playlist id="background">\n'
+  xml += '  <entry producer="black" in="0" out="%d"/>\n' % (clips * CLIP_FRAMES - 1)
+  xml += ' </playlist>\n'
+  for t in range(tracks):
+    for c in range(clips):
+      xml += ' <producer id="producer%d_%d" in="0" out="%d">\n' % (t, c, out)
+      if media:
+        xml += prop('resource', media)
+        xml += prop('mlt_service', 'avformat-novalidate')
+        xml += prop('audio_index', '1')
+      else:
+        xml += prop('length', str(CLIP_FRAMES))
+        xml += prop('resource', '#%02x%02x%02xff' % ((t * 40) % 256, (c * 7) % 256, 128))
+        xml += prop('mlt_service', 'color')
+        xml += prop('audio_index', '-1')
+      xml += prop('shotcut:caption', 'clip %d.%d' % (t + 1, c + 1))
+      for f in range(filters):
+        xml += filter_xml(t + c + f)
+      xml += ' </producer>\n'
+    xml += ' <playlist id="playlist%d">\n' % t
+    xml += prop('shotcut:video', '1')
+    xml += prop('shotcut:name', 'V%d' % (t + 1))
+    for c in range(clips):
+      xml += '  <entry producer="producer%d_%d" in="0" out="%d"/>\n' % (t, c, out)
+    xml += ' </playlist>\n'
+  xml += ' <tractor id="tractor0" title="Shotcut profile project" global_feed="1" in="0" out="%d">\n' \
+         % (clips * CLIP_FRAMES - 1)
+  xml += prop('shotcut', '1')
+  xml += '  <track producer="background"/>\n'
+  for t in range(tracks):
+    xml += '  <track producer="playlist%d"/>\n' % t
+  for t in range(tracks):
+    xml += '  <transition id="mix%d">\n' % t
+    xml += prop('a_track', '0')
+    xml += prop('b_track', str(t + 1))
+    xml += prop('mlt_service', 'mix')
+    xml += prop('always_active', '1')
+    xml += prop('sum', '1')
+    xml += '  </transition>\n'
+    if t > 0:
+      xml += '  <transition id="composite%d">\n' % t
+      xml += prop('a_track', '0')
+      xml += prop('b_track', str(t + 1))
+      xml += prop('version', '0.9')
+      xml += prop('mlt_service', 'frei0r.cairoblend')
+      xml += prop('disable', '0')
+      xml += '  </transition>\n'
+  xml += ' </tractor>\n'
+  xml += '</mlt>\n'
+  return xml
+
+
+def main():
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], 'o:m:t:c:f:h')
+  except getopt.GetoptError as e:
+    usage(str(e))
+  outdir = 'profile-projects'
+  media = None
+  tracks = [1, 4, 16]
+  clips = [10, 100, 500]
+  filters = [0, 2, 8]
+  for o, a in opts:
+    if o == '-o':
+      outdir = a
+    elif o == '-m':
+      media = os.path.abspath(a)
+    elif o == '-t':
+      tracks = [int(x) for x in a.split(',')]
+    elif o == '-c':
+      clips = [int(x) for x in a.split(',')]
+    elif o == '-f':
+      filters = [int(x) for x in a.split(',')]
+    else:
+      usage()
+  if not os.path.isdir(outdir):
+    os.makedirs(outdir)
+  for n in tracks:
+    for m in clips:
+      for f in filters:
+        name = os.path.join(outdir, 'profile-%dt-%dc-%df.mlt' % (n, m, f))
+        with open(name, 'w') as out:
+          out.write(make_project(n, m, f, media))
+        print(name)
+
+
+if __name__ == '__main__':
+  main()
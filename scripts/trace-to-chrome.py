@@ -0,0 +1,99 @@
+#! /usr/bin/env python
+
+"""
+trace-to-chrome.py
+
+Converts the shotcut-trace.jsonl written by shotcut --trace to the Chrome
+trace event format, which chrome://tracing, Perfetto and other trace viewers
+open:
+
+  python trace-to-chrome.py [-o OUTPUT] shotcut-trace.jsonl
+
+The trace events are copied as they are. Each log record becomes an instant
+event on a separate "log" row with the message and source location as its
+arguments, so that warnings appear next to the spans around them. The log
+records have millisecond timestamps.
+
+Copyright (c) 2019 Meltytech, LLC
+License: GPL version 3 or later
+"""
+
+import sys
+import os
+import getopt
+import json
+
+PID = 1
+LOG_TID = 0
+
+
+def err(msg):
+  sys.stderr.write("%s\n" % msg)
+
+
+def usage(err_msg=None):
+  if err_msg is not None:
+    err("\n** ERROR **: %s\n" % err_msg)
+  progname = os.path.basename(sys.argv[0])
+  err("usage: python %s [-o output.json] shotcut-trace.jsonl" % progname)
+  sys.exit(1)
+
+
+def log_event(record):
+  args = {'level': record.get('level', '')}
+  for key in ('cat', 'func', 'file', 'line'):
+    if key in record:
+      args[key] = record[key]
+  args['msg'] = record.get('msg', '')
+  name = record.get('msg', '').strip().split('\n')[0][:80]
+  return {'ph': 'i', 's': 't', 'name': name or args['level'], 'ts': record.get('ts', 0),
+          'pid': PID, 'tid': LOG_TID, 'args': args}
+
+
+def convert(lines):
+  events = [
+    {'ph': 'M', 'name': 'process_name', 'pid': PID, 'tid': LOG_TID, 'args': {'name': 'Shotcut'}},
+    {'ph': 'M', 'name': 'thread_name', 'pid': PID, 'tid': LOG_TID, 'args': {'name': 'log'}},
+  ]
+  for number, line in enumerate(lines, 1):
+    line = line.strip()
+    if not line:
+      continue
+    try:
+      record = json.loads(line)
+    except ValueError:
+      # The last line is cut short if Shotcut crashed while writing it.
+      err("skipping line %d: not JSON" % number)
+      continue
+    if 'ph' in record:
+      record['pid'] = PID
+      events.append(record)
+    else:
+      events.append(log_event(record))
+  return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+
+def main():
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], 'o:h')
+  except getopt.GetoptError as e:
+    usage(str(e))
+  output = None
+  for o, a in opts:
+    if o == '-o':
+      output = a
+    else:
+      usage()
+  if len(args) != 1:
+    usage('expected one trace file')
+  if output is None:
+    output = os.path.splitext(args[0])[0] + '.json'
+  with open(args[0]) as f:
+    trace = convert(f)
+  with open(output, 'w') as out:
+    json.dump(trace, out)
+  print(output)
+
+
+if __name__ == '__main__':
+  main()
@@ -184,7 +184,6 @@ SortCommand::SortCommand(PlaylistModel& model, int column, Qt::SortOrder order,
     , m_column(column)
     , m_order(order)
 {
-    m_xml = MLT.XML(m_model.playlist());
     QString columnName = m_model.headerData(m_column, Qt::Horizontal, Qt::DisplayRole).toString();
     setText(QObject::tr("Sort playlist by %1").arg(columnName));
 }
@@ -192,23 +191,19 @@ SortCommand::SortCommand(PlaylistModel& model, int column, Qt::SortOrder order,
 void SortCommand::redo()
 {
     LOG_DEBUG() << m_column;
-    m_model.sort(m_column, m_order);
+    if (m_rows.isEmpty())
+        m_rows = m_model.sortedRows(m_column, m_order);
+    m_model.reorder(m_rows);
 }
 
 void SortCommand::undo()
 {
     LOG_DEBUG() << "";
-    Mlt::Producer* producer = new Mlt::Producer(MLT.profile(), "xml-string", m_xml.toUtf8().constData());
-    if (producer->is_valid()) {
-        producer->set("resource", "<playlist>");
-        if (!MLT.setProducer(producer)) {
-            m_model.load();
-            MLT.pause();
-            MAIN.seekPlaylist(0);
-        }
-    } else {
-        LOG_ERROR() << "failed to restore playlist from XML";
-    }
+    // Put each row back where it was before sorting.
+    QVector<int> rows(m_rows.size());
+    for (int i = 0; i < m_rows.size(); ++i)
+        rows[m_rows[i]] = i;
+    m_model.reorder(rows);
 }
 
 TrimClipInCommand::TrimClipInCommand(PlaylistModel& model, int row, int in, QUndoCommand *parent)
@@ -116,7 +116,7 @@ private:
     PlaylistModel& m_model;
     int m_column;
     Qt::SortOrder m_order;
-    QString m_xml;
+    QVector<int> m_rows;
 };
 
 class TrimClipInCommand : public QUndoCommand
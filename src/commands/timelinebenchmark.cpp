@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timelinebenchmark.h"
+#include "timelinecommands.h"
+#include "mltcontroller.h"
+#include <Logger.h>
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <cstdio>
+
+namespace Timeline
+{
+
+static const int kClipLength = 50;
+
+enum Operation {
+    OverwriteOperation,
+    InsertOperation,
+    MoveOperation,
+    TrimInOperation,
+    TrimOutOperation,
+    SplitOperation,
+    AddTransitionOperation,
+    RemoveOperation,
+    OperationCount
+};
+
+static const char* operationNames[] = {
+    "overwrite", "insert", "move", "trim in", "trim out", "split", "add transition", "remove"
+};
+
+static void printLine(const QString& line)
+{
+    printf("%s\n", line.toLocal8Bit().constData());
+    LOG_INFO() << line;
+}
+
+static int clipCount(MultitrackModel& model, int trackIndex)
+{
+    return model.rowCount(model.index(trackIndex));
+}
+
+/// Returns a command for an edit in the middle of track 0, or 0 if the
+/// model rejects the edit.
+static QUndoCommand* newCommand(Operation operation, MultitrackModel& model, const QString& xml)
+{
+    int clipIndex = clipCount(model, 0) / 2;
+    int position = model.data(model.index(clipIndex, 0, model.index(0)), MultitrackModel::StartRole).toInt();
+    int delta = kClipLength / 5;
+
+    switch (operation) {
+    case OverwriteOperation:
+        return new OverwriteCommand(model, 0, position + kClipLength / 2, xml, false);
+    case InsertOperation:
+        return new InsertCommand(model, 0, position, xml, false);
+    case MoveOperation:
+        if (!model.moveClipValid(0, 0, clipIndex, position + kClipLength / 2, false))
+            return 0;
+        return new MoveClipCommand(model, 0, 0, clipIndex, position + kClipLength / 2, false);
+    case TrimInOperation:
+        if (!model.trimClipInValid(0, clipIndex, delta, false))
+            return 0;
+        return new TrimClipInCommand(model, 0, clipIndex, delta, false);
+    case TrimOutOperation:
+        if (!model.trimClipOutValid(0, clipIndex, delta, false))
+            return 0;
+        return new TrimClipOutCommand(model, 0, clipIndex, delta, false);
+    case SplitOperation:
+        return new SplitCommand(model, 0, clipIndex, position + kClipLength / 2);
+    case AddTransitionOperation:
+        if (!model.addTransitionValid(0, 0, clipIndex, position - delta))
+            return 0;
+        return new AddTransitionCommand(model, 0, clipIndex, position - delta, false);
+    case RemoveOperation:
+        // With ripple all tracks, this also removes a region from track 1.
+        return new RemoveCommand(model, 0, clipIndex, xml);
+    default:
+        return 0;
+    }
+}
+
+/// Times iterations of redo and undo, each undo restoring the timeline for
+/// the next iteration. Returns false if an undo did not restore the timeline.
+static bool measure(Operation operation, MultitrackModel& model, int clips, int iterations, const QString& xml)
+{
+    int count = clipCount(model, 0);
+    qint64 redoTime = 0;
+    qint64 undoTime = 0;
+    QElapsedTimer timer;
+    for (int i = 0; i < iterations; ++i) {
+        QScopedPointer<QUndoCommand> command(newCommand(operation, model, xml));
+        if (!command) {
+            LOG_WARNING() << operationNames[operation] << "is not valid at" << clips << "clips";
+            return false;
+        }
+        timer.start();
+        command->redo();
+        redoTime += timer.nsecsElapsed();
+        timer.start();
+        command->undo();
+        undoTime += timer.nsecsElapsed();
+        if (clipCount(model, 0) != count) {
+            LOG_WARNING() << operationNames[operation] << "undo changed the number of clips from"
+                          << count << "to" << clipCount(model, 0);
+            return false;
+        }
+    }
+    printLine(QString("%1,%2,%3,%4,%5").arg(operationNames[operation]).arg(clips).arg(iterations)
+              .arg(redoTime / 1000.0 / iterations, 0, 'f', 1)
+              .arg(undoTime / 1000.0 / iterations, 0, 'f', 1));
+    return true;
+}
+
+int benchmark()
+{
+    static const int sizes[] = { 10, 100, 1000, 10000 };
+    int failures = 0;
+
+    Mlt::Producer clip(MLT.profile(), "color:#ff808080");
+    clip.set("length", kClipLength);
+    clip.set_in_and_out(0, kClipLength - 1);
+    QString xml = MLT.XML(&clip);
+
+    printLine("operation,clips,iterations,redo_us,undo_us");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        int clips = sizes[s];
+        MultitrackModel model;
+        // Ripple all tracks so that the edits also go through the multitrack paths.
+        model.setRippleAllTracksForced(true);
+        model.createIfNeeded();
+        model.addVideoTrack();
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int track = 0; track < 2; ++track) {
+            for (int i = 0; i < clips; ++i)
+                model.appendClip(track, clip);
+        }
+        printLine(QString("append,%1,%2,%3,").arg(clips).arg(2 * clips)
+                  .arg(timer.nsecsElapsed() / 1000.0 / (2 * clips), 0, 'f', 1));
+
+        int iterations = qBound(3, 1000 / clips, 100);
+        for (int op = 0; op < OperationCount; ++op) {
+            if (!measure(Operation(op), model, clips, iterations, xml)) {
+                printLine(QString("%1,%2,0,,").arg(operationNames[op]).arg(clips));
+                ++failures;
+            }
+        }
+        model.close();
+    }
+    fflush(stdout);
+    return failures;
+}
+
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMELINEBENCHMARK_H
+#define TIMELINEBENCHMARK_H
+
+namespace Timeline
+{
+
+/// Times the redo and undo of the timeline edit commands on synthetic
+/// timelines of 10 to 10,000 color clips per track and prints the results
+/// as CSV. It needs MLT and the main window, but no media or project.
+/// Returns the number of edits that did not undo cleanly.
+int benchmark();
+
+}
+
+#endif // TIMELINEBENCHMARK_H
@@ -22,8 +22,14 @@
 #include <Logger.h>
 #include <QQmlComponent>
 #include <QTimerEvent>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QTime>
 #include "mltcontroller.h"
 #include "settings.h"
+#include "startuptimer.h"
 #include "qmltypes/qmlmetadata.h"
 #include "qmltypes/qmlutilities.h"
 #include "qmltypes/qmlfilter.h"
@@ -42,10 +48,75 @@ FilterController::FilterController(QObject* parent) : QObject(parent),
     connect(&m_attachedModel, SIGNAL(duplicateAddFailed(int)), this, SLOT(handleAttachDuplicateFailed(int)));
 }
 
+// Increment this when the format of the metadata cache changes.
+static const qint32 kMetadataCacheVersion = 1;
+static const quint32 kMetadataCacheMagic = 0x53434d44; // "SCMD"
+
+static QString metadataCachePath()
+{
+    return QDir(Settings.appDataLocation()).filePath("filter-metadata.cache");
+}
+
 void FilterController::loadFilterMetadata() {
     QScopedPointer<Mlt::Properties> mltFilters(MLT.repository()->filters());
     QDir dir = QmlUtilities::qmlDir();
     dir.cd("filters");
+    QTime time;
+    time.start();
+
+    QByteArray signature = metadataSignature(dir, *mltFilters);
+    QList<QPair<QString, QmlMetadata*> > metadata;
+    bool isCached = readMetadataCache(signature, metadata);
+    if (!isCached) {
+        metadata = parseMetadata(dir, *mltFilters);
+        writeMetadataCache(signature, metadata);
+    }
+
+    for (int i = 0; i < metadata.size(); i++) {
+        QmlMetadata* meta = metadata.at(i).second;
+        // Check if mlt_service is available.
+        if (mltFilters->get_data(meta->mlt_service().toLatin1().constData())) {
+            QDir subdir = dir;
+            subdir.cd(metadata.at(i).first);
+            meta->loadSettings();
+            meta->setPath(subdir);
+            meta->setParent(0);
+            addMetadata(meta);
+        } else {
+            delete meta;
+        }
+    }
+    LOG_INFO() << "loaded" << m_metadataModel.rowCount() << "filters"
+               << (isCached? "from cache" : "from QML") << "in" << time.elapsed() << "ms";
+    StartupTimer::add("filter metadata", time.elapsed());
+}
+
+QByteArray FilterController::metadataSignature(const QDir& dir, Mlt::Properties& mltFilters)
+{
+    // The cache is valid as long as the metadata files, the language of
+    // their translated strings, the MLT version and its filters are unchanged.
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(dir.absolutePath().toUtf8());
+    hash.addData(Settings.language().toUtf8());
+    hash.addData(mlt_version_get_string());
+    for (int i = 0; i < mltFilters.count(); i++)
+        hash.addData(mltFilters.get_name(i));
+    foreach (QString dirName, dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot | QDir::Executable)) {
+        QDir subdir = dir;
+        subdir.cd(dirName);
+        subdir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::Readable);
+        subdir.setNameFilters(QStringList("meta*.qml"));
+        foreach (QFileInfo info, subdir.entryInfoList()) {
+            hash.addData(QString("%1/%2 %3 %4").arg(dirName).arg(info.fileName())
+                         .arg(info.lastModified().toMSecsSinceEpoch()).arg(info.size()).toUtf8());
+        }
+    }
+    return hash.result();
+}
+
+QList<QPair<QString, QmlMetadata*> > FilterController::parseMetadata(const QDir& dir, Mlt::Properties& mltFilters)
+{
+    QList<QPair<QString, QmlMetadata*> > result;
     foreach (QString dirName, dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot | QDir::Executable)) {
         QDir subdir = dir;
         subdir.cd(dirName);
@@ -56,33 +127,83 @@ void FilterController::loadFilterMetadata() {
             QQmlComponent component(QmlUtilities::sharedEngine(), subdir.absoluteFilePath(fileName));
             QmlMetadata *meta = qobject_cast<QmlMetadata*>(component.create());
             if (meta) {
-                // Check if mlt_service is available.
-                if (mltFilters->get_data(meta->mlt_service().toLatin1().constData())) {
-                    LOG_DEBUG() << "added filter" << meta->name();
-                    meta->loadSettings();
-                    meta->setPath(subdir);
-                    meta->setParent(0);
-                    addMetadata(meta);
-
-                    // Check if a keyframes minimum version is required.
-                    QScopedPointer<Mlt::Properties> mltMetadata(MLT.repository()->metadata(filter_type, meta->mlt_service().toLatin1().constData()));
-                    if (mltMetadata && mltMetadata->is_valid() && mltMetadata->get("version") && meta->keyframes()) {
-                        QString version = QString::fromLatin1(mltMetadata->get("version"));
-                        if (version.startsWith("lavfi"))
-                            version.remove(0, 5);
-                        meta->keyframes()->checkVersion(version);
-                        // MLT frei0r module did get mlt_animation support until v6.10 (6.9 while in development).
-                        if (meta->mlt_service().startsWith("frei0r.")) {
-                            if (mlt_version_get_major() < 6 || mlt_version_get_minor() < 9)
-                                meta->keyframes()->setDisabled();
-                        }
+                meta->setParent(0);
+                result << qMakePair(dirName, meta);
+                if (!mltFilters.get_data(meta->mlt_service().toLatin1().constData()))
+                    continue;
+                LOG_DEBUG() << "added filter" << meta->name();
+
+                // Check if a keyframes minimum version is required.
+                QScopedPointer<Mlt::Properties> mltMetadata(MLT.repository()->metadata(filter_type, meta->mlt_service().toLatin1().constData()));
+                if (mltMetadata && mltMetadata->is_valid() && mltMetadata->get("version") && meta->keyframes()) {
+                    QString version = QString::fromLatin1(mltMetadata->get("version"));
+                    if (version.startsWith("lavfi"))
+                        version.remove(0, 5);
+                    meta->keyframes()->checkVersion(version);
+                    // MLT frei0r module did get mlt_animation support until v6.10 (6.9 while in development).
+                    if (meta->mlt_service().startsWith("frei0r.")) {
+                        if (mlt_version_get_major() < 6 || mlt_version_get_minor() < 9)
+                            meta->keyframes()->setDisabled();
                     }
                 }
-            } else if (!meta) {
+            } else {
                 LOG_WARNING() << component.errorString();
             }
         }
-    };
+    }
+    return result;
+}
+
+bool FilterController::readMetadataCache(const QByteArray& signature, QList<QPair<QString, QmlMetadata*> >& metadata)
+{
+    QFile file(metadataCachePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    qint32 version = 0;
+    QByteArray cachedSignature;
+    qint32 count = 0;
+    stream >> magic >> version >> cachedSignature >> count;
+    if (magic != kMetadataCacheMagic || version != kMetadataCacheVersion
+            || cachedSignature != signature || stream.status() != QDataStream::Ok)
+        return false;
+    for (int i = 0; i < count; i++) {
+        QString dirName;
+        stream >> dirName;
+        QmlMetadata* meta = new QmlMetadata;
+        meta->deserialize(stream);
+        metadata << qMakePair(dirName, meta);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        LOG_WARNING() << "the filter metadata cache is corrupt";
+        for (int i = 0; i < metadata.size(); i++)
+            delete metadata.at(i).second;
+        metadata.clear();
+        return false;
+    }
+    return true;
+}
+
+void FilterController::writeMetadataCache(const QByteArray& signature, const QList<QPair<QString, QmlMetadata*> >& metadata)
+{
+    QDir dir(Settings.appDataLocation());
+    if (!dir.exists())
+        dir.mkpath(dir.path());
+    QSaveFile file(metadataCachePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_WARNING() << "failed to write" << file.fileName();
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << kMetadataCacheMagic << kMetadataCacheVersion << signature << qint32(metadata.size());
+    for (int i = 0; i < metadata.size(); i++) {
+        stream << metadata.at(i).first;
+        metadata.at(i).second->serialize(stream);
+    }
+    file.commit();
 }
 
 QmlMetadata *FilterController::metadataForService(Mlt::Service *service)
@@ -70,6 +70,10 @@ private slots:
 
 private:
     void loadFilterMetadata();
+    QByteArray metadataSignature(const QDir& dir, Mlt::Properties& mltFilters);
+    QList<QPair<QString, QmlMetadata*> > parseMetadata(const QDir& dir, Mlt::Properties& mltFilters);
+    bool readMetadataCache(const QByteArray& signature, QList<QPair<QString, QmlMetadata*> >& metadata);
+    void writeMetadataCache(const QByteArray& signature, const QList<QPair<QString, QmlMetadata*> >& metadata);
 
     QFuture<void> m_future;
     QScopedPointer<QmlFilter> m_currentFilter;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2016 Meltytech, LLC
+ * Copyright (c) 2015-2019 Meltytech, LLC
  * Author: Brian Matherly <code@brianmatherly.com>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -16,11 +16,14 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "scopecontroller.h"
+#include "widgets/scopes/audioanalysis.h"
 #include "widgets/scopes/audioloudnessscopewidget.h"
 #include "widgets/scopes/audiopeakmeterscopewidget.h"
 #include "widgets/scopes/audiospectrumscopewidget.h"
 #include "widgets/scopes/audiowaveformscopewidget.h"
 #include "widgets/scopes/videohistogramscopewidget.h"
+#include "widgets/scopes/videorgbparadescopewidget.h"
+#include "widgets/scopes/videovectorscopewidget.h"
 #include "widgets/scopes/videowaveformscopewidget.h"
 #include "docks/scopedock.h"
 #include "settings.h"
@@ -30,24 +33,71 @@
 
 ScopeController::ScopeController(QMainWindow* mainWindow, QMenu* menu)
   : QObject(mainWindow)
+  , m_visibleVideoScopes(0)
+  , m_visibleAudioScopes(0)
 {
     LOG_DEBUG() << "begin";
+    connect(&AudioAnalysis::singleton(), SIGNAL(frameAnalyzed(const SharedFrame&)),
+            SIGNAL(newAudioFrame(const SharedFrame&)));
     QMenu* scopeMenu = menu->addMenu(tr("Scopes"));
-    createScopeDock<AudioLoudnessScopeWidget>(mainWindow, scopeMenu);
-    createScopeDock<AudioPeakMeterScopeWidget>(mainWindow, scopeMenu);
-    createScopeDock<AudioSpectrumScopeWidget>(mainWindow, scopeMenu);
-    createScopeDock<AudioWaveformScopeWidget>(mainWindow, scopeMenu);
-    if (!Settings.playerGPU()) {
-        createScopeDock<VideoHistogramScopeWidget>(mainWindow, scopeMenu);
-        createScopeDock<VideoWaveformScopeWidget>(mainWindow, scopeMenu);
-    }
+    // The scopes are constructed when first shown, so the docks are given their
+    // names and titles up front for the menu and the saved window state.
+    createScopeDock<AudioLoudnessScopeWidget>(mainWindow, scopeMenu, "AudioLoudnessMeter",
+        AudioLoudnessScopeWidget::tr("Audio Loudness"), false);
+    createScopeDock<AudioPeakMeterScopeWidget>(mainWindow, scopeMenu, "AudioPeakMeter",
+        AudioPeakMeterScopeWidget::tr("Audio Peak Meter"), false);
+    createScopeDock<AudioSpectrumScopeWidget>(mainWindow, scopeMenu, "AudioSpectrum",
+        AudioSpectrumScopeWidget::tr("Audio Spectrum"), false);
+    createScopeDock<AudioWaveformScopeWidget>(mainWindow, scopeMenu, "AudioWaveform",
+        AudioWaveformScopeWidget::tr("Audio Waveform"), false);
+    createScopeDock<VideoHistogramScopeWidget>(mainWindow, scopeMenu, "VideoHistogram",
+        VideoHistogramScopeWidget::tr("Video Histogram"), true);
+    createScopeDock<VideoRgbParadeScopeWidget>(mainWindow, scopeMenu, "VideoRgbParade",
+        VideoRgbParadeScopeWidget::tr("Video RGB Parade"), true);
+    createScopeDock<VideoVectorscopeWidget>(mainWindow, scopeMenu, "VideoVectorscope",
+        VideoVectorscopeWidget::tr("Video Vectorscope"), true);
+    createScopeDock<VideoWaveformScopeWidget>(mainWindow, scopeMenu, "VideoZoom",
+        VideoWaveformScopeWidget::tr("Video Waveform"), true);
     LOG_DEBUG() << "end";
 }
 
-template<typename ScopeTYPE> void ScopeController::createScopeDock(QMainWindow* mainWindow, QMenu* menu)
+void ScopeController::setVideoScopeVisible(bool visible)
+{
+    // With GPU processing, the player only reads back images while a video scope is visible.
+    bool wasVisible = m_visibleVideoScopes > 0;
+    m_visibleVideoScopes = qMax(0, m_visibleVideoScopes + (visible? 1 : -1));
+    if (wasVisible != (m_visibleVideoScopes > 0)) {
+        // Without GPU processing, the displayed frames only go to the video scopes while one is visible.
+        if (!Settings.playerGPU()) {
+            if (m_visibleVideoScopes > 0)
+                connect(this, SIGNAL(newFrame(const SharedFrame&)), SIGNAL(newVideoFrame(const SharedFrame&)));
+            else
+                disconnect(this, SIGNAL(newFrame(const SharedFrame&)), this, SIGNAL(newVideoFrame(const SharedFrame&)));
+        }
+        emit videoScopesVisibleChanged(m_visibleVideoScopes > 0);
+    }
+}
+
+void ScopeController::setAudioScopeVisible(bool visible)
+{
+    // The audio is analyzed once for all of the audio scopes, only while one is visible.
+    bool wasVisible = m_visibleAudioScopes > 0;
+    m_visibleAudioScopes = qMax(0, m_visibleAudioScopes + (visible? 1 : -1));
+    if (!wasVisible && m_visibleAudioScopes > 0)
+        connect(this, SIGNAL(newFrame(const SharedFrame&)), &AudioAnalysis::singleton(), SLOT(onNewFrame(const SharedFrame&)));
+    else if (wasVisible && m_visibleAudioScopes == 0)
+        disconnect(this, SIGNAL(newFrame(const SharedFrame&)), &AudioAnalysis::singleton(), SLOT(onNewFrame(const SharedFrame&)));
+}
+
+template<typename ScopeTYPE> static ScopeWidget* newScopeWidget()
+{
+    return new ScopeTYPE();
+}
+
+template<typename ScopeTYPE> void ScopeController::createScopeDock(QMainWindow* mainWindow, QMenu* menu,
+    const char* name, const QString& title, bool isVideoScope)
 {
-    ScopeWidget* scopeWidget = new ScopeTYPE();
-    ScopeDock* scopeDock = new ScopeDock(this, scopeWidget);
+    ScopeDock* scopeDock = new ScopeDock(this, newScopeWidget<ScopeTYPE>, name, title, isVideoScope);
     scopeDock->hide();
     menu->addAction(scopeDock->toggleViewAction());
     mainWindow->addDockWidget(Qt::RightDockWidgetArea, scopeDock);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2016 Meltytech, LLC
+ * Copyright (c) 2015-2019 Meltytech, LLC
  * Author: Brian Matherly <code@brianmatherly.com>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -33,12 +33,21 @@ class ScopeController Q_DECL_FINAL : public QObject
 
 public:
     ScopeController(QMainWindow* mainWindow, QMenu* menu);
+    void setVideoScopeVisible(bool visible);
+    void setAudioScopeVisible(bool visible);
 
 signals:
     void newFrame(const SharedFrame& frame);
+    void newVideoFrame(const SharedFrame& frame);
+    void newAudioFrame(const SharedFrame& frame);
+    void videoScopesVisibleChanged(bool visible);
 
 private:
-    template<typename ScopeTYPE> void createScopeDock(QMainWindow* mainWindow, QMenu* menu);
+    template<typename ScopeTYPE> void createScopeDock(QMainWindow* mainWindow, QMenu* menu,
+        const char* name, const QString& title, bool isVideoScope);
+
+    int m_visibleVideoScopes;
+    int m_visibleAudioScopes;
 
 };
 
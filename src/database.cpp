@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2018 Meltytech, LLC
+ * Copyright (c) 2013-2019 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -19,18 +19,23 @@
 #include "models/playlistmodel.h"
 #include "mainwindow.h"
 #include "settings.h"
+#include "startuptimer.h"
 #include <QtSql>
 #include <QDir>
+#include <QElapsedTimer>
 #include <Logger.h>
 
 struct DatabaseJob {
     enum Type {
         PutThumbnail,
-        GetThumbnail
+        GetThumbnail,
+        PutLoudness,
+        GetLoudness
     } type;
 
     QImage image;
     QString hash;
+    QString text;
     bool result;
     bool completed;
     DatabaseJob()
@@ -53,6 +58,7 @@ Database &Database::singleton(QWidget *parent)
 {
     if (!instance) {
         instance = new Database(parent);
+        instance->setObjectName("Database");
         instance->start();
     }
     return *instance;
@@ -73,8 +79,26 @@ bool Database::upgradeVersion1()
     return success;
 }
 
+bool Database::upgradeVersion2()
+{
+    if (!QSqlDatabase::database().isOpen()) return false;
+    bool success = false;
+    QSqlQuery query;
+    if (query.exec("CREATE TABLE loudness (key TEXT PRIMARY KEY NOT NULL, accessed DATETIME NOT NULL, results TEXT);")) {
+        success = query.exec("UPDATE version SET version = 2;");
+        if (!success)
+            LOG_ERROR() << query.lastError();
+    } else {
+        LOG_ERROR() << "Failed to create loudness table.";
+    }
+    return success;
+}
+
 void Database::doJob(DatabaseJob * job)
 {
+    static const char* jobNames[] = { "put thumbnail", "get thumbnail", "put loudness", "get loudness" };
+    LOG_SPAN("database");
+    loggerSpan.setArgument("job", jobNames[job->type]);
     if (!m_commitTimer->isActive())
         QSqlDatabase::database().transaction();
     m_commitTimer->start();
@@ -111,8 +135,32 @@ void Database::doJob(DatabaseJob * job)
                 LOG_ERROR() << update.lastError();
         }
         job->image = result;
+    } else if (job->type == DatabaseJob::PutLoudness) {
+        QSqlQuery query;
+        query.prepare("INSERT OR REPLACE INTO loudness VALUES (:key, datetime('now'), :results);");
+        query.bindValue(":key", job->hash);
+        query.bindValue(":results", job->text);
+        job->result = query.exec();
+        if (!job->result)
+            LOG_ERROR() << query.lastError();
+        m_isFailing = !job->result;
+        deleteOldLoudness();
+    } else if (job->type == DatabaseJob::GetLoudness) {
+        QSqlQuery query;
+        query.prepare("SELECT results FROM loudness WHERE key = :key;");
+        query.bindValue(":key", job->hash);
+        if (query.exec() && query.first()) {
+            job->text = query.value(0).toString();
+            QSqlQuery update;
+            update.prepare("UPDATE loudness SET accessed = datetime('now') WHERE key = :key ;");
+            update.bindValue(":key", job->hash);
+            m_isFailing = !update.exec();
+            if (m_isFailing)
+                LOG_ERROR() << update.lastError();
+        }
     }
-    deleteOldThumbnails();
+    if (job->type == DatabaseJob::PutThumbnail || job->type == DatabaseJob::GetThumbnail)
+        deleteOldThumbnails();
     job->completed = true;
 }
 
@@ -157,6 +205,27 @@ QImage Database::getThumbnail(const QString &hash)
     return job.image;
 }
 
+bool Database::putLoudness(const QString& key, const QString& results)
+{
+    if (!QSqlDatabase::database().isOpen()) return false;
+    DatabaseJob job;
+    job.type = DatabaseJob::PutLoudness;
+    job.hash = key;
+    job.text = results;
+    submitAndWaitForJob(&job);
+    return job.result;
+}
+
+QString Database::getLoudness(const QString& key)
+{
+    if (!QSqlDatabase::database().isOpen()) return QString();
+    DatabaseJob job;
+    job.type = DatabaseJob::GetLoudness;
+    job.hash = key;
+    submitAndWaitForJob(&job);
+    return job.text;
+}
+
 bool Database::isShutdown() const
 {
     return g_isShutdown;
@@ -182,11 +251,21 @@ void Database::deleteOldThumbnails()
         LOG_ERROR() << query.lastError();
 }
 
+void Database::deleteOldLoudness()
+{
+    QSqlQuery query;
+    // OFFSET is the number of loudness results to cache.
+    if (!query.exec("DELETE FROM loudness WHERE key IN (SELECT key FROM loudness ORDER BY accessed DESC LIMIT -1 OFFSET 10000);"))
+        LOG_ERROR() << query.lastError();
+}
+
 void Database::run()
 {
     connect(&MAIN, SIGNAL(aboutToShutDown()),
             this, SLOT(shutdown()), Qt::DirectConnection);
 
+    QElapsedTimer timer;
+    timer.start();
     QDir dir(Settings.appDataLocation());
     if (!dir.exists())
         dir.mkpath(dir.path());
@@ -215,7 +294,10 @@ void Database::run()
     }
     if (version < 1 && upgradeVersion1())
         version = 1;
+    if (version < 2 && upgradeVersion2())
+        version = 2;
     LOG_DEBUG() << "Database version is" << version;
+    StartupTimer::add("database", timer.elapsed());
 
     while (true) {
         DatabaseJob * newJob = 0;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2018 Meltytech, LLC
+ * Copyright (c) 2013-2019 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -34,8 +34,11 @@ public:
     static Database& singleton(QWidget* parent = 0);
 
     bool upgradeVersion1();
+    bool upgradeVersion2();
     bool putThumbnail(const QString& hash, const QImage& image);
     QImage getThumbnail(const QString& hash);
+    bool putLoudness(const QString& key, const QString& results);
+    QString getLoudness(const QString& key);
     bool isShutdown() const;
     bool isFailing() const { return m_isFailing; }
 
@@ -49,6 +52,7 @@ private:
     void doJob(DatabaseJob * job);
     void submitAndWaitForJob(DatabaseJob * job);
     void deleteOldThumbnails();
+    void deleteOldLoudness();
     void run();
 
     QList<DatabaseJob*> m_jobs;
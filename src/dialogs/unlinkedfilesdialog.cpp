@@ -26,9 +26,15 @@
 
 UnlinkedFilesDialog::UnlinkedFilesDialog(QWidget* parent) :
     QDialog(parent),
-    ui(new Ui::UnlinkedFilesDialog)
+    ui(new Ui::UnlinkedFilesDialog),
+    m_relinkGeneration(0)
 {
     ui->setupUi(this);
+    ui->statusLabel->hide();
+    connect(&m_relinker, SIGNAL(found(int,int,QString,QString,bool)),
+            SLOT(onRelinkFound(int,int,QString,QString,bool)));
+    connect(&m_relinker, SIGNAL(progressUpdated(int,int,int,int)), SLOT(onRelinkProgressUpdated(int,int,int,int)));
+    connect(&m_relinker, SIGNAL(finished(int,bool)), SLOT(onRelinkFinished(int,bool)));
 }
 
 UnlinkedFilesDialog::~UnlinkedFilesDialog()
@@ -46,6 +52,14 @@ void UnlinkedFilesDialog::setModel(QStandardItemModel& model)
     ui->tableView->resizeColumnsToContents();
 }
 
+void UnlinkedFilesDialog::done(int result)
+{
+    // Do not change the model after the dialog is closed.
+    m_relinker.cancel();
+    disconnect(&m_relinker, 0, this, 0);
+    QDialog::done(result);
+}
+
 void UnlinkedFilesDialog::on_tableView_doubleClicked(const QModelIndex& index)
 {
     // Use File Open dialog to choose a replacement.
@@ -56,25 +70,10 @@ void UnlinkedFilesDialog::on_tableView_doubleClicked(const QModelIndex& index)
     QStringList filenames = QFileDialog::getOpenFileNames(this, tr("Open File"), path);
     if (filenames.length() > 0) {
         QAbstractItemModel* model = ui->tableView->model();
-
         QModelIndex firstColIndex = model->index(index.row(), MltXmlChecker::MissingColumn);
-        QModelIndex secondColIndex = model->index(index.row(), MltXmlChecker::ReplacementColumn);
         QString hash = MAIN.getFileHash(filenames[0]);
-        if (hash == model->data(firstColIndex, MltXmlChecker::ShotcutHashRole)) {
-            // If the hashes match set icon to OK.
-            QIcon icon(":/icons/oxygen/32x32/status/task-complete.png");
-            model->setData(firstColIndex, icon, Qt::DecorationRole);
-        } else {
-            // Otherwise, set icon to warning.
-            QIcon icon(":/icons/oxygen/32x32/status/task-attempt.png");
-            model->setData(firstColIndex, icon, Qt::DecorationRole);
-        }
-
-        // Add chosen filename to the model.
-        QString filePath = QDir::toNativeSeparators(filenames[0]);
-        model->setData(secondColIndex, filePath);
-        model->setData(secondColIndex, filePath, Qt::ToolTipRole);
-        model->setData(secondColIndex, hash, MltXmlChecker::ShotcutHashRole);
+        setReplacement(index.row(), filenames[0], hash,
+                       hash == model->data(firstColIndex, MltXmlChecker::ShotcutHashRole));
 
         QFileInfo fi(QFileInfo(filenames.first()));
         Settings.setOpenPath(fi.path());
@@ -82,60 +81,86 @@ void UnlinkedFilesDialog::on_tableView_doubleClicked(const QModelIndex& index)
     }
 }
 
-bool UnlinkedFilesDialog::lookInDir(const QDir& dir, bool recurse)
+void UnlinkedFilesDialog::setReplacement(int row, const QString& filePath, const QString& hash, bool isHashMatch)
+{
+    QAbstractItemModel* model = ui->tableView->model();
+    QModelIndex missingIndex = model->index(row, MltXmlChecker::MissingColumn);
+    QModelIndex replacementIndex = model->index(row, MltXmlChecker::ReplacementColumn);
+    if (isHashMatch) {
+        // If the hashes match set icon to OK.
+        QIcon icon(":/icons/oxygen/32x32/status/task-complete.png");
+        model->setData(missingIndex, icon, Qt::DecorationRole);
+    } else {
+        // Otherwise, set icon to warning.
+        QIcon icon(":/icons/oxygen/32x32/status/task-attempt.png");
+        model->setData(missingIndex, icon, Qt::DecorationRole);
+    }
+
+    // Add chosen filename to the model.
+    QString nativePath = QDir::toNativeSeparators(filePath);
+    model->setData(replacementIndex, nativePath);
+    model->setData(replacementIndex, nativePath, Qt::ToolTipRole);
+    model->setData(replacementIndex, hash, MltXmlChecker::ShotcutHashRole);
+}
+
+void UnlinkedFilesDialog::lookInDir(const QDir& dir, bool recurse)
 {
     LOG_DEBUG() << dir.canonicalPath();
-    // returns true if outstanding is > 0
-    unsigned outstanding = 0;
+    QList<FileRelinker::MissingFile> missingFiles;
+    m_relinkRows.clear();
     QAbstractItemModel* model = ui->tableView->model();
     for (int row = 0; row < model->rowCount(); row++) {
         QModelIndex replacementIndex = model->index(row, MltXmlChecker::ReplacementColumn);
-        if (model->data(replacementIndex, MltXmlChecker::ShotcutHashRole).isNull())
-            ++outstanding;
-    }
-    if (outstanding)
-    foreach (const QString& fileName, dir.entryList(QDir::Files | QDir::Readable | QDir::NoDotAndDotDot)) {
-        QString hash = MAIN.getFileHash(dir.absoluteFilePath(fileName));
-        for (int row = 0; row < model->rowCount(); row++) {
-            QModelIndex replacementIndex = model->index(row, MltXmlChecker::ReplacementColumn);
-            if (model->data(replacementIndex, MltXmlChecker::ShotcutHashRole).isNull()) {
-                QModelIndex missingIndex = model->index(row, MltXmlChecker::MissingColumn);
-                QFileInfo missingInfo(model->data(missingIndex).toString());
-                QString missingHash = model->data(missingIndex, MltXmlChecker::ShotcutHashRole).toString();
-                if (hash == missingHash || fileName == missingInfo.fileName()) {
-                    if (hash == missingHash) {
-                        QIcon icon(":/icons/oxygen/32x32/status/task-complete.png");
-                        model->setData(missingIndex, icon, Qt::DecorationRole);
-                    } else {
-                        QIcon icon(":/icons/oxygen/32x32/status/task-attempt.png");
-                        model->setData(missingIndex, icon, Qt::DecorationRole);
-                    }
-                    QString filePath = QDir::toNativeSeparators(dir.absoluteFilePath(fileName));
-                    model->setData(replacementIndex, filePath);
-                    model->setData(replacementIndex, filePath, Qt::ToolTipRole);
-                    model->setData(replacementIndex, hash, MltXmlChecker::ShotcutHashRole);
-                    QCoreApplication::processEvents();
-                    if (--outstanding)
-                        break;
-                    else
-                        return false;
-                }
-            }
+        if (model->data(replacementIndex, MltXmlChecker::ShotcutHashRole).isNull()) {
+            QModelIndex missingIndex = model->index(row, MltXmlChecker::MissingColumn);
+            FileRelinker::MissingFile missing;
+            missing.filePath = QDir::fromNativeSeparators(model->data(missingIndex).toString());
+            missing.hash = model->data(missingIndex, MltXmlChecker::ShotcutHashRole).toString();
+            missingFiles << missing;
+            m_relinkRows << row;
         }
     }
-    if (outstanding && recurse) {
-        foreach (const QString& dirName, dir.entryList(QDir::Dirs | QDir::Executable | QDir::NoDotAndDotDot)) {
-            if (!lookInDir(dir.absoluteFilePath(dirName), true))
-                break;
-        }
-    }
-    return outstanding;
+    if (missingFiles.isEmpty())
+        return;
+    ui->searchFolderButton->setText(tr("Stop Searching"));
+    ui->statusLabel->setText(tr("Searching..."));
+    ui->statusLabel->show();
+    m_relinkGeneration = m_relinker.start(dir.absolutePath(), missingFiles, recurse);
 }
 
 void UnlinkedFilesDialog::on_searchFolderButton_clicked()
 {
+    if (m_relinker.isRunning()) {
+        m_relinker.cancel();
+        return;
+    }
     QString dirName = QFileDialog::getExistingDirectory(this, windowTitle(), Settings.openPath());
     if (!dirName.isEmpty()) {
-        lookInDir(dirName);
+        lookInDir(dirName, true);
     }
 }
+
+void UnlinkedFilesDialog::onRelinkFound(int generation, int index, const QString& filePath, const QString& hash, bool isHashMatch)
+{
+    // The index refers to the missing files of the search that found it.
+    if (generation == m_relinkGeneration && index < m_relinkRows.size())
+        setReplacement(m_relinkRows[index], filePath, hash, isHashMatch);
+}
+
+void UnlinkedFilesDialog::onRelinkProgressUpdated(int generation, int filesSearched, int filesHashed, int remaining)
+{
+    if (generation != m_relinkGeneration)
+        return;
+    ui->statusLabel->setText(tr("Searched %n file(s), checked %1, %2 missing", 0, filesSearched)
+                             .arg(filesHashed).arg(remaining));
+}
+
+void UnlinkedFilesDialog::onRelinkFinished(int generation, bool isCanceled)
+{
+    // A canceled search can finish after a new one started.
+    if (generation != m_relinkGeneration)
+        return;
+    ui->searchFolderButton->setText(tr("Search in Folder..."));
+    if (isCanceled)
+        ui->statusLabel->setText(tr("Search stopped"));
+}
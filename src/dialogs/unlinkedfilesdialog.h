@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-1029 Meltytech, LLC
+ * Copyright (c) 2016-2019 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -21,6 +21,7 @@
 #include <QDialog>
 #include <QStandardItemModel>
 #include <QDir>
+#include "filerelinker.h"
 
 namespace Ui {
 class UnlinkedFilesDialog;
@@ -36,15 +37,27 @@ public:
 
     void setModel(QStandardItemModel& model);
 
+public slots:
+    void done(int result);
+
 private slots:
     void on_tableView_doubleClicked(const QModelIndex& index);
 
     void on_searchFolderButton_clicked();
+    void onRelinkFound(int generation, int index, const QString& filePath, const QString& hash, bool isHashMatch);
+    void onRelinkProgressUpdated(int generation, int filesSearched, int filesHashed, int remaining);
+    void onRelinkFinished(int generation, bool isCanceled);
 
 private:
-    bool lookInDir(const QDir& dir, bool recurse = false);
+    void lookInDir(const QDir& dir, bool recurse = false);
+    void setReplacement(int row, const QString& filePath, const QString& hash, bool isHashMatch);
 
     Ui::UnlinkedFilesDialog *ui;
+    FileRelinker m_relinker;
+    // Maps the index of a missing file in the relinker to the row of the model.
+    QList<int> m_relinkRows;
+    // Identifies the current search; signals from canceled searches are ignored.
+    int m_relinkGeneration;
 };
 
 #endif // UNLINKEDFILESDIALOG_H
@@ -24,6 +24,7 @@
 #include "settings.h"
 #include "qmltypes/qmlapplication.h"
 #include "jobs/encodejob.h"
+#include "jobs/loudnessjob.h"
 #include "shotcut_mlt_properties.h"
 #include "util.h"
 #include "dialogs/listselectiondialog.h"
@@ -1073,12 +1074,24 @@ void EncodeDock::enqueueAnalysis()
             dialog.setEscapeButton(QMessageBox::No);
             dialog.setWindowModality(QmlApplication::dialogModality());
             if (QMessageBox::Yes == dialog.exec()) {
-                // If dialog accepted enqueue jobs.
+                // If dialog accepted enqueue jobs. All of the loudness filters
+                // share one job that measures them in parallel.
+                LoudnessJob* loudnessJob = 0;
                 foreach (Mlt::Filter filter, parser.filters()) {
-                    QScopedPointer<QmlMetadata> meta(new QmlMetadata);
-                    QmlFilter qmlFilter(filter, meta.data());
-                    bool isAudio = !::qstrcmp("loudness", filter.get("mlt_service"));
-                    qmlFilter.analyze(isAudio);
+                    if (!::qstrcmp("loudness", filter.get("mlt_service"))) {
+                        if (!loudnessJob)
+                            loudnessJob = new LoudnessJob(QString());
+                        Mlt::Service service(mlt_service(filter.get_data("service")));
+                        loudnessJob->addFilter(service, filter);
+                    } else {
+                        QScopedPointer<QmlMetadata> meta(new QmlMetadata);
+                        QmlFilter qmlFilter(filter, meta.data());
+                        qmlFilter.analyze(false);
+                    }
+                }
+                if (loudnessJob) {
+                    loudnessJob->setLabel(tr("Analyze loudness of %n clip(s)", 0, loudnessJob->count()));
+                    JOBS.add(loudnessJob);
                 }
             }
         }
@@ -103,12 +103,12 @@ void JobsDock::on_treeView_customContextMenuRequested(const QPoint &pos)
     QMenu menu(this);
     AbstractJob* job = JOBS.jobFromIndex(index);
     if (job) {
-        if (job->ran() && job->state() == QProcess::NotRunning && job->exitStatus() == QProcess::NormalExit) {
+        if (job->ran() && !job->isRunning() && job->exitStatus() == QProcess::NormalExit) {
             menu.addActions(job->successActions());
         }
         if (job->stopped() || (JOBS.isPaused() && !job->ran()))
             menu.addAction(ui->actionRun);
-        if (job->state() == QProcess::Running)
+        if (job->isRunning())
             menu.addAction(ui->actionStopJob);
         else
             menu.addAction(ui->actionRemove);
@@ -164,7 +164,7 @@ void JobsDock::on_menuButton_clicked()
 void JobsDock::on_treeView_doubleClicked(const QModelIndex &index)
 {
     AbstractJob* job = JOBS.jobFromIndex(index);
-    if (job && job->ran() && job->state() == QProcess::NotRunning && job->exitStatus() == QProcess::NormalExit) {
+    if (job && job->ran() && !job->isRunning() && job->exitStatus() == QProcess::NormalExit) {
         foreach (QAction* action, job->successActions()) {
             if (action->text() == "Open") {
                 action->trigger();
@@ -36,6 +36,7 @@
 #include <QHeaderView>
 #include <QKeyEvent>
 #include <QDir>
+#include <QScrollBar>
 
 static const int kInOutChangedTimeoutMs = 100;
 
@@ -132,7 +133,8 @@ private:
 
 PlaylistDock::PlaylistDock(QWidget *parent) :
     QDockWidget(parent),
-    ui(new Ui::PlaylistDock)
+    ui(new Ui::PlaylistDock),
+    m_view(0)
 {
     LOG_DEBUG() << "begin";
     ui->setupUi(this);
@@ -156,6 +158,8 @@ PlaylistDock::PlaylistDock(QWidget *parent) :
         view->setAlternatingRowColors(true);
         connect(view, SIGNAL(customContextMenuRequested(QPoint)), SLOT(viewCustomContextMenuRequested(QPoint)));
         connect(view, SIGNAL(doubleClicked(QModelIndex)), SLOT(viewDoubleClicked(QModelIndex)));
+        connect(view->verticalScrollBar(), SIGNAL(valueChanged(int)), SLOT(updateVisibleRows()));
+        connect(view->verticalScrollBar(), SIGNAL(rangeChanged(int,int)), SLOT(updateVisibleRows()));
     }
 
     connect(ui->actionDetailed, SIGNAL(triggered(bool)), SLOT(updateViewModeFromActions()));
@@ -849,9 +853,22 @@ void PlaylistDock::setViewMode(PlaylistModel::ViewMode mode)
         m_iconsView->setModel(&m_model);
         m_iconsView->show();
     }
+    updateVisibleRows();
     m_model.refreshThumbnails();
 }
 
+void PlaylistDock::updateVisibleRows()
+{
+    if (!m_view || !m_view->model())
+        return;
+    // Let the thumbnail requests for rows in view run first.
+    QRect rect = m_view->viewport()->rect();
+    QModelIndex first = m_view->indexAt(rect.topLeft());
+    QModelIndex last = m_view->indexAt(rect.bottomLeft());
+    m_model.setVisibleRows(first.isValid()? first.row() : 0,
+                           last.isValid()? last.row() : m_model.rowCount() - 1);
+}
+
 #include "playlistdock.moc"
 
 void PlaylistDock::on_tilesButton_clicked()
@@ -135,6 +135,8 @@ private slots:
 
     void on_actionPlayAfterOpen_triggered(bool checked);
 
+    void updateVisibleRows();
+
 protected:
     void keyPressEvent(QKeyEvent* event);
     void keyReleaseEvent(QKeyEvent* event);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2016 Meltytech, LLC
+ * Copyright (c) 2015-2019 Meltytech, LLC
  * Author: Brian Matherly <code@brianmatherly.com>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -22,19 +22,21 @@
 #include <QtWidgets/QScrollArea>
 #include <QAction>
 
-ScopeDock::ScopeDock(ScopeController* scopeController, ScopeWidget* scopeWidget) :
+ScopeDock::ScopeDock(ScopeController* scopeController, ScopeFactory factory,
+                     const QString& name, const QString& title, bool isVideoScope) :
     QDockWidget()
   , m_scopeController(scopeController)
-  , m_scopeWidget(scopeWidget)
+  , m_factory(factory)
+  , m_isVideoScope(isVideoScope)
+  , m_scrollArea(new QScrollArea())
+  , m_scopeWidget(0)
 {
     LOG_DEBUG() << "begin";
-    setObjectName(m_scopeWidget->objectName() + "Dock");
-    QScrollArea *scrollArea = new QScrollArea();
-    scrollArea->setFrameShape(QFrame::NoFrame);
-    scrollArea->setWidgetResizable(true);
-    scrollArea->setWidget(m_scopeWidget);
-    QDockWidget::setWidget(scrollArea);
-    QDockWidget::setWindowTitle(m_scopeWidget->getTitle());
+    setObjectName(name + "Dock");
+    m_scrollArea->setFrameShape(QFrame::NoFrame);
+    m_scrollArea->setWidgetResizable(true);
+    QDockWidget::setWidget(m_scrollArea);
+    QDockWidget::setWindowTitle(title);
 
     connect(toggleViewAction(), SIGNAL(toggled(bool)), this, SLOT(onActionToggled(bool)));
     LOG_DEBUG() << "end";
@@ -42,19 +44,42 @@ ScopeDock::ScopeDock(ScopeController* scopeController, ScopeWidget* scopeWidget)
 
 void ScopeDock::resizeEvent(QResizeEvent* e)
 {
-    if (width() > height()) {
-        m_scopeWidget->setOrientation(Qt::Horizontal);
-    } else {
-        m_scopeWidget->setOrientation(Qt::Vertical);
+    if (m_scopeWidget) {
+        if (width() > height()) {
+            m_scopeWidget->setOrientation(Qt::Horizontal);
+        } else {
+            m_scopeWidget->setOrientation(Qt::Vertical);
+        }
     }
     QDockWidget::resizeEvent(e);
 }
 
+void ScopeDock::createScopeWidget()
+{
+    LOG_DEBUG() << objectName();
+    m_scopeWidget = m_factory();
+    Q_ASSERT(objectName() == m_scopeWidget->objectName() + "Dock");
+    Q_ASSERT(m_isVideoScope == m_scopeWidget->isVideoScope());
+    m_scopeWidget->setOrientation(width() > height()? Qt::Horizontal : Qt::Vertical);
+    m_scrollArea->setWidget(m_scopeWidget);
+}
+
 void ScopeDock::onActionToggled(bool checked)
 {
+    if (!m_scopeWidget) {
+        if (!checked)
+            return;
+        createScopeWidget();
+    }
+    const char* signal = m_isVideoScope?
+        SIGNAL(newVideoFrame(const SharedFrame&)) : SIGNAL(newAudioFrame(const SharedFrame&));
     if(checked) {
-        connect(m_scopeController, SIGNAL(newFrame(const SharedFrame&)), m_scopeWidget, SLOT(onNewFrame(const SharedFrame&)));
+        connect(m_scopeController, signal, m_scopeWidget, SLOT(onNewFrame(const SharedFrame&)));
     } else {
-        disconnect(m_scopeController, SIGNAL(newFrame(const SharedFrame&)), m_scopeWidget, SLOT(onNewFrame(const SharedFrame&)));
+        disconnect(m_scopeController, signal, m_scopeWidget, SLOT(onNewFrame(const SharedFrame&)));
     }
+    if (m_isVideoScope)
+        m_scopeController->setVideoScopeVisible(checked);
+    else
+        m_scopeController->setAudioScopeVisible(checked);
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015 Meltytech, LLC
+ * Copyright (c) 2015-2019 Meltytech, LLC
  * Author: Brian Matherly <code@brianmatherly.com>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -24,19 +24,37 @@
 #include <QObject>
 
 class ScopeController;
+class QScrollArea;
+
+/*!
+  \class ScopeDock
+  \brief Hosts a ScopeWidget, which is only constructed the first time the dock is shown.
+
+  Some scopes own MLT filters or a QQuickWidget, so the dock is created with
+  the name and title of its scope, and a function to construct the scope when
+  it is needed. The scope only receives frames while the dock is visible.
+*/
 
 class ScopeDock Q_DECL_FINAL : public QDockWidget
 {
    Q_OBJECT
 
 public:
-   explicit ScopeDock(ScopeController* scopeController, ScopeWidget* scopeWidget);
+   typedef ScopeWidget* (*ScopeFactory)();
+
+   ScopeDock(ScopeController* scopeController, ScopeFactory factory,
+             const QString& name, const QString& title, bool isVideoScope);
 
 protected:
    void resizeEvent(QResizeEvent*) Q_DECL_OVERRIDE;
 
 private:
+   void createScopeWidget();
+
    ScopeController* m_scopeController;
+   ScopeFactory m_factory;
+   bool m_isVideoScope;
+   QScrollArea* m_scrollArea;
    ScopeWidget* m_scopeWidget;
 
    void setWidget(QWidget * widget); // Private to disallow use
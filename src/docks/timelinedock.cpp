@@ -379,7 +379,7 @@ bool TimelineDock::isRipple() const
 void TimelineDock::copyToSource()
 {
     if (model()->tractor() && model()->tractor()->is_valid()) {
-        if (MAIN.on_actionSave_triggered()) {
+        if (MAIN.on_actionSave_triggered() && MAIN.waitForSave()) {
             if (!MLT.openXML(MAIN.fileName())) {
                 MLT.producer()->set(kExportFromProperty, 1);
                 MAIN.open(MLT.producer());
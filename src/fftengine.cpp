@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fftengine.h"
+#include <Logger.h>
+#include <QElapsedTimer>
+#include <cmath>
+#include <stdio.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define FFT_SSE2
+#   include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#   define FFT_NEON
+#   include <arm_neon.h>
+#endif
+
+FftEngine::FftEngine(int size, Window window)
+    : m_size(size)
+    , m_half(size / 2)
+    , m_windowType(window)
+    , m_window(size)
+    , m_scale(1.0f)
+    , m_real(size / 2)
+    , m_imag(size / 2)
+    , m_cos(qMax(1, size / 2 - 1))
+    , m_sin(qMax(1, size / 2 - 1))
+    , m_splitCos(size / 2 + 1)
+    , m_splitSin(size / 2 + 1)
+    , m_bitReverse(size / 2)
+{
+    Q_ASSERT(size >= 4 && (size & (size - 1)) == 0);
+    setWindow(window);
+
+    for (int half = 1; half < m_half; half <<= 1) {
+        for (int k = 0; k < half; ++k) {
+            m_cos[half - 1 + k] = float(cos(M_PI * k / half));
+            m_sin[half - 1 + k] = float(-sin(M_PI * k / half));
+        }
+    }
+    for (int k = 0; k <= m_half; ++k) {
+        m_splitCos[k] = float(cos(2.0 * M_PI * k / size));
+        m_splitSin[k] = float(-sin(2.0 * M_PI * k / size));
+    }
+    int bits = 0;
+    while ((1 << bits) < m_half)
+        ++bits;
+    for (int i = 0; i < m_half; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b)
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        m_bitReverse[i] = reversed;
+    }
+}
+
+void FftEngine::setWindow(Window window)
+{
+    m_windowType = window;
+    double windowSum = 0.0;
+    for (int i = 0; i < m_size; ++i) {
+        double x = 2.0 * M_PI * i / m_size;
+        double value = 1.0;
+        switch (window) {
+        case HannWindow:
+            value = 0.5 - 0.5 * cos(x);
+            break;
+        case HammingWindow:
+            value = 0.54 - 0.46 * cos(x);
+            break;
+        case BlackmanHarrisWindow:
+            value = 0.35875 - 0.48829 * cos(x) + 0.14128 * cos(2 * x) - 0.01168 * cos(3 * x);
+            break;
+        case FlatTopWindow:
+            value = 0.21557895 - 0.41663158 * cos(x) + 0.277263158 * cos(2 * x)
+                    - 0.083578947 * cos(3 * x) + 0.006947368 * cos(4 * x);
+            break;
+        case RectangularWindow:
+        default:
+            break;
+        }
+        m_window[i] = float(value);
+        windowSum += value;
+    }
+    // Compensate for the window and for the energy in the negative frequencies.
+    m_scale = float(2.0 / windowSum);
+}
+
+void FftEngine::magnitudes(const float* input, float* output)
+{
+    powers(input, output);
+    for (int i = 0; i <= m_half; ++i)
+        output[i] = std::sqrt(output[i]);
+}
+
+void FftEngine::powers(const float* input, float* output)
+{
+    // Pack the even samples into the real part and the odd into the imaginary.
+    const float* window = m_window.constData();
+    const int* bitReverse = m_bitReverse.constData();
+    float* real = m_real.data();
+    float* imag = m_imag.data();
+    for (int i = 0; i < m_half; ++i) {
+        int j = bitReverse[i];
+        real[j] = input[2 * i] * window[2 * i];
+        imag[j] = input[2 * i + 1] * window[2 * i + 1];
+    }
+    transform();
+
+    // Separate the spectra of the even and odd samples and combine them.
+    // DC and Nyquist have no negative frequency counterpart, hence the 0.25.
+    const float scale2 = m_scale * m_scale;
+    output[0] = (real[0] + imag[0]) * (real[0] + imag[0]) * scale2 * 0.25f;
+    output[m_half] = (real[0] - imag[0]) * (real[0] - imag[0]) * scale2 * 0.25f;
+    const float* wr = m_splitCos.constData();
+    const float* wi = m_splitSin.constData();
+    for (int k = 1; k < m_half; ++k) {
+        int j = m_half - k;
+        float er = 0.5f * (real[k] + real[j]);
+        float ei = 0.5f * (imag[k] - imag[j]);
+        float or_ = 0.5f * (imag[k] + imag[j]);
+        float oi = -0.5f * (real[k] - real[j]);
+        float xr = er + wr[k] * or_ - wi[k] * oi;
+        float xi = ei + wr[k] * oi + wi[k] * or_;
+        output[k] = (xr * xr + xi * xi) * scale2;
+    }
+}
+
+void FftEngine::transform()
+{
+    // Iterative radix-2 decimation in time on bit reversed input.
+    float* real = m_real.data();
+    float* imag = m_imag.data();
+    const int n = m_half;
+    for (int half = 1; half < n; half <<= 1) {
+        const float* cosTable = m_cos.constData() + half - 1;
+        const float* sinTable = m_sin.constData() + half - 1;
+        for (int start = 0; start < n; start += half * 2) {
+            float* ar = real + start;
+            float* ai = imag + start;
+            float* br = ar + half;
+            float* bi = ai + half;
+            int k = 0;
+#if defined(FFT_SSE2)
+            for (; k + 4 <= half; k += 4) {
+                __m128 wr = _mm_loadu_ps(cosTable + k);
+                __m128 wi = _mm_loadu_ps(sinTable + k);
+                __m128 xr = _mm_loadu_ps(br + k);
+                __m128 xi = _mm_loadu_ps(bi + k);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+                __m128 yr = _mm_loadu_ps(ar + k);
+                __m128 yi = _mm_loadu_ps(ai + k);
+                _mm_storeu_ps(br + k, _mm_sub_ps(yr, tr));
+                _mm_storeu_ps(bi + k, _mm_sub_ps(yi, ti));
+                _mm_storeu_ps(ar + k, _mm_add_ps(yr, tr));
+                _mm_storeu_ps(ai + k, _mm_add_ps(yi, ti));
+            }
+#elif defined(FFT_NEON)
+            for (; k + 4 <= half; k += 4) {
+                float32x4_t wr = vld1q_f32(cosTable + k);
+                float32x4_t wi = vld1q_f32(sinTable + k);
+                float32x4_t xr = vld1q_f32(br + k);
+                float32x4_t xi = vld1q_f32(bi + k);
+                float32x4_t tr = vmlsq_f32(vmulq_f32(xr, wr), xi, wi);
+                float32x4_t ti = vmlaq_f32(vmulq_f32(xr, wi), xi, wr);
+                float32x4_t yr = vld1q_f32(ar + k);
+                float32x4_t yi = vld1q_f32(ai + k);
+                vst1q_f32(br + k, vsubq_f32(yr, tr));
+                vst1q_f32(bi + k, vsubq_f32(yi, ti));
+                vst1q_f32(ar + k, vaddq_f32(yr, tr));
+                vst1q_f32(ai + k, vaddq_f32(yi, ti));
+            }
+#endif
+            for (; k < half; ++k) {
+                float tr = br[k] * cosTable[k] - bi[k] * sinTable[k];
+                float ti = br[k] * sinTable[k] + bi[k] * cosTable[k];
+                br[k] = ar[k] - tr;
+                bi[k] = ai[k] - ti;
+                ar[k] += tr;
+                ai[k] += ti;
+            }
+        }
+    }
+}
+
+void FftEngine::benchmark()
+{
+    const char* instructionSet =
+#if defined(FFT_SSE2)
+        "SSE2";
+#elif defined(FFT_NEON)
+        "NEON";
+#else
+        "scalar";
+#endif
+    for (int size = 1024; size <= 32768; size *= 2) {
+        FftEngine fft(size);
+        QVector<float> input(size);
+        QVector<float> output(fft.binCount());
+        for (int i = 0; i < size; ++i)
+            input[i] = float(sin(i * 0.1));
+        const int iterations = qMax(10, (1 << 22) / size);
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < iterations; ++i)
+            fft.magnitudes(input.constData(), output.data());
+        double us = timer.nsecsElapsed() / 1000.0 / iterations;
+        QString line = QString("fft %1 %2: %3 us").arg(instructionSet).arg(size).arg(us, 0, 'f', 1);
+        printf("%s\n", line.toLocal8Bit().constData());
+        LOG_INFO() << line;
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFTENGINE_H
+#define FFTENGINE_H
+
+#include <QVector>
+
+/*!
+  \class FftEngine
+  \brief Computes the spectrum of real audio samples.
+
+  The transform size must be a power of two of at least 4. The real input is
+  packed into a complex transform of half the size, which uses SSE2 or NEON
+  butterflies when available. All buffers, the window and the twiddle factors
+  are allocated by the constructor, so computing a spectrum does not allocate.
+*/
+
+class FftEngine
+{
+public:
+    enum Window {
+        RectangularWindow,
+        HannWindow,
+        HammingWindow,
+        BlackmanHarrisWindow,
+        FlatTopWindow
+    };
+
+    explicit FftEngine(int size, Window window = HannWindow);
+
+    int size() const { return m_size; }
+    Window window() const { return m_windowType; }
+    void setWindow(Window window);
+    //! Returns the number of values computed per spectrum.
+    int binCount() const { return m_size / 2 + 1; }
+
+    /*!
+      Applies the window to \a size() samples of \a input and writes the
+      magnitude of each bin to \a output, scaled so that a full scale sine
+      wave centered on a bin has a magnitude of 1.
+    */
+    void magnitudes(const float* input, float* output);
+    //! Like magnitudes() but writes the squared magnitudes, for averaging.
+    void powers(const float* input, float* output);
+
+    //! Prints the time per transform for each size to stdout and the log.
+    static void benchmark();
+
+private:
+    void transform();
+
+    int m_size;
+    int m_half;
+    Window m_windowType;
+    QVector<float> m_window;
+    float m_scale;
+    QVector<float> m_real;
+    QVector<float> m_imag;
+    // The twiddle factors of each stage are contiguous, starting at half - 1.
+    QVector<float> m_cos;
+    QVector<float> m_sin;
+    // The twiddle factors to split the packed transform.
+    QVector<float> m_splitCos;
+    QVector<float> m_splitSin;
+    QVector<int> m_bitReverse;
+};
+
+#endif // FFTENGINE_H
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filerelinker.h"
+#include "mainwindow.h"
+#include <Logger.h>
+#include <QDir>
+#include <QRunnable>
+#include <QThread>
+
+class FileRelinkerTask : public QRunnable
+{
+public:
+    FileRelinkerTask(FileRelinker* relinker, const QString& path)
+        : QRunnable()
+        , m_relinker(relinker)
+        , m_path(path)
+    {}
+
+    void run()
+    {
+        m_relinker->searchDirectory(m_path);
+        m_relinker->taskFinished();
+    }
+
+private:
+    FileRelinker* m_relinker;
+    QString m_path;
+};
+
+FileRelinker::FileRelinker(QObject* parent)
+    : QObject(parent)
+    , m_recurse(true)
+    , m_generation(0)
+    , m_isCanceled(0)
+    , m_tasks(0)
+    , m_filesSearched(0)
+    , m_filesHashed(0)
+    , m_remaining(0)
+{
+    // Listing folders on network storage is bound by latency more than CPU.
+    m_threadPool.setMaxThreadCount(qBound(4, 2 * QThread::idealThreadCount(), 16));
+}
+
+FileRelinker::~FileRelinker()
+{
+    cancel();
+    m_threadPool.waitForDone();
+}
+
+int FileRelinker::start(const QString& path, const QList<MissingFile>& missingFiles, bool recurse)
+{
+    if (isRunning()) {
+        cancel();
+        m_threadPool.waitForDone();
+    }
+    LOG_DEBUG() << path << "recurse" << recurse;
+
+    m_recurse = recurse;
+    ++m_generation;
+    m_isCanceled.store(0);
+    m_filesSearched.store(0);
+    m_filesHashed.store(0);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_missingFiles = missingFiles;
+        m_isResolved.clear();
+        m_isFound.clear();
+        m_indexByHash.clear();
+        m_indexByName.clear();
+        m_suffixes.clear();
+        for (int i = 0; i < missingFiles.size(); ++i) {
+            QFileInfo info(missingFiles[i].filePath);
+            m_indexByName[info.fileName()] << i;
+            if (!missingFiles[i].hash.isEmpty()) {
+                m_indexByHash[missingFiles[i].hash] << i;
+                m_suffixes << info.suffix().toLower();
+            }
+            m_isResolved << false;
+            m_isFound << false;
+        }
+        m_remaining = missingFiles.size();
+    }
+    if (missingFiles.isEmpty()) {
+        emit finished(m_generation, false);
+        return m_generation;
+    }
+    m_tasks.store(1);
+    m_threadPool.start(new FileRelinkerTask(this, path));
+    return m_generation;
+}
+
+void FileRelinker::cancel()
+{
+    // Queued tasks still run, but they return immediately.
+    m_isCanceled.store(1);
+}
+
+bool FileRelinker::isRunning() const
+{
+    return m_tasks.load() > 0;
+}
+
+void FileRelinker::searchDirectory(const QString& path)
+{
+    if (m_isCanceled.load())
+        return;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_remaining)
+            return;
+    }
+    QDir dir(path);
+    foreach (const QFileInfo& info, dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot, QDir::Unsorted)) {
+        if (m_isCanceled.load())
+            return;
+        if (info.isDir()) {
+            // Symbolic links to folders are not followed to avoid cycles.
+            if (m_recurse && info.isExecutable() && !info.isSymLink()) {
+                m_tasks.ref();
+                m_threadPool.start(new FileRelinkerTask(this, info.absoluteFilePath()));
+            }
+        } else if (info.isReadable()) {
+            m_filesSearched.ref();
+            if (isCandidate(info))
+                checkFile(info);
+        }
+    }
+    QMutexLocker locker(&m_mutex);
+    emit progressUpdated(m_generation, m_filesSearched.load(), m_filesHashed.load(), m_remaining);
+}
+
+bool FileRelinker::isCandidate(const QFileInfo& info)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_remaining)
+        return false;
+    foreach (int i, m_indexByName.value(info.fileName())) {
+        if (!m_isResolved[i])
+            return true;
+    }
+    // The hash of a missing file is unknown until the file is read, but a
+    // moved or renamed media file normally keeps its extension.
+    return info.size() > 0 && m_suffixes.contains(info.suffix().toLower());
+}
+
+void FileRelinker::checkFile(const QFileInfo& info)
+{
+    QString filePath = info.absoluteFilePath();
+    QString hash = MAIN.getFileHash(filePath);
+    m_filesHashed.ref();
+
+    QMutexLocker locker(&m_mutex);
+    foreach (int i, m_indexByHash.value(hash)) {
+        if (!m_isResolved[i]) {
+            m_isResolved[i] = true;
+            m_isFound[i] = true;
+            --m_remaining;
+            emit found(m_generation, i, filePath, hash, true);
+        }
+    }
+    foreach (int i, m_indexByName.value(info.fileName())) {
+        if (!m_isFound[i]) {
+            m_isFound[i] = true;
+            // Without a hash, a file with the same name is the best possible match.
+            if (m_missingFiles[i].hash.isEmpty()) {
+                m_isResolved[i] = true;
+                --m_remaining;
+            }
+            emit found(m_generation, i, filePath, hash, false);
+        }
+    }
+}
+
+void FileRelinker::taskFinished()
+{
+    if (!m_tasks.deref()) {
+        LOG_DEBUG() << "searched" << m_filesSearched.load() << "files, hashed" << m_filesHashed.load();
+        emit finished(m_generation, m_isCanceled.load());
+    }
+}
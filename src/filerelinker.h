@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILERELINKER_H
+#define FILERELINKER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <QFileInfo>
+
+/// Searches folders for replacements of missing files in the background.
+///
+/// Folders are listed in parallel on a private thread pool. A file is only
+/// hashed when its name or extension matches a missing file that still lacks
+/// a replacement, and the hash is looked up in a table instead of being
+/// compared with every missing file. A file with the same hash is a final
+/// match; a file with the same name is reported as a possible match until a
+/// file with the same hash turns up. The search ends when every missing file
+/// has a final match, all folders are searched, or it is canceled.
+class FileRelinker : public QObject
+{
+    Q_OBJECT
+public:
+    struct MissingFile {
+        QString filePath;
+        QString hash;
+    };
+
+    explicit FileRelinker(QObject* parent = 0);
+    ~FileRelinker();
+
+    /// Starts searching path for the missing files and returns the generation
+    /// that identifies this search in the signals. The index of a file in the
+    /// list identifies it in the found() signal.
+    int start(const QString& path, const QList<MissingFile>& missingFiles, bool recurse = true);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void found(int generation, int index, const QString& filePath, const QString& hash, bool isHashMatch);
+    void progressUpdated(int generation, int filesSearched, int filesHashed, int remaining);
+    void finished(int generation, bool isCanceled);
+
+private:
+    friend class FileRelinkerTask;
+    void searchDirectory(const QString& path);
+    bool isCandidate(const QFileInfo& info);
+    void checkFile(const QFileInfo& info);
+    void taskFinished();
+
+    QThreadPool m_threadPool;
+    bool m_recurse;
+    // Only changed in start() while no task is running.
+    int m_generation;
+    QAtomicInt m_isCanceled;
+    QAtomicInt m_tasks;
+    QAtomicInt m_filesSearched;
+    QAtomicInt m_filesHashed;
+
+    // Members accessed in multiple threads (mutex protected).
+    QMutex m_mutex;
+    QList<MissingFile> m_missingFiles;
+    QList<bool> m_isResolved;
+    QList<bool> m_isFound;
+    QHash<QString, QList<int> > m_indexByHash;
+    QHash<QString, QList<int> > m_indexByName;
+    QSet<QString> m_suffixes;
+    int m_remaining;
+};
+
+#endif // FILERELINKER_H
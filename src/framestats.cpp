@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "framestats.h"
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <atomic>
+
+static const quint32 kRingSize = 256; // a power of two
+static const quint32 kWindowUs = 1000000;
+
+struct FrameRecord
+{
+    // One more than the sequence number of the frame in the slot, or 0 while
+    // the slot is being written.
+    QAtomicInteger<quint32> sequence;
+    QAtomicInt position;
+    QAtomicInt queueDepth;
+    // 0 for a stage that was not recorded
+    QAtomicInteger<quint32> times[FrameStats::StageCount];
+};
+
+static FrameRecord g_records[kRingSize];
+static QAtomicInteger<quint32> g_queuedCount;
+// The sequence number to look for the next frame of the FrameRenderer from
+static QAtomicInteger<quint32> g_nextRender;
+// One more than the sequence number of the frame the FrameRenderer shows
+static QAtomicInteger<quint32> g_rendering;
+static QAtomicInteger<quint32> g_displayed;
+static QAtomicInteger<quint32> g_painted;
+static QAtomicInteger<quint32> g_skipped;
+static QAtomicInteger<quint32> g_dropped;
+static QAtomicInteger<quint32> g_late;
+
+static FrameRecord& slot(quint32 sequence)
+{
+    return g_records[sequence & (kRingSize - 1)];
+}
+
+void FrameStats::skipped()
+{
+    g_skipped.fetchAndAddRelaxed(1);
+}
+
+void FrameStats::dropped()
+{
+    g_dropped.fetchAndAddRelaxed(1);
+}
+
+void FrameStats::queued(int position, quint32 deliveredTime, int queueDepth)
+{
+    quint32 sequence = g_queuedCount.fetchAndAddOrdered(1);
+    FrameRecord& record = slot(sequence);
+    record.sequence.store(0);
+    // Keep the stores below from becoming visible before the slot is marked
+    // as being written.
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < StageCount; ++i)
+        record.times[i].store(0);
+    record.position.store(position);
+    record.queueDepth.store(queueDepth);
+    record.times[DeliveredStage].store(deliveredTime);
+    record.times[QueuedStage].store(now());
+    record.sequence.storeRelease(sequence + 1);
+}
+
+void FrameStats::record(Stage stage, int position)
+{
+    if (stage == RenderStage) {
+        // The frames arrive in the order they were queued, but the ones that
+        // were queued to a FrameRenderer that was stopped never arrive.
+        quint32 end = g_queuedCount.loadAcquire();
+        quint32 sequence = g_nextRender.load();
+        if (end - sequence > kRingSize)
+            sequence = end - kRingSize;
+        g_rendering.store(0);
+        for (; sequence != end; ++sequence) {
+            FrameRecord& record = slot(sequence);
+            if (record.sequence.loadAcquire() == sequence + 1 && record.position.load() == position) {
+                record.times[RenderStage].store(now());
+                g_rendering.store(sequence + 1);
+                g_nextRender.store(sequence + 1);
+                break;
+            }
+        }
+        return;
+    }
+
+    quint32 rendering = g_rendering.load();
+    if (!rendering)
+        return;
+    FrameRecord& record = slot(rendering - 1);
+    if (record.sequence.loadAcquire() != rendering)
+        return;
+    record.times[stage].store(now());
+    if (stage == DisplayedStage)
+        g_displayed.storeRelease(rendering);
+}
+
+void FrameStats::painted(double frameDurationMs)
+{
+    quint32 displayed = g_displayed.loadAcquire();
+    quint32 painted = g_painted.load();
+    if (!displayed || displayed == painted)
+        return;
+    g_painted.store(displayed);
+    if (painted && displayed - painted > 1 && displayed - painted < kRingSize)
+        g_dropped.fetchAndAddRelaxed(displayed - painted - 1);
+
+    FrameRecord& record = slot(displayed - 1);
+    if (record.sequence.loadAcquire() != displayed)
+        return;
+    quint32 time = now();
+    record.times[PaintedStage].store(time);
+    if (time - record.times[DeliveredStage].load() > frameDurationMs * 1000.0)
+        g_late.fetchAndAddRelaxed(1);
+}
+
+quint32 FrameStats::now()
+{
+    struct Clock
+    {
+        Clock() { timer.start(); }
+        QElapsedTimer timer;
+    };
+    static Clock clock;
+    quint32 time = quint32(clock.timer.nsecsElapsed() / 1000);
+    return time ? time : 1;
+}
+
+FrameStats::Summary FrameStats::summary()
+{
+    Summary result = {};
+    quint32 time = now();
+    int uploads = 0;
+    int paints = 0;
+    double uploadUs = 0.0;
+    double latencyUs = 0.0;
+
+    for (quint32 i = 0; i < kRingSize; ++i) {
+        FrameRecord& record = g_records[i];
+        quint32 sequence = record.sequence.loadAcquire();
+        if (!sequence)
+            continue;
+        quint32 times[StageCount];
+        for (int stage = 0; stage < StageCount; ++stage)
+            times[stage] = record.times[stage].load();
+        int queueDepth = record.queueDepth.load();
+        // Keep the loads above from moving after the check below.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record.sequence.load() != sequence)
+            continue; // overwritten while reading
+
+        if (time - times[DeliveredStage] < kWindowUs) {
+            ++result.decodeFps;
+            if (sequence == g_queuedCount.load())
+                result.queueDepth = queueDepth;
+        }
+        if (times[UploadedStage] && times[RenderStage] && time - times[UploadedStage] < kWindowUs) {
+            uploadUs += times[UploadedStage] - times[RenderStage];
+            ++uploads;
+        }
+        if (times[PaintedStage] && time - times[PaintedStage] < kWindowUs) {
+            latencyUs += times[PaintedStage] - times[DeliveredStage];
+            ++paints;
+            ++result.renderFps;
+        }
+    }
+    result.uploadMs = uploads ? uploadUs / uploads / 1000.0 : 0.0;
+    result.latencyMs = paints ? latencyUs / paints / 1000.0 : 0.0;
+    result.skipped = g_skipped.load();
+    result.dropped = g_dropped.load();
+    result.late = g_late.load();
+    return result;
+}
+
+void FrameStats::exportCsv(QTextStream& stream)
+{
+    static const char* stageNames[] = {
+        "delivered_us", "queued_us", "render_us", "uploaded_us", "displayed_us", "painted_us"
+    };
+    stream << "frame,position,queue_depth";
+    for (int stage = 0; stage < StageCount; ++stage)
+        stream << ',' << stageNames[stage];
+    stream << '\n';
+
+    quint32 end = g_queuedCount.loadAcquire();
+    quint32 begin = end > kRingSize ? end - kRingSize : 0;
+    bool haveBase = false;
+    quint32 base = 0;
+    for (quint32 sequence = begin; sequence != end; ++sequence) {
+        FrameRecord& record = slot(sequence);
+        if (record.sequence.loadAcquire() != sequence + 1)
+            continue;
+        quint32 times[StageCount];
+        for (int stage = 0; stage < StageCount; ++stage)
+            times[stage] = record.times[stage].load();
+        int position = record.position.load();
+        int queueDepth = record.queueDepth.load();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record.sequence.load() != sequence + 1)
+            continue;
+
+        if (!haveBase) {
+            base = times[DeliveredStage];
+            haveBase = true;
+        }
+        stream << sequence << ',' << position << ',' << queueDepth;
+        for (int stage = 0; stage < StageCount; ++stage) {
+            stream << ',';
+            if (times[stage])
+                stream << (times[stage] - base);
+        }
+        stream << '\n';
+    }
+}
+
+void FrameStats::reset()
+{
+    g_skipped.store(0);
+    g_dropped.store(0);
+    g_late.store(0);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <QtGlobal>
+
+class QTextStream;
+
+/// Records when the frames of the player pass each stage of the display
+/// pipeline and counts the frames that did not make it to the screen in time.
+///
+/// The timestamps of the last 256 frames are kept in a ring buffer of atomic
+/// integers. Recording takes no lock and allocates nothing, so it is always
+/// on. The stages of a frame are recorded by different threads: the consumer
+/// thread, the FrameRenderer thread and the thread that paints the player.
+class FrameStats
+{
+public:
+    enum Stage {
+        DeliveredStage, ///< The consumer delivered the frame to GLWidget.
+        QueuedStage,    ///< The frame got a place in the FrameRenderer queue.
+        RenderStage,    ///< The FrameRenderer began to show the frame.
+        UploadedStage,  ///< The image of the frame is converted and on the GPU.
+        DisplayedStage, ///< The FrameRenderer handed the frame to the player.
+        PaintedStage,   ///< The player painted the frame.
+        StageCount
+    };
+
+    /// Rates and means over the last second, and counters since reset().
+    struct Summary {
+        double renderFps;
+        double decodeFps;
+        double uploadMs;
+        double latencyMs;
+        int queueDepth;
+        quint32 skipped;
+        quint32 dropped;
+        quint32 late;
+    };
+
+    /// Records the delivery of a frame that the consumer did not render
+    /// because it was behind.
+    static void skipped();
+    /// Records the delivery of a frame for which the FrameRenderer queue had no
+    /// room.
+    static void dropped();
+    /// Records a frame entering the FrameRenderer queue, which was delivered
+    /// at \a deliveredTime from now() and left \a queueDepth frames queued.
+    static void queued(int position, quint32 deliveredTime, int queueDepth);
+    /// Records a stage of the frame the FrameRenderer is showing. The
+    /// RenderStage looks up the frame by its position.
+    static void record(Stage stage, int position = -1);
+    /// Records the first paint after a frame was displayed. A frame painted
+    /// more than \a frameDurationMs after it was delivered is late, and the
+    /// displayed frames that were never painted count as dropped.
+    static void painted(double frameDurationMs);
+
+    /// Returns a monotonic timestamp in microseconds. It wraps around after
+    /// 71 minutes, so only use differences of timestamps.
+    static quint32 now();
+    static Summary summary();
+    /// Writes the recorded frames as CSV with the times relative to the
+    /// oldest frame.
+    static void exportCsv(QTextStream& stream);
+    static void reset();
+
+private:
+    FrameStats() {}
+};
+
+#endif // FRAMESTATS_H
@@ -32,6 +32,8 @@
 #include "qmltypes/qmlutilities.h"
 #include "qmltypes/qmlfilter.h"
 #include "mainwindow.h"
+#include "widgets/scopes/scopeframecache.h"
+#include "framestats.h"
 
 #define USE_GL_SYNC // Use glFinish() if not defined.
 
@@ -52,6 +54,9 @@ static ClientWaitSync_fp ClientWaitSync = 0;
 
 using namespace Mlt;
 
+// The number of frames the consumer can queue to the FrameRenderer
+static const int kFrameQueueSize = 3;
+
 GLWidget::GLWidget(QObject *parent)
     : QQuickWidget(QmlUtilities::sharedEngine(), (QWidget*) parent)
     , Controller()
@@ -69,6 +74,7 @@ GLWidget::GLWidget(QObject *parent)
     , m_offset(QPoint(0, 0))
     , m_shareContext(0)
     , m_snapToGrid(true)
+    , m_scopeFramesEnabled(false)
 {
     LOG_DEBUG() << "begin";
     m_texture[0] = m_texture[1] = m_texture[2] = 0;
@@ -167,12 +173,14 @@ void GLWidget::initializeGL()
         m_shareContext->create();
     }
     m_frameRenderer = new FrameRenderer(quickWindow()->openglContext(), &m_offscreenSurface);
+    m_frameRenderer->setScopeFramesEnabled(m_scopeFramesEnabled);
     quickWindow()->openglContext()->makeCurrent(quickWindow());
 
     connect(m_frameRenderer, SIGNAL(frameDisplayed(const SharedFrame&)), SLOT(onFrameDisplayed(const SharedFrame&)), Qt::QueuedConnection);
     connect(m_frameRenderer, SIGNAL(frameDisplayed(const SharedFrame&)), SIGNAL(frameDisplayed(const SharedFrame&)), Qt::QueuedConnection);
     connect(m_frameRenderer, SIGNAL(textureReady(GLuint,GLuint,GLuint)), SLOT(updateTexture(GLuint,GLuint,GLuint)), Qt::DirectConnection);
     connect(m_frameRenderer, SIGNAL(imageReady()), SIGNAL(imageReady()));
+    connect(m_frameRenderer, SIGNAL(scopeFrameReady(const SharedFrame&)), SIGNAL(scopeFrameReady(const SharedFrame&)), Qt::QueuedConnection);
 
     m_initSem.release();
     m_isInitialized = true;
@@ -462,6 +470,7 @@ void GLWidget::paintGL()
         glFinish(); check_error(f);
         m_mutex.unlock();
     }
+    FrameStats::painted(1000.0 / MLT.profile().fps());
 }
 
 void GLWidget::mousePressEvent(QMouseEvent* event)
@@ -742,6 +751,8 @@ void GLWidget::requestImage() const
 
 void GLWidget::onFrameDisplayed(const SharedFrame &frame)
 {
+    LOG_SPAN("frame displayed");
+    loggerSpan.setArgument("position", frame.get_position());
     m_mutex.lock();
     m_sharedFrame = frame;
     m_mutex.unlock();
@@ -801,6 +812,13 @@ void GLWidget::setSnapToGrid(bool snap)
     emit snapToGridChanged();
 }
 
+void GLWidget::setScopeFramesEnabled(bool enabled)
+{
+    m_scopeFramesEnabled = enabled;
+    if (m_frameRenderer)
+        m_frameRenderer->setScopeFramesEnabled(enabled);
+}
+
 void GLWidget::updateTexture(GLuint yName, GLuint uName, GLuint vName)
 {
     m_texture[0] = yName;
@@ -813,13 +831,19 @@ void GLWidget::on_frame_show(mlt_consumer, void* self, mlt_frame frame_ptr)
 {
     Mlt::Frame frame(frame_ptr);
     if (frame.get_int("rendered")) {
+        quint32 deliveredTime = FrameStats::now();
         GLWidget* widget = static_cast<GLWidget*>(self);
         int timeout = (widget->consumer()->get_int("real_time") > 0)? 0: 1000;
         if (widget->m_frameRenderer && widget->m_frameRenderer->semaphore()->tryAcquire(1, timeout)) {
+            FrameStats::queued(frame.get_position(), deliveredTime, kFrameQueueSize - widget->m_frameRenderer->semaphore()->available());
             QMetaObject::invokeMethod(widget->m_frameRenderer, "showFrame", Qt::QueuedConnection, Q_ARG(Mlt::Frame, frame));
-        } else if (!Settings.playerRealtime()) {
-            LOG_WARNING() << "GLWidget dropped frame" << frame.get_position();
+        } else {
+            FrameStats::dropped();
+            if (!Settings.playerRealtime())
+                LOG_WARNING() << "GLWidget dropped frame" << frame.get_position();
         }
+    } else {
+        FrameStats::skipped();
     }
 }
 
@@ -853,16 +877,30 @@ void RenderThread::run()
 
 FrameRenderer::FrameRenderer(QOpenGLContext* shareContext, QSurface* surface)
      : QThread(0)
-     , m_semaphore(3)
+     , m_semaphore(kFrameQueueSize)
      , m_context(0)
      , m_surface(surface)
      , m_previousMSecs(QDateTime::currentMSecsSinceEpoch())
      , m_imageRequested(false)
+     , m_scopeFramesEnabled(false)
+     , m_scopeGl(0)
+     , m_scopeTexture(0)
+     , m_scopeNextBuffer(0)
+     , m_scopePendingBuffer(-1)
+     , m_scopePendingPosition(0)
      , m_gl32(0)
 {
     Q_ASSERT(shareContext);
     m_renderTexture[0] = m_renderTexture[1] = m_renderTexture[2] = 0;
     m_displayTexture[0] = m_displayTexture[1] = m_displayTexture[2] = 0;
+    m_scopeFramebuffers[0] = m_scopeFramebuffers[1] = 0;
+    m_scopePixelBuffers[0] = m_scopePixelBuffers[1] = 0;
+    // Publishes the last scope frame when paused, when no next frame arrives
+    // to trigger it.
+    m_scopeTimer = new QTimer(this);
+    m_scopeTimer->setSingleShot(true);
+    m_scopeTimer->setInterval(40);
+    connect(m_scopeTimer, SIGNAL(timeout()), SLOT(onScopeReadbackTimeout()));
     if (Settings.playerGPU() || shareContext->supportsThreadedOpenGL()) {
         m_context = new QOpenGLContext;
         m_context->setFormat(shareContext->format());
@@ -884,6 +922,9 @@ FrameRenderer::~FrameRenderer()
 
 void FrameRenderer::showFrame(Mlt::Frame frame)
 {
+    LOG_SPAN("show frame");
+    loggerSpan.setArgument("position", frame.get_position());
+    FrameStats::record(FrameStats::RenderStage, frame.get_position());
     int width = 0;
     int height = 0;
 
@@ -894,6 +935,7 @@ void FrameRenderer::showFrame(Mlt::Frame frame)
         int height = 0;
         frame.get_image(format, width, height);
         m_displayFrame = SharedFrame(frame);
+        FrameStats::record(FrameStats::UploadedStage);
     }
 
     Q_ASSERT(m_surface->surfaceHandle());
@@ -929,6 +971,9 @@ void FrameRenderer::showFrame(Mlt::Frame frame)
             m_context->functions()->glFinish();
 #endif // USE_GL_FENCE
 
+            if (m_scopeFramesEnabled && textureId)
+                readbackScopeFrame(*textureId, width, height, frame.get_position());
+
             if (m_imageRequested) {
                 m_imageRequested = false;
                 int imageSizeBytes = width * height * 4;
@@ -951,6 +996,7 @@ void FrameRenderer::showFrame(Mlt::Frame frame)
 
             // Save this frame for future use and to keep a reference to the GL Texture.
             m_displayFrame = SharedFrame(frame);
+            FrameStats::record(FrameStats::UploadedStage);
         }
         else {
             // Using a threaded OpenGL to upload textures.
@@ -961,6 +1007,7 @@ void FrameRenderer::showFrame(Mlt::Frame frame)
             f->glBindTexture(GL_TEXTURE_2D, 0);
             check_error(f);
             f->glFinish();
+            FrameStats::record(FrameStats::UploadedStage);
 
             for (int i = 0; i < 3; ++i)
                 qSwap(m_renderTexture[i], m_displayTexture[i]);
@@ -968,6 +1015,7 @@ void FrameRenderer::showFrame(Mlt::Frame frame)
             m_context->doneCurrent();
         }
     }
+    FrameStats::record(FrameStats::DisplayedStage);
     emit frameDisplayed(m_displayFrame);
 
     m_semaphore.release();
@@ -983,9 +1031,134 @@ SharedFrame FrameRenderer::getDisplayFrame()
     return m_displayFrame;
 }
 
+void FrameRenderer::readbackScopeFrame(GLuint texture, int width, int height, int position)
+{
+    if (!m_scopeGl) {
+        m_scopeGl = m_context->versionFunctions<QOpenGLFunctions_3_2_Core>();
+        if (!m_scopeGl || !m_scopeGl->initializeOpenGLFunctions()) {
+            LOG_WARNING() << "OpenGL 3.2 is required for the video scopes with GPU processing";
+            m_scopeGl = 0;
+            m_scopeFramesEnabled = false;
+            return;
+        }
+    }
+    QOpenGLFunctions_3_2_Core* f = m_scopeGl;
+
+    // The pending read was started for the previous frame and is complete by now.
+    if (m_scopePendingBuffer >= 0)
+        publishScopeFrame();
+
+    // Downscale to the size the scopes use, keeping the dimensions even for yuv420p.
+    int scaledWidth = qMin(width, int(ScopeFrameCache::kMaxWidth));
+    int scaledHeight = height * scaledWidth / qMax(1, width);
+    QSize size(qMax(2, scaledWidth & ~1), qMax(2, scaledHeight & ~1));
+    if (size != m_scopeSize) {
+        deleteScopeBuffers();
+        f->glGenTextures(1, &m_scopeTexture);
+        f->glBindTexture(GL_TEXTURE_2D, m_scopeTexture);
+        f->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.width(), size.height(), 0, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+        f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        f->glBindTexture(GL_TEXTURE_2D, 0);
+        f->glGenFramebuffers(2, m_scopeFramebuffers);
+        f->glBindFramebuffer(GL_FRAMEBUFFER, m_scopeFramebuffers[1]);
+        f->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_scopeTexture, 0);
+        f->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        f->glGenBuffers(2, m_scopePixelBuffers);
+        for (int i = 0; i < 2; ++i) {
+            f->glBindBuffer(GL_PIXEL_PACK_BUFFER, m_scopePixelBuffers[i]);
+            f->glBufferData(GL_PIXEL_PACK_BUFFER, size.width() * size.height() * 4, 0, GL_STREAM_READ);
+        }
+        f->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        check_error(f);
+        m_scopeSize = size;
+        m_scopeNextBuffer = 0;
+    }
+
+    // Scale the frame texture into the scope texture.
+    f->glBindFramebuffer(GL_READ_FRAMEBUFFER, m_scopeFramebuffers[0]);
+    f->glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    f->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_scopeFramebuffers[1]);
+    f->glBlitFramebuffer(0, 0, width, height, 0, 0, size.width(), size.height(), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    f->glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    check_error(f);
+
+    // Start reading it into a pixel buffer without waiting for it.
+    f->glBindFramebuffer(GL_READ_FRAMEBUFFER, m_scopeFramebuffers[1]);
+    f->glReadBuffer(GL_COLOR_ATTACHMENT0);
+    f->glBindBuffer(GL_PIXEL_PACK_BUFFER, m_scopePixelBuffers[m_scopeNextBuffer]);
+    f->glReadPixels(0, 0, size.width(), size.height(), GL_BGRA, GL_UNSIGNED_BYTE, 0);
+    f->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    f->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    check_error(f);
+
+    m_scopePendingBuffer = m_scopeNextBuffer;
+    m_scopePendingPosition = position;
+    m_scopeNextBuffer = (m_scopeNextBuffer + 1) % 2;
+    m_scopeTimer->start();
+}
+
+void FrameRenderer::publishScopeFrame()
+{
+    QOpenGLFunctions_3_2_Core* f = m_scopeGl;
+    int width = m_scopeSize.width();
+    int height = m_scopeSize.height();
+
+    f->glBindBuffer(GL_PIXEL_PACK_BUFFER, m_scopePixelBuffers[m_scopePendingBuffer]);
+    m_scopePendingBuffer = -1;
+    const uint8_t* bgra = (const uint8_t*) f->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, width * height * 4, GL_MAP_READ_BIT);
+    if (bgra) {
+        int imageSizeBytes = width * height * 3 / 2;
+        uint8_t* image = (uint8_t*) mlt_pool_alloc(imageSizeBytes);
+        ScopeFrameCache::convertFromBgra(bgra, width, height, image);
+        f->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+        Mlt::Frame frame(mlt_frame_init(NULL));
+        frame.set("image", image, imageSizeBytes, mlt_pool_release);
+        frame.set("format", mlt_image_yuv420p);
+        frame.set("width", width);
+        frame.set("height", height);
+        mlt_frame_set_position(frame.get_frame(), m_scopePendingPosition);
+        // Release the reference from mlt_frame_init().
+        mlt_frame_close(frame.get_frame());
+        emit scopeFrameReady(SharedFrame(frame));
+    }
+    f->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    check_error(f);
+}
+
+void FrameRenderer::onScopeReadbackTimeout()
+{
+    if (m_scopePendingBuffer >= 0 && m_context && m_context->isValid()) {
+        m_context->makeCurrent(m_surface);
+        publishScopeFrame();
+        m_context->doneCurrent();
+    }
+}
+
+void FrameRenderer::deleteScopeBuffers()
+{
+    if (m_scopeGl && m_scopeTexture) {
+        m_scopeGl->glDeleteFramebuffers(2, m_scopeFramebuffers);
+        m_scopeGl->glDeleteBuffers(2, m_scopePixelBuffers);
+        m_scopeGl->glDeleteTextures(1, &m_scopeTexture);
+        m_scopeFramebuffers[0] = m_scopeFramebuffers[1] = 0;
+        m_scopePixelBuffers[0] = m_scopePixelBuffers[1] = 0;
+        m_scopeTexture = 0;
+    }
+    m_scopeSize = QSize();
+    m_scopePendingBuffer = -1;
+}
+
 void FrameRenderer::cleanup()
 {
     LOG_DEBUG() << "begin";
+    if (m_scopeTexture) {
+        m_scopeTimer->stop();
+        m_context->makeCurrent(m_surface);
+        deleteScopeBuffers();
+        m_context->doneCurrent();
+    }
     if (m_renderTexture[0] && m_renderTexture[1] && m_renderTexture[2]) {
         m_context->makeCurrent(m_surface);
         m_context->functions()->glDeleteTextures(3, m_renderTexture);
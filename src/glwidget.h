@@ -28,11 +28,13 @@
 #include <QMutex>
 #include <QThread>
 #include <QRect>
+#include <QAtomicInt>
 #include "mltcontroller.h"
 #include "sharedframe.h"
 
 class QOpenGLFunctions_3_2_Core;
 class QOpenGLTexture;
+class QTimer;
 class QmlFilter;
 class QmlMetadata;
 
@@ -98,9 +100,11 @@ public slots:
     void setBlankScene();
     void setCurrentFilter(QmlFilter* filter, QmlMetadata* meta);
     void setSnapToGrid(bool snap);
+    void setScopeFramesEnabled(bool enabled);
 
 signals:
     void frameDisplayed(const SharedFrame& frame);
+    void scopeFrameReady(const SharedFrame& frame);
     void dragStarted();
     void seekTo(int x);
     void gpuNotSupported();
@@ -142,6 +146,7 @@ private:
     QMutex m_mutex;
     QUrl m_savedQmlSource;
     bool m_snapToGrid;
+    bool m_scopeFramesEnabled;
 
     static void on_frame_show(mlt_consumer, void* self, mlt_frame frame);
 
@@ -188,6 +193,7 @@ public:
     Q_INVOKABLE void showFrame(Mlt::Frame frame);
     void requestImage();
     QImage image() const { return m_image; }
+    void setScopeFramesEnabled(bool enabled) { m_scopeFramesEnabled = enabled; }
 
 public slots:
     void cleanup();
@@ -196,8 +202,16 @@ signals:
     void textureReady(GLuint yName, GLuint uName = 0, GLuint vName = 0);
     void frameDisplayed(const SharedFrame& frame);
     void imageReady();
+    void scopeFrameReady(const SharedFrame& frame);
+
+private slots:
+    void onScopeReadbackTimeout();
 
 private:
+    void readbackScopeFrame(GLuint texture, int width, int height, int position);
+    void publishScopeFrame();
+    void deleteScopeBuffers();
+
     QSemaphore m_semaphore;
     SharedFrame m_displayFrame;
     QOpenGLContext* m_context;
@@ -206,6 +220,18 @@ private:
     bool m_imageRequested;
     QImage m_image;
 
+    // Reading back a reduced size copy of the GPU image for the video scopes
+    QAtomicInt m_scopeFramesEnabled;
+    QOpenGLFunctions_3_2_Core* m_scopeGl;
+    GLuint m_scopeFramebuffers[2];
+    GLuint m_scopeTexture;
+    GLuint m_scopePixelBuffers[2];
+    QSize m_scopeSize;
+    int m_scopeNextBuffer;
+    int m_scopePendingBuffer;
+    int m_scopePendingPosition;
+    QTimer* m_scopeTimer;
+
 public:
     GLuint m_renderTexture[3];
     GLuint m_displayTexture[3];
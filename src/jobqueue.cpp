@@ -114,7 +114,7 @@ void JobQueue::startNextJob()
     if (!m_jobs.isEmpty()) {
         foreach(AbstractJob* job, m_jobs) {
             // if there is already a job started or running, then exit
-            if (job->ran() && job->state() != QProcess::NotRunning)
+            if (job->ran() && job->isRunning())
                 break;
             // otherwise, start first non-started job and exit
             if (!job->ran()) {
@@ -149,7 +149,7 @@ bool JobQueue::isPaused() const
 bool JobQueue::hasIncomplete() const
 {
     foreach (AbstractJob* job, m_jobs) {
-        if (!job->ran() || job->state() == QProcess::Running)
+        if (!job->ran() || job->isRunning())
             return true;
     }
     return false;
@@ -45,6 +45,11 @@ void AbstractJob::start()
     m_ran = true;
     m_estimateTime.start();
     m_totalTime.start();
+    if (cuteLogger->isTracing()) {
+        QVariantMap args;
+        args.insert("label", m_label);
+        cuteLogger->writeTraceEvent('b', "job", Logger::traceTimestamp(), 0, quintptr(this), args);
+    }
     emit progressUpdated(m_item, 0);
 }
 
@@ -68,6 +73,11 @@ bool AbstractJob::stopped() const
     return m_killed;
 }
 
+bool AbstractJob::isRunning() const
+{
+    return state() != QProcess::NotRunning;
+}
+
 void AbstractJob::appendToLog(const QString& s)
 {
     m_log.append(s);
@@ -110,6 +120,9 @@ void AbstractJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
     m_log.append(readAll());
     const QTime& time = QTime::fromMSecsSinceStartOfDay(m_totalTime.elapsed());
+    QVariantMap args;
+    args.insert("exitCode", exitCode);
+    traceFinished(args);
     if (exitStatus == QProcess::NormalExit && exitCode == 0 && !m_killed) {
         if (m_postJobAction) {
             m_postJobAction->doAction();
@@ -129,6 +142,15 @@ void AbstractJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
     }
 }
 
+void AbstractJob::traceFinished(const QVariantMap& args)
+{
+    if (cuteLogger->isTracing()) {
+        QVariantMap eventArgs(args);
+        eventArgs.insert("stopped", m_killed);
+        cuteLogger->writeTraceEvent('e', "job", Logger::traceTimestamp(), 0, quintptr(this), eventArgs);
+    }
+}
+
 void AbstractJob::onReadyRead()
 {
     QString msg;
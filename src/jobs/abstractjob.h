@@ -23,6 +23,7 @@
 #include <QModelIndex>
 #include <QList>
 #include <QTime>
+#include <QVariantMap>
 
 class QAction;
 class QStandardItem;
@@ -38,6 +39,7 @@ public:
     QStandardItem* standardItem();
     bool ran() const;
     bool stopped() const;
+    virtual bool isRunning() const;
     void appendToLog(const QString&);
     QString log() const;
     QString label() const { return m_label; }
@@ -61,6 +63,12 @@ protected:
     QList<QAction*> m_successActions;
     QStandardItem*  m_item;
 
+    /// Ends the trace span that start() began. Every path that finishes or
+    /// restarts the job must call this.
+    void traceFinished(const QVariantMap& args);
+    /// Marks the job stopped by the user, for a job that does not run a process.
+    void setStopped() { m_killed = true; }
+
 protected slots:
     virtual void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
     virtual void onReadyRead();
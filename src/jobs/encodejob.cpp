@@ -136,6 +136,10 @@ void EncodeJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
             QTextStream textStream(&m_xml);
             dom.save(textStream, 2);
             m_xml.close();
+            QVariantMap args;
+            args.insert("exitCode", exitCode);
+            args.insert("retry", true);
+            traceFinished(args);
             MeltJob::start();
             return;
         }
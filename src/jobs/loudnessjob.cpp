@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "loudnessjob.h"
+#include "database.h"
+#include "loudnessmeter.h"
+#include "mainwindow.h"
+#include "mediaanalysisscheduler.h"
+#include "mltcontroller.h"
+#include "qmltypes/qmlfilter.h"
+#include "shotcut_mlt_properties.h"
+#include <QRunnable>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QFileInfo>
+#include <QScopedPointer>
+#include <QTime>
+#include <MltProducer.h>
+#include <MltProfile.h>
+#include <Logger.h>
+#include <cmath>
+#include <limits>
+
+// These match the defaults of an export, which the melt analysis used.
+static const int kChannels = 2;
+static const int kFrequency = 48000;
+static const int kProgressIntervalMs = 1000;
+
+// Shared with the tasks, which may outlive the job.
+struct LoudnessJobState
+{
+    QMutex mutex; // protects job
+    LoudnessJob* job;
+    QAtomicInt isCanceled;
+
+    LoudnessJobState(LoudnessJob* job)
+        : job(job)
+        , isCanceled(0)
+    {}
+};
+
+class LoudnessTask : public QRunnable
+{
+public:
+    LoudnessTask(QSharedPointer<LoudnessJobState> state, int index, const LoudnessJob::Entry& entry)
+        : QRunnable()
+        , m_state(state)
+        , m_index(index)
+        , m_entry(entry)
+        , m_frameRateNum(MLT.profile().frame_rate_num())
+        , m_frameRateDen(MLT.profile().frame_rate_den())
+    {}
+
+    void run()
+    {
+        QString results;
+        QString log;
+        if (!m_state->isCanceled.load()) {
+            QString key = cacheKey();
+            if (!key.isEmpty() && !DB.isShutdown())
+                results = DB.getLoudness(key);
+            if (!results.isEmpty()) {
+                log = QString("%1: using cached results\n").arg(m_entry.label);
+            } else {
+                QTime time;
+                time.start();
+                results = measure(log);
+                LOG_INFO() << "measured loudness of" << m_entry.label << "in" << time.elapsed() << "ms";
+                if (!results.isEmpty() && !key.isEmpty() && !DB.isShutdown())
+                    DB.putLoudness(key, results);
+            }
+        }
+        QMutexLocker locker(&m_state->mutex);
+        if (m_state->job)
+            QMetaObject::invokeMethod(m_state->job, "onTaskFinished", Qt::QueuedConnection,
+                                      Q_ARG(int, m_index), Q_ARG(QString, results), Q_ARG(QString, log));
+    }
+
+private:
+    QString cacheKey()
+    {
+        if (m_entry.resource.isEmpty())
+            return QString();
+        QString hash = m_entry.hash;
+        if (hash.isEmpty())
+            hash = MAIN.getFileHash(m_entry.resource);
+        if (hash.isEmpty())
+            return QString();
+        return QString("%1 %2 %3 %4 loudness").arg(hash).arg(m_entry.inTime)
+                .arg(m_entry.outTime).arg(m_entry.audioIndex);
+    }
+
+    Mlt::Producer* createProducer(Mlt::Profile& profile)
+    {
+        Mlt::Producer* producer = 0;
+        if (!m_entry.resource.isEmpty()) {
+            QString service = m_entry.service;
+            if (service == "avformat-novalidate")
+                service = "avformat";
+            producer = new Mlt::Producer(profile, service.toUtf8().constData(),
+                                         m_entry.resource.toUtf8().constData());
+            if (producer->is_valid()) {
+                // Skip the video stream so that only the audio is demuxed and decoded.
+                producer->set("video_index", -1);
+                if (!m_entry.audioIndex.isEmpty())
+                    producer->set("audio_index", m_entry.audioIndex.toUtf8().constData());
+                Mlt::Filter channels(profile, "audiochannels");
+                QScopedPointer<Mlt::Filter> resampler(new Mlt::Filter(profile, "swresample"));
+                if (!resampler->is_valid())
+                    resampler.reset(new Mlt::Filter(profile, "resample"));
+                Mlt::Filter converter(profile, "audioconvert");
+                producer->attach(channels);
+                if (resampler->is_valid())
+                    producer->attach(*resampler);
+                producer->attach(converter);
+                producer->set_in_and_out(m_entry.in, m_entry.out);
+            }
+        } else {
+            producer = new Mlt::Producer(profile, "xml-string", m_entry.xml.toUtf8().constData());
+        }
+        return producer;
+    }
+
+    QString measure(QString& log)
+    {
+        Mlt::Profile profile;
+        profile.set_frame_rate(m_frameRateNum, m_frameRateDen);
+        QScopedPointer<Mlt::Producer> producer(createProducer(profile));
+        if (!producer || !producer->is_valid()) {
+            log = QString("%1: failed to open\n").arg(m_entry.label);
+            return QString();
+        }
+
+        LoudnessMeter meter;
+        meter.setFormat(kChannels, kFrequency);
+        double samplePeak = -std::numeric_limits<double>::infinity();
+        double fps = profile.fps();
+        int first = m_entry.resource.isEmpty()? 0 : m_entry.in;
+        int n = producer->get_playtime();
+        QTime progressTime;
+        progressTime.start();
+        for (int i = 0; i < n && !m_state->isCanceled.load(); i++) {
+            QScopedPointer<Mlt::Frame> frame(producer->get_frame());
+            if (frame && frame->is_valid() && !frame->get_int("test_audio")) {
+                mlt_audio_format format = mlt_audio_float;
+                int frequency = kFrequency;
+                int channels = kChannels;
+                int samples = mlt_sample_calculator(fps, frequency, first + i);
+                const float* data = (const float*) frame->get_audio(format, frequency, channels, samples);
+                if (data && format == mlt_audio_float && frequency == kFrequency
+                        && channels == kChannels && samples > 0) {
+                    const float* planes[kChannels];
+                    for (int c = 0; c < kChannels; c++)
+                        planes[c] = data + c * samples;
+                    meter.process(planes, samples);
+                    samplePeak = qMax(samplePeak, meter.samplePeak());
+                }
+            }
+            if (progressTime.elapsed() > kProgressIntervalMs) {
+                progressTime.restart();
+                QMutexLocker locker(&m_state->mutex);
+                if (m_state->job)
+                    QMetaObject::invokeMethod(m_state->job, "onTaskProgress", Qt::QueuedConnection,
+                                              Q_ARG(int, m_index), Q_ARG(int, 100 * i / n));
+            }
+        }
+        if (m_state->isCanceled.load())
+            return QString();
+
+        double integrated = meter.integrated();
+        if (!std::isfinite(integrated)) {
+            log = QString("%1: no audio above the absolute gate\n").arg(m_entry.label);
+            return QString();
+        }
+        double range = std::isfinite(meter.range())? meter.range() : 0.0;
+        double truePeak = meter.maxTruePeak();
+        log = QString("%1: integrated %2 LUFS, range %3 LU, true peak %4 dBTP\n")
+                .arg(m_entry.label).arg(integrated, 0, 'f', 1).arg(range, 0, 'f', 1)
+                .arg(truePeak, 0, 'f', 1);
+        return LoudnessJob::resultsString(integrated, range, std::pow(10.0, samplePeak / 20.0), truePeak);
+    }
+
+    QSharedPointer<LoudnessJobState> m_state;
+    int m_index;
+    LoudnessJob::Entry m_entry;
+    int m_frameRateNum;
+    int m_frameRateDen;
+};
+
+LoudnessJob::LoudnessJob(const QString& name)
+    : AbstractJob(name)
+    , m_state(new LoudnessJobState(this))
+    , m_running(0)
+    , m_percent(0)
+    , m_isSuccess(true)
+{
+}
+
+LoudnessJob::~LoudnessJob()
+{
+    m_state->isCanceled = 1;
+    m_state->mutex.lock();
+    m_state->job = 0;
+    m_state->mutex.unlock();
+    ANALYSIS.cancel(this);
+    foreach (Entry entry, m_entries)
+        delete entry.delegate;
+}
+
+void LoudnessJob::addFilter(Mlt::Service& service, Mlt::Filter& filter)
+{
+    Entry entry;
+    entry.in = 0;
+    entry.out = 0;
+    entry.length = 0;
+    entry.percent = 0;
+    entry.isFinished = false;
+    filter.set("results", NULL, 0);
+    entry.delegate = new AnalyzeDelegate(filter);
+
+    int index = 0;
+    for (; index < service.filter_count(); index++) {
+        QScopedPointer<Mlt::Filter> f(service.filter(index));
+        if (f && f->get_filter() == filter.get_filter())
+            break;
+    }
+
+    // Read a clip of a media file directly unless it is affected by a filter
+    // before this one.
+    Mlt::Producer producer(service);
+    Mlt::Producer parent(producer.is_cut()? producer.parent() : producer);
+    QString serviceName = QString::fromLatin1(parent.get("mlt_service"));
+    bool isDirect = service.type() == producer_type && serviceName.startsWith("avformat");
+    for (int i = 0; isDirect && i < index; i++) {
+        QScopedPointer<Mlt::Filter> f(service.filter(i));
+        isDirect = !f || f->get_int("_loader") || f->get_int("disable");
+    }
+    for (int i = 0; isDirect && producer.is_cut() && i < parent.filter_count(); i++) {
+        QScopedPointer<Mlt::Filter> f(parent.filter(i));
+        isDirect = !f || f->get_int("_loader") || f->get_int("disable");
+    }
+
+    if (isDirect) {
+        entry.service = serviceName;
+        entry.resource = QString::fromUtf8(parent.get("resource"));
+        entry.hash = QString::fromLatin1(parent.get(kShotcutHashProperty));
+        entry.audioIndex = QString::fromLatin1(producer.get("audio_index")?
+                                               producer.get("audio_index") : parent.get("audio_index"));
+        entry.in = producer.get_in();
+        entry.out = producer.get_out();
+        entry.inTime = QString::fromLatin1(producer.frames_to_time(entry.in, mlt_time_clock));
+        entry.outTime = QString::fromLatin1(producer.frames_to_time(entry.out, mlt_time_clock));
+        entry.length = entry.out - entry.in + 1;
+        entry.label = QFileInfo(entry.resource).fileName();
+    } else {
+        // Measure the output of the service without this and the following filters.
+        QList<int> disabled;
+        for (int i = index; i < service.filter_count(); i++) {
+            QScopedPointer<Mlt::Filter> f(service.filter(i));
+            disabled << f->get_int("disable");
+            f->set("disable", 1);
+        }
+        entry.xml = MLT.XML(&service);
+        for (int i = 0; i < disabled.size(); i++) {
+            QScopedPointer<Mlt::Filter> f(service.filter(index + i));
+            f->set("disable", disabled.at(i));
+        }
+        entry.length = producer.get_playtime();
+        entry.label = QFileInfo(QString::fromUtf8(service.get("resource"))).fileName();
+        if (entry.label.isEmpty())
+            entry.label = QString::fromLatin1(service.get("mlt_service"));
+    }
+    m_entries << entry;
+}
+
+bool LoudnessJob::isRunning() const
+{
+    return m_running > 0;
+}
+
+QString LoudnessJob::resultsString(double integrated, double range, double samplePeak, double truePeak)
+{
+    // The loudness filter only reads the first three values.
+    return QString("L: %1\tR: %2\tP %3\tTP: %4").arg(integrated, 0, 'f', 6).arg(range, 0, 'f', 6)
+            .arg(samplePeak, 0, 'f', 6).arg(truePeak, 0, 'f', 6);
+}
+
+void LoudnessJob::start()
+{
+    if (m_running) {
+        LOG_WARNING() << "loudness job started while" << m_running << "tasks are pending";
+        return;
+    }
+    AbstractJob::start();
+    m_state->isCanceled = 0;
+    m_isSuccess = true;
+    m_percent = 0;
+    for (int i = 0; i < m_entries.size(); i++) {
+        if (m_entries.at(i).isFinished)
+            continue;
+        ++m_running;
+        m_entries[i].percent = 0;
+        ANALYSIS.start(new LoudnessTask(m_state, i, m_entries.at(i)), m_entries.at(i).resource, this);
+    }
+    LOG_DEBUG() << "analyzing loudness of" << m_running << "services";
+    if (!m_running)
+        onTaskFinished(-1, QString(), QString());
+}
+
+void LoudnessJob::stop()
+{
+    // There is no process to terminate. The tasks see the flag and finish
+    // without analyzing, and the last one finishes the job.
+    setStopped();
+    m_state->isCanceled = 1;
+}
+
+void LoudnessJob::onTaskProgress(int index, int percent)
+{
+    if (index >= 0 && index < m_entries.size()) {
+        m_entries[index].percent = percent;
+        updateProgress();
+    }
+}
+
+void LoudnessJob::onTaskFinished(int index, const QString& results, const QString& log)
+{
+    if (index >= 0 && index < m_entries.size()) {
+        Entry& entry = m_entries[index];
+        --m_running;
+        appendToLog(log);
+        if (!results.isEmpty()) {
+            entry.delegate->applyResults(results);
+            entry.delegate->deleteLater();
+            entry.delegate = 0;
+            entry.isFinished = true;
+            entry.percent = 100;
+        } else {
+            m_isSuccess = false;
+        }
+        updateProgress();
+    }
+    if (m_running)
+        return;
+
+    const QTime& time = QTime::fromMSecsSinceStartOfDay(this->time().elapsed());
+    QVariantMap args;
+    args.insert("success", m_isSuccess);
+    traceFinished(args);
+    if (stopped()) {
+        LOG_INFO() << "job stopped";
+        appendToLog(QString("Stopped by user at %1\n").arg(time.toString()));
+        emit finished(this, false);
+    } else if (m_isSuccess) {
+        LOG_INFO() << "job succeeeded";
+        appendToLog(QString("Completed successfully in %1\n").arg(time.toString()));
+        emit progressUpdated(m_item, 100);
+        emit finished(this, true);
+    } else {
+        LOG_INFO() << "job failed";
+        appendToLog(QString("Failed\n"));
+        emit finished(this, false);
+    }
+}
+
+void LoudnessJob::updateProgress()
+{
+    qint64 total = 0;
+    qint64 done = 0;
+    foreach (Entry entry, m_entries) {
+        int length = qMax(1, entry.length);
+        total += length;
+        done += qint64(length) * entry.percent / 100;
+    }
+    int percent = total? int(100 * done / total) : 0;
+    if (percent != m_percent && percent < 100) {
+        m_percent = percent;
+        emit progressUpdated(m_item, percent);
+    }
+}
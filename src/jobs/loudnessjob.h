@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOUDNESSJOB_H
+#define LOUDNESSJOB_H
+
+#include "abstractjob.h"
+#include <QList>
+#include <QSharedPointer>
+#include <MltFilter.h>
+#include <MltService.h>
+
+class AnalyzeDelegate;
+struct LoudnessJobState;
+
+/// Measures the EBU R128 loudness for a set of loudness filters without melt.
+///
+/// The job holds a place in the job queue so that exports queued after it
+/// receive its results, but it does not run a process. Instead, each filter
+/// becomes a task on the media analysis scheduler that decodes only the audio,
+/// so many clips are measured in parallel. When a filter is attached directly
+/// to a clip of a media file, the results are cached in the database by the
+/// file hash, in and out points and audio stream, making a second analysis of
+/// the same clip nearly instant.
+class LoudnessJob : public AbstractJob
+{
+    Q_OBJECT
+public:
+    explicit LoudnessJob(const QString& name);
+    virtual ~LoudnessJob();
+
+    /// Adds the filter to analyze, which must be attached to service.
+    void addFilter(Mlt::Service& service, Mlt::Filter& filter);
+    int count() const { return m_entries.size(); }
+    bool isRunning() const;
+
+    /// Formats results as the loudness filter expects them.
+    static QString resultsString(double integrated, double range, double samplePeak, double truePeak);
+
+public slots:
+    void start();
+    void stop();
+
+private slots:
+    void onTaskProgress(int index, int percent);
+    void onTaskFinished(int index, const QString& results, const QString& log);
+
+private:
+    friend class LoudnessTask;
+
+    struct Entry {
+        QString label;
+        // Set when the audio can be read directly from a file.
+        QString service;
+        QString resource;
+        QString hash;
+        QString audioIndex;
+        int in;
+        int out;
+        QString inTime;
+        QString outTime;
+        // Otherwise, the XML of the service up to the filter.
+        QString xml;
+        int length;
+        AnalyzeDelegate* delegate;
+        int percent;
+        bool isFinished;
+    };
+
+    void updateProgress();
+
+    QList<Entry> m_entries;
+    QSharedPointer<LoudnessJobState> m_state;
+    int m_running;
+    int m_percent;
+    bool m_isSuccess;
+};
+
+#endif // LOUDNESSJOB_H
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "loudnessmeter.h"
+#include <cmath>
+#include <limits>
+
+static const double kAbsoluteGate = -70.0;
+static const int kHistogramBins = 1000; // 0.1 LU from -70 to +30 LUFS
+static const int kMomentarySubblocks = 4;
+static const int kShortTermSubblocks = 30;
+static const int kTruePeakPhases = 4;
+static const int kTruePeakTaps = 12; // per phase
+
+static double energyToLoudness(double energy)
+{
+    return energy > 0.0? -0.691 + 10.0 * std::log10(energy) : -std::numeric_limits<double>::infinity();
+}
+
+static int histogramBin(double loudness)
+{
+    return qBound(0, int((loudness - kAbsoluteGate) * 10.0), kHistogramBins - 1);
+}
+
+static double toDecibels(double value)
+{
+    return value > 0.0? 20.0 * std::log10(value) : -std::numeric_limits<double>::infinity();
+}
+
+// A windowed sinc interpolation filter for 4x oversampling, split into phases.
+static const float* truePeakCoefficients()
+{
+    static float coefficients[kTruePeakPhases * kTruePeakTaps];
+    static bool initialized = false;
+    if (!initialized) {
+        const int length = kTruePeakPhases * kTruePeakTaps;
+        for (int phase = 0; phase < kTruePeakPhases; ++phase) {
+            double sum = 0.0;
+            for (int tap = 0; tap < kTruePeakTaps; ++tap) {
+                int n = tap * kTruePeakPhases + phase;
+                double t = (n - (length - 1) / 2.0) / kTruePeakPhases;
+                double sinc = t == 0.0? 1.0 : std::sin(M_PI * t) / (M_PI * t);
+                double window = 0.5 - 0.5 * std::cos(2.0 * M_PI * (n + 0.5) / length);
+                coefficients[phase * kTruePeakTaps + tap] = float(sinc * window);
+                sum += sinc * window;
+            }
+            for (int tap = 0; tap < kTruePeakTaps; ++tap)
+                coefficients[phase * kTruePeakTaps + tap] /= float(sum);
+        }
+        initialized = true;
+    }
+    return coefficients;
+}
+
+LoudnessMeter::LoudnessMeter()
+    : m_channels(0)
+    , m_frequency(0)
+    , m_subblockSize(1)
+    , m_subblockPosition(0)
+    , m_subblockIndex(0)
+    , m_subblockCount(0)
+    , m_samplePeak(0.0f)
+    , m_truePeak(0.0f)
+    , m_maxTruePeak(0.0f)
+    , m_samplesProcessed(0)
+{
+    truePeakCoefficients();
+    m_shelf.b0 = m_highpass.b0 = 1.0;
+    m_shelf.b1 = m_shelf.b2 = m_shelf.a1 = m_shelf.a2 = 0.0;
+    m_highpass.b1 = m_highpass.b2 = m_highpass.a1 = m_highpass.a2 = 0.0;
+    reset();
+}
+
+void LoudnessMeter::setFormat(int channels, int frequency)
+{
+    if (channels == m_channels && frequency == m_frequency)
+        return;
+    m_channels = channels;
+    m_frequency = frequency;
+
+    // The K-weighting filter: a high shelf followed by a high pass.
+    double K = std::tan(M_PI * 1681.974450955533 / frequency);
+    double Q = 0.7071752369554196;
+    double Vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    double Vb = std::pow(Vh, 0.4996667741545416);
+    double a0 = 1.0 + K / Q + K * K;
+    m_shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+    m_shelf.b1 = 2.0 * (K * K - Vh) / a0;
+    m_shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+    m_shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+    m_shelf.a2 = (1.0 - K / Q + K * K) / a0;
+
+    K = std::tan(M_PI * 38.13547087602444 / frequency);
+    Q = 0.5003270373238773;
+    a0 = 1.0 + K / Q + K * K;
+    m_highpass.b0 = 1.0;
+    m_highpass.b1 = -2.0;
+    m_highpass.b2 = 1.0;
+    m_highpass.a1 = 2.0 * (K * K - 1.0) / a0;
+    m_highpass.a2 = (1.0 - K / Q + K * K) / a0;
+
+    // The surround channels of 5.1 are weighted more and the LFE is ignored.
+    m_weights.fill(1.0, channels);
+    if (channels == 6) {
+        m_weights[3] = 0.0;
+        m_weights[4] = m_weights[5] = 1.41;
+    }
+    m_subblockSize = qMax(1, frequency / 10);
+    reset();
+}
+
+void LoudnessMeter::reset()
+{
+    m_filterState.fill(0.0, m_channels * 8);
+    m_channelSums.fill(0.0, m_channels);
+    m_subblocks.fill(0.0, kShortTermSubblocks);
+    m_subblockPosition = 0;
+    m_subblockIndex = 0;
+    m_subblockCount = 0;
+    m_blocks.counts.fill(0, kHistogramBins);
+    m_blocks.energies.fill(0.0, kHistogramBins);
+    m_blocks.total = 0;
+    m_shortTermBlocks.counts.fill(0, kHistogramBins);
+    m_shortTermBlocks.energies.fill(0.0, kHistogramBins);
+    m_shortTermBlocks.total = 0;
+    m_truePeakHistory.fill(0.0f, m_channels * kTruePeakTaps * 2);
+    m_samplePeak = m_truePeak = m_maxTruePeak = 0.0f;
+    m_samplesProcessed = 0;
+}
+
+void LoudnessMeter::process(const float* const* planes, int samples)
+{
+    if (m_channels <= 0 || samples <= 0)
+        return;
+    const float* coefficients = truePeakCoefficients();
+    float samplePeak = 0.0f;
+    float truePeak = 0.0f;
+
+    int offset = 0;
+    while (offset < samples) {
+        int count = qMin(samples - offset, m_subblockSize - m_subblockPosition);
+        for (int c = 0; c < m_channels; ++c) {
+            const float* in = planes[c] + offset;
+            double* state = m_filterState.data() + c * 8;
+            double x1 = state[0], x2 = state[1], y1 = state[2], y2 = state[3];
+            double z1 = state[4], z2 = state[5], w1 = state[6], w2 = state[7];
+            double sum = 0.0;
+            // The history is stored twice so that the taps are contiguous.
+            float* history = m_truePeakHistory.data() + c * kTruePeakTaps * 2;
+            int historyIndex = int((m_samplesProcessed + offset) % kTruePeakTaps);
+            for (int i = 0; i < count; ++i) {
+                double x = in[i];
+                double y = m_shelf.b0 * x + m_shelf.b1 * x1 + m_shelf.b2 * x2 - m_shelf.a1 * y1 - m_shelf.a2 * y2;
+                x2 = x1; x1 = x; y2 = y1; y1 = y;
+                double w = m_highpass.b0 * y + m_highpass.b1 * z1 + m_highpass.b2 * z2 - m_highpass.a1 * w1 - m_highpass.a2 * w2;
+                z2 = z1; z1 = y; w2 = w1; w1 = w;
+                sum += w * w;
+
+                float value = std::fabs(in[i]);
+                samplePeak = qMax(samplePeak, value);
+                historyIndex = (historyIndex + kTruePeakTaps - 1) % kTruePeakTaps;
+                history[historyIndex] = history[historyIndex + kTruePeakTaps] = in[i];
+                const float* taps = history + historyIndex;
+                for (int phase = 0; phase < kTruePeakPhases; ++phase) {
+                    const float* h = coefficients + phase * kTruePeakTaps;
+                    float interpolated = 0.0f;
+                    for (int tap = 0; tap < kTruePeakTaps; ++tap)
+                        interpolated += h[tap] * taps[tap];
+                    truePeak = qMax(truePeak, std::fabs(interpolated));
+                }
+            }
+            state[0] = x1; state[1] = x2; state[2] = y1; state[3] = y2;
+            state[4] = z1; state[5] = z2; state[6] = w1; state[7] = w2;
+            m_channelSums[c] += sum;
+        }
+        offset += count;
+        m_subblockPosition += count;
+        if (m_subblockPosition == m_subblockSize)
+            addSubblock();
+    }
+    m_samplesProcessed += samples;
+    m_samplePeak = samplePeak;
+    // The oversampled signal is never below the samples themselves.
+    m_truePeak = qMax(truePeak, samplePeak);
+    m_maxTruePeak = qMax(m_maxTruePeak, m_truePeak);
+}
+
+void LoudnessMeter::addSubblock()
+{
+    double energy = 0.0;
+    for (int c = 0; c < m_channels; ++c) {
+        energy += m_weights[c] * m_channelSums[c] / m_subblockSize;
+        m_channelSums[c] = 0.0;
+    }
+    m_subblocks[m_subblockIndex] = energy;
+    m_subblockIndex = (m_subblockIndex + 1) % kShortTermSubblocks;
+    m_subblockPosition = 0;
+    ++m_subblockCount;
+
+    // Gating blocks are 400 ms with 75% overlap.
+    if (m_subblockCount >= kMomentarySubblocks)
+        addToHistogram(m_blocks, std::pow(10.0, (momentary() + 0.691) / 10.0));
+    if (m_subblockCount >= kShortTermSubblocks)
+        addToHistogram(m_shortTermBlocks, std::pow(10.0, (shortTerm() + 0.691) / 10.0));
+}
+
+void LoudnessMeter::addToHistogram(Histogram& histogram, double energy)
+{
+    double loudness = energyToLoudness(energy);
+    if (loudness < kAbsoluteGate)
+        return;
+    int bin = histogramBin(loudness);
+    histogram.counts[bin]++;
+    histogram.energies[bin] += energy;
+    histogram.total++;
+}
+
+double LoudnessMeter::momentary() const
+{
+    if (m_subblockCount == 0)
+        return -std::numeric_limits<double>::infinity();
+    double sum = 0.0;
+    for (int i = 1; i <= kMomentarySubblocks; ++i)
+        sum += m_subblocks[(m_subblockIndex + kShortTermSubblocks - i) % kShortTermSubblocks];
+    return energyToLoudness(sum / kMomentarySubblocks);
+}
+
+double LoudnessMeter::shortTerm() const
+{
+    if (m_subblockCount == 0)
+        return -std::numeric_limits<double>::infinity();
+    double sum = 0.0;
+    for (int i = 0; i < kShortTermSubblocks; ++i)
+        sum += m_subblocks[i];
+    return energyToLoudness(sum / kShortTermSubblocks);
+}
+
+double LoudnessMeter::integrated() const
+{
+    if (!m_blocks.total)
+        return -std::numeric_limits<double>::infinity();
+    double sum = 0.0;
+    for (int i = 0; i < kHistogramBins; ++i)
+        sum += m_blocks.energies[i];
+    int start = qBound(0, int(std::ceil((energyToLoudness(sum / m_blocks.total) - 10.0 - kAbsoluteGate) * 10.0)),
+                       kHistogramBins);
+    sum = 0.0;
+    quint64 count = 0;
+    for (int i = start; i < kHistogramBins; ++i) {
+        sum += m_blocks.energies[i];
+        count += m_blocks.counts[i];
+    }
+    return count? energyToLoudness(sum / count) : -std::numeric_limits<double>::infinity();
+}
+
+double LoudnessMeter::range() const
+{
+    if (!m_shortTermBlocks.total)
+        return 0.0;
+    double sum = 0.0;
+    for (int i = 0; i < kHistogramBins; ++i)
+        sum += m_shortTermBlocks.energies[i];
+    int start = qBound(0, int(std::ceil((energyToLoudness(sum / m_shortTermBlocks.total) - 20.0 - kAbsoluteGate) * 10.0)),
+                       kHistogramBins);
+    quint64 count = 0;
+    for (int i = start; i < kHistogramBins; ++i)
+        count += m_shortTermBlocks.counts[i];
+    if (!count)
+        return 0.0;
+
+    // The range between the 10th and 95th percentiles.
+    quint64 lowCount = quint64(count * 0.10);
+    quint64 highCount = quint64(count * 0.95);
+    quint64 cumulative = 0;
+    int low = -1;
+    int high = start;
+    for (int i = start; i < kHistogramBins; ++i) {
+        cumulative += m_shortTermBlocks.counts[i];
+        if (low < 0 && cumulative > lowCount)
+            low = i;
+        if (cumulative > highCount) {
+            high = i;
+            break;
+        }
+    }
+    return qMax(0, high - qMax(low, start)) / 10.0;
+}
+
+double LoudnessMeter::samplePeak() const
+{
+    return toDecibels(m_samplePeak);
+}
+
+double LoudnessMeter::truePeak() const
+{
+    return toDecibels(m_truePeak);
+}
+
+double LoudnessMeter::maxTruePeak() const
+{
+    return toDecibels(m_maxTruePeak);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOUDNESSMETER_H
+#define LOUDNESSMETER_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/*!
+  \class LoudnessMeter
+  \brief Measures loudness according to EBU R128 (ITU-R BS.1770).
+
+  Audio is passed as planar float samples. The meter provides the momentary
+  (400 ms), short-term (3 s), integrated and range loudness, as well as the
+  sample and true peak. Values that cannot be computed yet are -inf.
+*/
+
+class LoudnessMeter
+{
+public:
+    LoudnessMeter();
+
+    //! Sets the audio format, which resets the meter if it changed.
+    void setFormat(int channels, int frequency);
+    void reset();
+    void process(const float* const* planes, int samples);
+
+    int channels() const { return m_channels; }
+    int frequency() const { return m_frequency; }
+    qint64 samplesProcessed() const { return m_samplesProcessed; }
+
+    //! Returns loudness in LUFS.
+    double momentary() const;
+    double shortTerm() const;
+    double integrated() const;
+    //! Returns the loudness range in LU.
+    double range() const;
+    //! Returns the sample peak of the last call to process() in dBFS.
+    double samplePeak() const;
+    //! Returns the true peak of the last call to process() in dBTP.
+    double truePeak() const;
+    //! Returns the maximum true peak since the reset in dBTP.
+    double maxTruePeak() const;
+
+private:
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+    struct Histogram {
+        QVector<quint32> counts;
+        QVector<double> energies;
+        quint64 total;
+    };
+
+    void addSubblock();
+    static void addToHistogram(Histogram& histogram, double energy);
+
+    int m_channels;
+    int m_frequency;
+    Biquad m_shelf;
+    Biquad m_highpass;
+    QVector<double> m_filterState; // 4 values per biquad per channel
+    QVector<double> m_weights;
+    QVector<double> m_channelSums;
+    int m_subblockSize;
+    int m_subblockPosition;
+    QVector<double> m_subblocks; // the last 3 seconds of 100 ms energies
+    int m_subblockIndex;
+    qint64 m_subblockCount;
+    Histogram m_blocks;
+    Histogram m_shortTermBlocks;
+    QVector<float> m_truePeakHistory;
+    float m_samplePeak;
+    float m_truePeak;
+    float m_maxTruePeak;
+    qint64 m_samplesProcessed;
+};
+
+#endif // LOUDNESSMETER_H
@@ -19,14 +19,23 @@
 #include <QtGlobal>
 #include "mainwindow.h"
 #include "settings.h"
+#include "widgets/scopes/videowaveformkernel.h"
+#include "fftengine.h"
+#include "startuptimer.h"
+#include "mediaanalysisscheduler.h"
+#include "commands/timelinebenchmark.h"
 #include <Logger.h>
 #include <FileAppender.h>
 #include <ConsoleAppender.h>
+#include <JsonLinesAppender.h>
 #include <QSysInfo>
 #include <QProcess>
 #include <QCommandLineParser>
 #include <framework/mlt_log.h>
+#include <framework/mlt_factory.h>
+#include <framework/mlt_events.h>
 #include <QFile>
+#include <cstdio>
 
 #ifdef Q_OS_MAC
     #include "macos.h"
@@ -69,6 +78,8 @@ static void mlt_log_handler(void *service, int mlt_level, const char *format, va
         cuteLoggerLevel = Logger::Warning;
         break;
     }
+    if (!cuteLogger->isEnabled(cuteLoggerLevel))
+        return;
     QString message;
     mlt_properties properties = service? MLT_SERVICE_PROPERTIES((mlt_service) service) : NULL;
     if (properties) {
@@ -102,10 +113,16 @@ public:
     QTranslator shotcutTranslator;
     QStringList resourceArg;
     bool isFullScreen;
+    bool isBenchmarkScopes;
+    bool isBenchmarkLogging;
+    bool isBenchmarkStartup;
+    bool isBenchmarkTimeline;
+    QString profileOpenArg;
     QString appDirArg;
 
     Application(int &argc, char **argv)
         : QApplication(argc, argv)
+        , mainWindow(0)
     {
         QDir dir(applicationDirPath());
 #ifdef Q_OS_MAC
@@ -154,6 +171,28 @@ public:
             QCoreApplication::translate("main", "The directory for app configuration and data."),
             QCoreApplication::translate("main", "directory"));
         parser.addOption(appDataOption);
+        QCommandLineOption benchmarkScopesOption("benchmark-scopes",
+            QCoreApplication::translate("main", "Print the time to render the video scopes and exit."));
+        parser.addOption(benchmarkScopesOption);
+        QCommandLineOption benchmarkLoggingOption("benchmark-logging",
+            QCoreApplication::translate("main", "Print the cost of a disabled log statement and exit."));
+        parser.addOption(benchmarkLoggingOption);
+        QCommandLineOption benchmarkStartupOption("benchmark-startup",
+            QCoreApplication::translate("main", "Start without showing a window, print the time of each startup phase, and exit."));
+        parser.addOption(benchmarkStartupOption);
+        QCommandLineOption benchmarkTimelineOption("benchmark-timeline",
+            QCoreApplication::translate("main", "Start without showing a window, print the time of timeline edits as CSV, and exit."));
+        parser.addOption(benchmarkTimelineOption);
+        QCommandLineOption profileOpenOption("profile-open",
+            QCoreApplication::translate("main", "Start without showing a window, open a project, print the time of each stage, and exit."),
+            QCoreApplication::translate("main", "file"));
+        parser.addOption(profileOpenOption);
+        QCommandLineOption traceOption("trace",
+            QCoreApplication::translate("main", "Write the log and a trace of frame, seek, job, and database events to shotcut-trace.jsonl."));
+        parser.addOption(traceOption);
+        QCommandLineOption debugOption("debug",
+            QCoreApplication::translate("main", "Write debug messages to the log."));
+        parser.addOption(debugOption);
         QCommandLineOption scaleOption("QT_SCALE_FACTOR",
             QCoreApplication::translate("main", "The scale factor for a high-DPI screen"),
             QCoreApplication::translate("main", "number"));
@@ -170,6 +209,11 @@ public:
 #else
         isFullScreen = parser.isSet(fullscreenOption);
 #endif
+        isBenchmarkScopes = parser.isSet(benchmarkScopesOption);
+        isBenchmarkLogging = parser.isSet(benchmarkLoggingOption);
+        isBenchmarkStartup = parser.isSet(benchmarkStartupOption);
+        isBenchmarkTimeline = parser.isSet(benchmarkTimelineOption);
+        profileOpenArg = parser.value(profileOpenOption);
         setProperty("noupgrade", parser.isSet(noupgradeOption));
         setProperty("clearRecent", parser.isSet(clearRecentOption));
         if (!parser.value(appDataOption).isEmpty()) {
@@ -198,9 +242,24 @@ public:
         mlt_log_set_level(MLT_LOG_VERBOSE);
 #else
         mlt_log_set_level(MLT_LOG_INFO);
+        // Release builds do not format debug messages unless asked to.
+        if (!parser.isSet(debugOption))
+            cuteLogger->setMinimumLevel(Logger::Info);
 #endif
         mlt_log_set_callback(mlt_log_handler);
         cuteLogger->logToGlobalInstance("qml", true);
+        if (parser.isSet(traceOption)) {
+            // Convert with scripts/trace-to-chrome.py to view in a trace viewer.
+            const QString traceFileName = dir.filePath("shotcut-trace.jsonl");
+            QFile::remove(traceFileName);
+            JsonLinesAppender* traceAppender = new JsonLinesAppender(traceFileName);
+            cuteLogger->registerAppender(traceAppender);
+            cuteLogger->registerCategoryAppender(Logger::traceCategory(), traceAppender);
+            cuteLogger->setTracing(true);
+        }
+        // Write the log in a background thread so that threads logging on hot
+        // paths never wait for the disk.
+        cuteLogger->setAsynchronous(true);
 
         // Log some basic info.
         LOG_INFO() << "Starting Shotcut version" << SHOTCUT_VERSION;
@@ -293,11 +352,92 @@ protected:
     }
 };
 
+static int benchmarkLogging()
+{
+    static const int kIterations = 1000000;
+    Logger::LogLevel level = cuteLogger->minimumLevel();
+    QString text("frame");
+    QElapsedTimer timer;
+
+    // A disabled statement must not format its message.
+    cuteLogger->setMinimumLevel(Logger::Info);
+    timer.start();
+    for (int i = 0; i < kIterations; ++i)
+        LOG_DEBUG() << text << i << 0.5;
+    double disabledNs = double(timer.nsecsElapsed()) / kIterations;
+    cuteLogger->setMinimumLevel(level);
+
+    // This is what every statement paid before the level was checked.
+    timer.start();
+    for (int i = 0; i < kIterations; ++i) {
+        QString message;
+        QDebug(&message) << text << i << 0.5;
+    }
+    double formatNs = double(timer.nsecsElapsed()) / kIterations;
+
+    printf("disabled log statement: %.1f ns\nformatting its message:  %.1f ns\n", disabledNs, formatNs);
+    fflush(stdout);
+    LOG_INFO() << "disabled log statement" << disabledNs << "ns, formatting its message" << formatNs << "ns";
+    return EXIT_SUCCESS;
+}
+
+static QAtomicInt producersCreated;
+
+static void onProducerCreated(mlt_properties, void*)
+{
+    producersCreated.ref();
+}
+
+static void waitForDeferredStartup(QApplication& a)
+{
+    while (StartupTimer::elapsed() < 60000
+           && !(StartupTimer::contains("filter metadata") && StartupTimer::contains("database"))) {
+        a.processEvents(QEventLoop::AllEvents, 10);
+        QThread::msleep(1);
+    }
+}
+
+static int profileOpen(QApplication& a, const QString& fileName)
+{
+    // Let the deferred startup work finish so that it is not counted.
+    waitForDeferredStartup(a);
+    mlt_events_listen(mlt_factory_event_object(), NULL, "producer-create-done", (mlt_listener) onProducerCreated);
+
+    StartupTimer::start();
+    MAIN.open(fileName);
+    StartupTimer::mark("open");
+    a.processEvents();
+    StartupTimer::mark("events");
+    // The waveforms are computed in the background after the open.
+    while (StartupTimer::elapsed() < 600000 && !ANALYSIS.isIdle()) {
+        a.processEvents(QEventLoop::AllEvents, 10);
+        QThread::msleep(1);
+    }
+    a.processEvents();
+    StartupTimer::mark("audio levels");
+    StartupTimer::report();
+    QString text = QString("%1 %2\n").arg("producers created", -24).arg(producersCreated.load(), 6);
+    fputs(text.toUtf8().constData(), stdout);
+    fflush(stdout);
+    LOG_INFO() << "producers created" << producersCreated.load();
+    cuteLogger->flush();
+    ::_Exit(EXIT_SUCCESS);
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char **argv)
 {
+    StartupTimer::start();
 #if defined(Q_OS_WIN) && defined(QT_DEBUG)
     ExcHndlInit();
 #endif
+    for (int i = 1; i < argc; i++) {
+        if (!::qstrcmp("--benchmark-startup", argv[i]) || !::qstrcmp("--benchmark-timeline", argv[i])
+                || !::qstrcmp("--benchmark-logging", argv[i]) || !::qstrcmp("--profile-open", argv[i])) {
+            ::qputenv("QT_QPA_PLATFORM", "offscreen");
+            break;
+        }
+    }
 #if QT_VERSION >= 0x050600
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     for (int i = 1; i + 1 < argc; i++) {
@@ -329,12 +469,20 @@ int main(int argc, char **argv)
 #endif
 
     Application a(argc, argv);
+    StartupTimer::mark("application");
+    if (a.isBenchmarkLogging)
+        return benchmarkLogging();
+    if (a.isBenchmarkScopes) {
+        FftEngine::benchmark();
+        return VideoWaveformKernel::benchmark();
+    }
     QSplashScreen splash(QPixmap(":/icons/shotcut-logo-320x320.png"));
     splash.showMessage(QCoreApplication::translate("main", "Loading plugins..."), Qt::AlignRight | Qt::AlignVCenter);
     splash.show();
 
     a.setProperty("system-style", a.style()->objectName());
     MainWindow::changeTheme(Settings.theme());
+    StartupTimer::mark("splash and theme");
 
     a.mainWindow = &MAIN;
     if (!a.appDirArg.isEmpty())
@@ -342,12 +490,35 @@ int main(int argc, char **argv)
     a.mainWindow->show();
     a.mainWindow->setFullScreen(a.isFullScreen);
     splash.finish(a.mainWindow);
+    StartupTimer::mark("show");
 
+    if (!a.profileOpenArg.isEmpty())
+        return profileOpen(a, a.profileOpenArg);
+    if (a.isBenchmarkTimeline) {
+        waitForDeferredStartup(a);
+        int failures = Timeline::benchmark();
+        cuteLogger->flush();
+        ::_Exit(failures? EXIT_FAILURE : EXIT_SUCCESS);
+    }
     if (!a.resourceArg.isEmpty())
         a.mainWindow->openMultiple(a.resourceArg);
     else
         a.mainWindow->open(a.mainWindow->untitledFileName());
+    StartupTimer::mark("open");
+
+    if (a.isBenchmarkStartup) {
+        // Let the deferred phases run before reporting.
+        waitForDeferredStartup(a);
+        StartupTimer::mark("event loop");
+        StartupTimer::report();
+        // Exit the same way as closing the window but without saving settings.
+        cuteLogger->flush();
+        ::_Exit(EXIT_SUCCESS);
+    }
 
+    // Later opens and timeline loads are only recorded with --profile-open.
+    // The phases deferred to other threads are only recorded with --benchmark-startup.
+    StartupTimer::finish();
     int result = a.exec();
 
     if (EXIT_RESTART == result) {
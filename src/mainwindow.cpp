@@ -44,6 +44,7 @@
 #include "docks/encodedock.h"
 #include "docks/jobsdock.h"
 #include "jobqueue.h"
+#include "mediaanalysisscheduler.h"
 #include "docks/playlistdock.h"
 #include "glwidget.h"
 #include "controllers/filtercontroller.h"
@@ -75,6 +76,8 @@
 #include "dialogs/listselectiondialog.h"
 #include "widgets/textproducerwidget.h"
 #include "qmltypes/qmlprofile.h"
+#include "startuptimer.h"
+#include "projectsaver.h"
 
 #include <QtWidgets>
 #include <Logger.h>
@@ -88,6 +91,7 @@
 #include <QDirIterator>
 #include <QQuickWindow>
 #include <QVersionNumber>
+#include <QSaveFile>
 #include <clocale>
 
 static bool eventDebugCallback(void **data)
@@ -105,6 +109,12 @@ static bool eventDebugCallback(void **data)
 }
 
 static const int AUTOSAVE_TIMEOUT_MS = 30000;
+// Autosave waits for this long without edits or playback...
+static const int AUTOSAVE_IDLE_MS = 3000;
+// ...but not longer than this after the first unsaved change.
+static const int AUTOSAVE_MAX_DELAY_MS = 300000;
+// The interval grows by AUTOSAVE_TIMEOUT_MS for each this many bytes of XML.
+static const int AUTOSAVE_SIZE_STEP = 2 * 1024 * 1024;
 
 MainWindow::MainWindow()
     : QMainWindow(0)
@@ -113,10 +123,15 @@ MainWindow::MainWindow()
     , m_keyerGroup(0)
     , m_keyerMenu(0)
     , m_isPlaylistLoaded(false)
+    , m_autosaveRevision(0)
+    , m_autosavedRevision(0)
+    , m_isAutosaving(0)
+    , m_autosaveSize(0)
     , m_exitCode(EXIT_SUCCESS)
     , m_navigationPosition(0)
     , m_upgradeUrl("https://www.shotcut.org/download/")
     , m_keyframesDock(0)
+    , m_saveUndoIndex(0)
 {
 #if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
     QLibrary libJack("libjack.so.0");
@@ -154,12 +169,18 @@ MainWindow::MainWindow()
     new GLTestWidget(this);
 #endif
     Database::singleton(this);
+    StartupTimer::mark("database thread");
     m_autosaveTimer.setSingleShot(true);
     m_autosaveTimer.setInterval(AUTOSAVE_TIMEOUT_MS);
     connect(&m_autosaveTimer, SIGNAL(timeout()), this, SLOT(onAutosaveTimeout()));
+    m_projectSaver = new ProjectSaver(this);
+    connect(m_projectSaver, SIGNAL(progressUpdated(QString,int)), SLOT(onProjectSaveProgress(QString,int)));
+    connect(m_projectSaver, SIGNAL(saved(QString)), SLOT(onProjectSaved(QString)));
+    connect(m_projectSaver, SIGNAL(failed(QString,QString)), SLOT(onProjectSaveFailed(QString,QString)));
 
     // Initialize all QML types
     QmlUtilities::registerCommonTypes();
+    StartupTimer::mark("qml types");
 
     // Create the UI.
     ui->setupUi(this);
@@ -178,6 +199,7 @@ MainWindow::MainWindow()
 #endif
     setDockNestingEnabled(true);
     ui->statusBar->hide();
+    StartupTimer::mark("main window ui");
 
     // Connect UI signals.
     connect(ui->actionOpen, SIGNAL(triggered()), this, SLOT(openVideo()));
@@ -229,6 +251,7 @@ MainWindow::MainWindow()
     setupOpenOtherMenu();
     readPlayerSettings();
     configureVideoWidget();
+    StartupTimer::mark("player");
 
 #ifndef SHOTCUT_NOUPGRADE
     if (Settings.noUpgrade() || qApp->property("noupgrade").toBool())
@@ -237,6 +260,7 @@ MainWindow::MainWindow()
 
     // Add the docks.
     m_scopeController = new ScopeController(this, ui->menuView);
+    StartupTimer::mark("scopes");
     QDockWidget* audioMeterDock = findChild<QDockWidget*>("AudioPeakMeterDock");
     if (audioMeterDock) {
         audioMeterDock->toggleViewAction()->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_1));
@@ -420,6 +444,7 @@ MainWindow::MainWindow()
     connect(&JOBS, SIGNAL(jobAdded()), m_jobsDock, SLOT(onJobAdded()));
     connect(m_jobsDock->toggleViewAction(), SIGNAL(triggered(bool)), this, SLOT(onJobsDockTriggered(bool)));
     connect(ui->actionJobs, SIGNAL(triggered()), this, SLOT(onJobsDockTriggered()));
+    StartupTimer::mark("docks");
 
     tabifyDockWidget(m_propertiesDock, m_playlistDock);
     tabifyDockWidget(m_playlistDock, m_filtersDock);
@@ -443,6 +468,10 @@ MainWindow::MainWindow()
     connect(videoWidget, SIGNAL(gpuNotSupported()), this, SLOT(onGpuNotSupported()));
     connect(videoWidget->quickWindow(), SIGNAL(sceneGraphInitialized()), SLOT(onSceneGraphInitialized()), Qt::QueuedConnection);
     connect(videoWidget, SIGNAL(frameDisplayed(const SharedFrame&)), m_scopeController, SIGNAL(newFrame(const SharedFrame&)));
+    if (Settings.playerGPU()) {
+        connect(videoWidget, SIGNAL(scopeFrameReady(const SharedFrame&)), m_scopeController, SIGNAL(newVideoFrame(const SharedFrame&)));
+        connect(m_scopeController, SIGNAL(videoScopesVisibleChanged(bool)), videoWidget, SLOT(setScopeFramesEnabled(bool)));
+    }
     connect(m_filterController, SIGNAL(currentFilterChanged(QmlFilter*, QmlMetadata*, int)), videoWidget, SLOT(setCurrentFilter(QmlFilter*, QmlMetadata*)));
 
     readWindowSettings();
@@ -466,6 +495,7 @@ MainWindow::MainWindow()
 
     QThreadPool::globalInstance()->setMaxThreadCount(qMin(4, QThreadPool::globalInstance()->maxThreadCount()));
 
+    StartupTimer::mark("window settings");
     LOG_DEBUG() << "end";
 }
 
@@ -1059,17 +1089,68 @@ void MainWindow::stepLeftBySeconds(int sec)
 
 void MainWindow::doAutosave()
 {
-    QMutexLocker locker(&m_autosaveMutex);
-    if (m_autosaveFile) {
-        bool success = false;
-        if (m_autosaveFile->isOpen() || m_autosaveFile->open(QIODevice::ReadWrite)) {
-            m_autosaveFile->close();
-            success = saveXML(m_autosaveFile->fileName(), false /* without relative paths */);
-            m_autosaveFile->open(QIODevice::ReadWrite);
-        }
-        if (!success) {
+    writeAutosave();
+    m_isAutosaving.storeRelease(0);
+}
+
+void MainWindow::writeAutosave()
+{
+    QSharedPointer<AutoSaveFile> autosaveFile;
+    QString managedFileName;
+    QString fileName;
+    {
+        // Only hold the lock while resolving the file so that interactive saves do not wait.
+        QMutexLocker locker(&m_autosaveMutex);
+        if (!m_autosaveFile)
+            return;
+        if (!m_autosaveFile->isOpen() && !m_autosaveFile->open(QIODevice::ReadWrite)) {
             LOG_ERROR() << "failed to open autosave file for writing" << m_autosaveFile->fileName();
+            return;
         }
+        m_autosaveFile->close();
+        autosaveFile = m_autosaveFile;
+        managedFileName = m_autosaveFile->managedFileName();
+        fileName = m_autosaveFile->fileName();
+    }
+
+    QByteArray xml = serializeXML(fileName, false /* without relative paths */);
+    if (xml.isEmpty()) {
+        LOG_ERROR() << "failed to serialize autosave" << fileName;
+        return;
+    }
+    m_autosaveSize.store(xml.size());
+    // A 32-bit hash could collide and silently drop a real change.
+    QByteArray hash = QCryptographicHash::hash(xml, QCryptographicHash::Md5);
+    if (hash == m_autosaveHash && fileName == m_autosavedFileName && QFile::exists(fileName)) {
+        LOG_DEBUG() << "autosave skipped, project unchanged";
+        return;
+    }
+
+    QSaveFile file(fileName);
+    bool success = file.open(QIODevice::WriteOnly);
+    static const int kChunkSize = 1048576; // 1 MiB
+    for (int offset = 0; success && offset < xml.size(); offset += kChunkSize) {
+        int n = qMin(kChunkSize, xml.size() - offset);
+        success = file.write(xml.constData() + offset, n) == n;
+    }
+    if (success)
+        success = file.commit();
+    else
+        file.cancelWriting();
+    if (!success) {
+        LOG_ERROR() << "failed to write autosave file" << fileName << file.errorString();
+        // Try again later.
+        QMetaObject::invokeMethod(this, "updateAutoSave", Qt::QueuedConnection);
+        return;
+    }
+    m_autosaveHash = hash;
+    m_autosavedFileName = fileName;
+
+    // The project may have been saved or closed while writing, which removes the autosave.
+    QMutexLocker locker(&m_autosaveMutex);
+    if (m_autosaveFile != autosaveFile || autosaveFile->managedFileName() != managedFileName) {
+        QFile::remove(fileName);
+        m_autosavedFileName.clear();
     }
 }
 
@@ -1196,14 +1277,37 @@ static void autosaveTask(MainWindow* p)
 
 void MainWindow::onAutosaveTimeout()
 {
-    if (isWindowModified())
-        QtConcurrent::run(autosaveTask, this);
+    if (!isWindowModified() || m_autosaveRevision == m_autosavedRevision)
+        return;
+    // Wait for a pause in editing or playback, and for the previous autosave to finish.
+    bool isBusy = m_lastEditTime.elapsed() < AUTOSAVE_IDLE_MS || (MLT.producer() && !MLT.isPaused())
+            || m_isAutosaving.load();
+    if (isBusy && m_autosaveDelay.elapsed() < AUTOSAVE_MAX_DELAY_MS) {
+        m_autosaveTimer.start(AUTOSAVE_IDLE_MS);
+        return;
+    }
+    if (!m_isAutosaving.testAndSetAcquire(0, 1)) {
+        m_autosaveTimer.start(AUTOSAVE_IDLE_MS);
+        return;
+    }
+    m_autosavedRevision = m_autosaveRevision;
+    QtConcurrent::run(autosaveTask, this);
+}
+
+int MainWindow::autosaveInterval() const
+{
+    // Large projects take longer to serialize, so save them less often.
+    return AUTOSAVE_TIMEOUT_MS * qBound(1, 1 + m_autosaveSize.load() / AUTOSAVE_SIZE_STEP, 10);
 }
 
 void MainWindow::updateAutoSave()
 {
-    if (!m_autosaveTimer.isActive())
-        m_autosaveTimer.start();
+    ++m_autosaveRevision;
+    m_lastEditTime.start();
+    if (!m_autosaveTimer.isActive()) {
+        m_autosaveDelay.start();
+        m_autosaveTimer.start(autosaveInterval());
+    }
 }
 
 void MainWindow::open(QString url, const Mlt::Properties* properties)
@@ -1217,7 +1321,11 @@ void MainWindow::open(QString url, const Mlt::Properties* properties)
             QCoreApplication::processEvents();
         }
     }
-    if (checker.check(url)) {
+    QElapsedTimer phaseTime;
+    phaseTime.start();
+    bool isChecked = checker.check(url);
+    StartupTimer::add("xml check", phaseTime.restart());
+    if (isChecked) {
         if (!isCompatibleWithGpuMode(checker))
             return;
     }
@@ -1254,7 +1362,9 @@ void MainWindow::open(QString url, const Mlt::Properties* properties)
         checker.setLocale();
         LOG_INFO() << "decimal point" << MLT.decimalPoint();
     }
+    phaseTime.restart();
     if (!MLT.open(QDir::fromNativeSeparators(url))) {
+        StartupTimer::add("mlt open", phaseTime.restart());
         Mlt::Properties* props = const_cast<Mlt::Properties*>(properties);
         if (props && props->is_valid())
             mlt_properties_inherit(MLT.producer()->get_properties(), props->get_properties());
@@ -1264,6 +1374,7 @@ void MainWindow::open(QString url, const Mlt::Properties* properties)
             setAudioChannels(MLT.audioChannels());
 
         open(MLT.producer());
+        StartupTimer::add("open producer", phaseTime.elapsed());
         if (url.startsWith(AutoSaveFile::path())) {
             QMutexLocker locker(&m_autosaveMutex);          
             if (m_autosaveFile && m_autosaveFile->managedFileName() != untitledFileName()) {
@@ -1426,6 +1537,7 @@ void MainWindow::readPlayerSettings()
     ui->actionRealtime->setChecked(Settings.playerRealtime());
     ui->actionProgressive->setChecked(Settings.playerProgressive());
     ui->actionScrubAudio->setChecked(Settings.playerScrubAudio());
+    ui->actionFrameStats->setChecked(Settings.playerFrameStats());
     if (ui->actionJack)
         ui->actionJack->setChecked(Settings.playerJACK());
     if (ui->actionGPU) {
@@ -2172,21 +2284,11 @@ void MainWindow::newProject(const QString &filename, bool isProjectFolder)
         QFileInfo info(filename);
         MLT.setProjectFolder(info.absolutePath());
     }
-    if (saveXML(filename)) {
-        QMutexLocker locker(&m_autosaveMutex);
-        if (m_autosaveFile)
-            m_autosaveFile->changeManagedFile(filename);
-        else
-            m_autosaveFile.reset(new AutoSaveFile(filename));
-        setCurrentFile(filename);
-        setWindowModified(false);
-        if (MLT.producer())
-            showStatusMessage(tr("Saved %1").arg(m_currentFile));
-        m_undoStack->setClean();
-        m_recentDock->add(filename);
-    } else {
-        showSaveError();
-    }
+    // The file is written in the background; onProjectSaved() marks the project
+    // saved and a failure is reported by onProjectSaveFailed().
+    saveProject(filename);
+    setCurrentFile(filename);
+    m_recentDock->add(filename);
 }
 
 void MainWindow::addCustomProfile(const QString &name, QMenu *menu, QAction *action, QActionGroup *group)
@@ -2300,6 +2402,16 @@ void MainWindow::closeEvent(QCloseEvent* event)
 {
     if (continueJobsRunning() && continueModified()) {
         if (!m_htmlEditor || m_htmlEditor->close()) {
+            if (!waitForSave()) {
+                // Keep the project and its autosave; onProjectSaveFailed() reports the error.
+                event->ignore();
+                return;
+            }
+            {
+                // The project is saved or discarded, and onProjectSaved() may not run before exit.
+                QMutexLocker locker(&m_autosaveMutex);
+                m_autosaveFile.reset();
+            }
             LOG_DEBUG() << "begin";
             writeSettings();
             if (m_exitCode == EXIT_SUCCESS) {
@@ -2313,12 +2425,14 @@ void MainWindow::closeEvent(QCloseEvent* event)
                     onMultitrackClosed();
             }
             QThreadPool::globalInstance()->clear();
+            ANALYSIS.clear();
             AudioLevelsTask::closeAll();
             event->accept();
             emit aboutToShutDown();
             if (m_exitCode == EXIT_SUCCESS) {
                 QApplication::quit();
                 LOG_DEBUG() << "end";
+                cuteLogger->flush();
                 ::_Exit(0);
             } else {
                 QApplication::exit(m_exitCode);
@@ -2425,17 +2539,8 @@ bool MainWindow::on_actionSave_triggered()
     } else {
         if (Util::warnIfNotWritable(m_currentFile, this, tr("Save XML")))
             return false;
-        bool success = saveXML(m_currentFile);
-        QMutexLocker locker(&m_autosaveMutex);
-        m_autosaveFile.reset(new AutoSaveFile(m_currentFile));
+        saveProject(m_currentFile);
         setCurrentFile(m_currentFile);
-        setWindowModified(false);
-        if (success) {
-            showStatusMessage(tr("Saved %1").arg(m_currentFile));
-        } else {
-            showSaveError();
-        }
-        m_undoStack->setClean();
         return true;
     }
 }
@@ -2477,8 +2582,11 @@ bool MainWindow::continueModified()
         int r = dialog.exec();
         if (r == QMessageBox::Yes || r == QMessageBox::No) {
             if (r == QMessageBox::Yes) {
-                return on_actionSave_triggered();
+                // The project is about to be closed, so it must be on disk.
+                return on_actionSave_triggered() && waitForSave();
             } else {
+                // Discard the result of an earlier failed save.
+                waitForSave();
                 QMutexLocker locker(&m_autosaveMutex);
                 m_autosaveFile.reset();
             }
@@ -2781,25 +2889,75 @@ void MainWindow::on_actionForum_triggered()
 
 bool MainWindow::saveXML(const QString &filename, bool withRelativePaths)
 {
-    bool result;
+    return ProjectSaver::writeFile(filename, serializeXML(filename, withRelativePaths));
+}
+
+QByteArray MainWindow::serializeXML(const QString &filename, bool withRelativePaths)
+{
+    QByteArray result;
     if (m_timelineDock->model()->rowCount() > 0) {
-        result = MLT.saveXML(filename, multitrack(), withRelativePaths);
+        result = MLT.serializeXML(filename, multitrack(), withRelativePaths);
     } else if (m_playlistDock->model()->rowCount() > 0) {
         int in = MLT.producer()->get_in();
         int out = MLT.producer()->get_out();
         MLT.producer()->set_in_and_out(0, MLT.producer()->get_length() - 1);
-        result = MLT.saveXML(filename, playlist(), withRelativePaths);
+        result = MLT.serializeXML(filename, playlist(), withRelativePaths);
         MLT.producer()->set_in_and_out(in, out);
     } else if (MLT.producer()) {
-        result = MLT.saveXML(filename, (MLT.isMultitrack() || MLT.isPlaylist())? MLT.savedProducer() : 0, withRelativePaths);
+        result = MLT.serializeXML(filename, (MLT.isMultitrack() || MLT.isPlaylist())? MLT.savedProducer() : 0, withRelativePaths);
     } else {
         // Save an empty playlist, which is accepted by both MLT and Shotcut.
         Mlt::Playlist playlist(MLT.profile());
-        result = MLT.saveXML(filename, &playlist, withRelativePaths);
+        result = MLT.serializeXML(filename, &playlist, withRelativePaths);
     }
     return result;
 }
 
+void MainWindow::saveProject(const QString &filename)
+{
+    // Only the serialization, which reads the service graph, blocks the UI.
+    LOG_DEBUG_TIME();
+    showStatusMessage(tr("Saving %1...").arg(filename), 15);
+    m_saveUndoIndex = m_undoStack->index();
+    m_projectSaver->save(filename, serializeXML(filename));
+}
+
+bool MainWindow::waitForSave()
+{
+    return m_projectSaver->waitForFinished();
+}
+
+void MainWindow::onProjectSaveProgress(const QString &filename, int percent)
+{
+    if (percent < 100)
+        m_player->setStatusLabel(tr("Saving %1... %2%").arg(filename).arg(percent), 15, 0 /* QAction */);
+}
+
+void MainWindow::onProjectSaved(const QString &filename)
+{
+    // Keep the autosave and the modified state until the project file is safely written.
+    if (filename == m_currentFile) {
+        {
+            QMutexLocker locker(&m_autosaveMutex);
+            m_autosaveFile.reset(new AutoSaveFile(filename));
+        }
+        // Edits made while the file was written are not in it.
+        if (m_undoStack->index() == m_saveUndoIndex) {
+            setWindowModified(false);
+            m_undoStack->setClean();
+        }
+    }
+    showStatusMessage(tr("Saved %1").arg(filename));
+}
+
+void MainWindow::onProjectSaveFailed(const QString &filename, const QString &errorString)
+{
+    LOG_ERROR() << "failed to save" << filename << errorString;
+    if (filename == m_currentFile)
+        setWindowModified(true);
+    showSaveError();
+}
+
 void MainWindow::changeTheme(const QString &theme)
 {
     LOG_DEBUG() << "begin";
@@ -3591,6 +3749,12 @@ void MainWindow::on_actionScrubAudio_triggered(bool checked)
     Settings.setPlayerScrubAudio(checked);
 }
 
+void MainWindow::on_actionFrameStats_triggered(bool checked)
+{
+    Settings.setPlayerFrameStats(checked);
+    m_player->setFrameStatsVisible(checked);
+}
+
 #if !defined(Q_OS_MAC)
 void MainWindow::onDrawingMethodTriggered(QAction *action)
 {
@@ -26,6 +26,8 @@
 #include <QScopedPointer>
 #include <QSharedPointer>
 #include <QRunnable>
+#include <QElapsedTimer>
+#include <QAtomicInt>
 #include "mltcontroller.h"
 #include "mltxmlchecker.h"
 
@@ -49,6 +51,7 @@ class TimelineDock;
 class AutoSaveFile;
 class QNetworkReply;
 class KeyframesDock;
+class ProjectSaver;
 
 class AppendTask : public QObject, public QRunnable
 {
@@ -80,6 +83,8 @@ public:
     bool continueJobsRunning();
     QUndoStack* undoStack() const;
     bool saveXML(const QString& filename, bool withRelativePaths = true);
+    QByteArray serializeXML(const QString& filename, bool withRelativePaths = true);
+    bool waitForSave();
     static void changeTheme(const QString& theme);
     PlaylistDock* playlistDock() const { return m_playlistDock; }
     FilterController* filterController() const { return m_filterController; }
@@ -143,6 +148,9 @@ private:
     bool saveRepairedXmlFile(MltXmlChecker& checker, QString& fileName);
     void setAudioChannels(int channels);
     void showSaveError();
+    void saveProject(const QString& filename);
+    int autosaveInterval() const;
+    void writeAutosave();
 
     Ui::MainWindow* ui;
     Player* m_player;
@@ -172,12 +180,23 @@ private:
     QSharedPointer<AutoSaveFile> m_autosaveFile;
     QMutex m_autosaveMutex;
     QTimer m_autosaveTimer;
+    int m_autosaveRevision;
+    int m_autosavedRevision;
+    QElapsedTimer m_lastEditTime;
+    QElapsedTimer m_autosaveDelay;
+    QAtomicInt m_isAutosaving;
+    QAtomicInt m_autosaveSize;
+    // Only accessed by the autosave thread.
+    QByteArray m_autosaveHash;
+    QString m_autosavedFileName;
     int m_exitCode;
     int m_navigationPosition;
     QScopedPointer<QAction> m_statusBarAction;
     QNetworkAccessManager m_network;
     QString m_upgradeUrl;
     KeyframesDock* m_keyframesDock;
+    ProjectSaver* m_projectSaver;
+    int m_saveUndoIndex;
 
 #ifdef WITH_LIBLEAP
     LeapListener m_leapListener;
@@ -281,6 +300,9 @@ private slots:
     void on_actionUpgrade_triggered();
     void on_actionOpenXML_triggered();
     void onAutosaveTimeout();
+    void onProjectSaveProgress(const QString& filename, int percent);
+    void onProjectSaved(const QString& filename);
+    void onProjectSaveFailed(const QString& filename, const QString& errorString);
     void on_actionGammaSRGB_triggered(bool checked);
     void on_actionGammaRec709_triggered(bool checked);
     void onFocusChanged(QWidget *old, QWidget * now) const;
@@ -289,6 +311,7 @@ private slots:
     void onTimelineClipSelected();
     void onAddAllToTimeline(Mlt::Playlist* playlist);
     void on_actionScrubAudio_triggered(bool checked);
+    void on_actionFrameStats_triggered(bool checked);
 #if !defined(Q_OS_MAC)
     void onDrawingMethodTriggered(QAction*);
 #endif
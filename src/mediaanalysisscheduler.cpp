@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mediaanalysisscheduler.h"
+#include <QRunnable>
+#include <QFileInfo>
+#include <QStorageInfo>
+#include <QThread>
+#include <QMetaMethod>
+#include <Logger.h>
+
+static const int kMaxDecodersPerLocalDevice = 2;
+static const int kMaxDecodersPerNetworkDevice = 1;
+static const int kReprioritizeDelayMs = 50;
+// The device of a folder that is still being looked up
+static const QChar kUnknownDevicePrefix('?');
+
+class ScheduledTask : public QRunnable
+{
+public:
+    ScheduledTask(QRunnable* task, const QString& device)
+        : QRunnable()
+        , m_task(task)
+        , m_device(device)
+    {}
+
+    void run()
+    {
+        m_task->run();
+        if (m_task->autoDelete())
+            delete m_task;
+        QMetaObject::invokeMethod(&ANALYSIS, "onTaskFinished", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_device));
+    }
+
+private:
+    QRunnable* m_task;
+    QString m_device;
+};
+
+class DeviceLookup : public QRunnable
+{
+public:
+    DeviceLookup(const QString& path)
+        : QRunnable()
+        , m_path(path)
+    {}
+
+    void run()
+    {
+        QString device;
+        QString type;
+        QStorageInfo storage(m_path);
+        if (storage.isValid()) {
+            device = QString::fromUtf8(storage.device());
+            type = QString::fromUtf8(storage.fileSystemType()).toLower();
+        }
+        QMetaObject::invokeMethod(&ANALYSIS, "onDeviceFound", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_path), Q_ARG(QString, device), Q_ARG(QString, type));
+    }
+
+private:
+    QString m_path;
+};
+
+MediaAnalysisScheduler::MediaAnalysisScheduler(QObject* parent)
+    : QObject(parent)
+    , m_running(0)
+    , m_sequence(0)
+{
+    m_pool.setMaxThreadCount(qMin(4, QThread::idealThreadCount()));
+    m_lookupPool.setMaxThreadCount(2);
+    // Coalesce the updates from scrolling.
+    m_reprioritizeTimer.setSingleShot(true);
+    m_reprioritizeTimer.setInterval(kReprioritizeDelayMs);
+    connect(&m_reprioritizeTimer, SIGNAL(timeout()), SLOT(onReprioritizeTimeout()));
+}
+
+MediaAnalysisScheduler& MediaAnalysisScheduler::singleton()
+{
+    static MediaAnalysisScheduler* instance = 0;
+    if (!instance)
+        instance = new MediaAnalysisScheduler();
+    return *instance;
+}
+
+void MediaAnalysisScheduler::start(QRunnable* task, const QString& resource, QObject* requester,
+                                   const QModelIndex& index, Priority priority)
+{
+    Subscriber subscriber;
+    subscriber.requester = requester;
+    subscriber.index = index;
+    subscriber.priority = priority;
+    Request request;
+    request.task = task;
+    if (!resource.isEmpty())
+        request.path = QFileInfo(resource).absolutePath();
+    request.device = deviceForPath(request.path);
+    request.subscribers << subscriber;
+    request.priority = priority;
+    request.sequence = m_sequence++;
+    m_queue << request;
+    dispatch();
+}
+
+bool MediaAnalysisScheduler::subscribe(QRunnable* task, QObject* requester, const QModelIndex& index,
+                                       Priority priority)
+{
+    for (int i = 0; i < m_queue.size(); ++i) {
+        if (m_queue[i].task == task) {
+            Subscriber subscriber;
+            subscriber.requester = requester;
+            subscriber.index = index;
+            subscriber.priority = priority;
+            m_queue[i].subscribers << subscriber;
+            m_queue[i].priority = qMax(m_queue[i].priority, priority);
+            return true;
+        }
+    }
+    return false;
+}
+
+void MediaAnalysisScheduler::reprioritize(QObject* requester)
+{
+    if (!m_reprioritize.contains(requester))
+        m_reprioritize << requester;
+    m_reprioritizeTimer.start();
+}
+
+void MediaAnalysisScheduler::onReprioritizeTimeout()
+{
+    foreach (QPointer<QObject> requester, m_reprioritize) {
+        if (!requester)
+            continue;
+        int methodIndex = requester->metaObject()->indexOfMethod("analysisPriority(QModelIndex)");
+        if (methodIndex < 0)
+            continue;
+        QMetaMethod method = requester->metaObject()->method(methodIndex);
+        for (int i = 0; i < m_queue.size(); ++i) {
+            Request& request = m_queue[i];
+            bool changed = false;
+            for (int j = 0; j < request.subscribers.size(); ++j) {
+                Subscriber& subscriber = request.subscribers[j];
+                if (subscriber.requester == requester && subscriber.index.isValid()) {
+                    int priority = subscriber.priority;
+                    QModelIndex index = subscriber.index;
+                    if (method.invoke(requester, Qt::DirectConnection,
+                                      Q_RETURN_ARG(int, priority), Q_ARG(QModelIndex, index))) {
+                        subscriber.priority = Priority(priority);
+                        changed = true;
+                    }
+                }
+            }
+            if (changed)
+                updatePriority(request);
+        }
+    }
+    m_reprioritize.clear();
+}
+
+void MediaAnalysisScheduler::cancel(QObject* requester, const QModelIndex& index)
+{
+    unsubscribe(requester, &index);
+}
+
+void MediaAnalysisScheduler::cancel(QObject* requester)
+{
+    unsubscribe(requester, 0);
+}
+
+void MediaAnalysisScheduler::unsubscribe(QObject* requester, const QModelIndex* index)
+{
+    // A task is discarded only when none of its requesters still want it.
+    for (int i = m_queue.size() - 1; i >= 0; --i) {
+        QList<Subscriber>& subscribers = m_queue[i].subscribers;
+        int count = subscribers.size();
+        for (int j = count - 1; j >= 0; --j) {
+            if (subscribers.at(j).requester == requester && (!index || subscribers.at(j).index == *index))
+                subscribers.removeAt(j);
+        }
+        if (subscribers.isEmpty())
+            discard(m_queue.takeAt(i));
+        else if (subscribers.size() != count)
+            updatePriority(m_queue[i]);
+    }
+}
+
+void MediaAnalysisScheduler::updatePriority(Request& request)
+{
+    request.priority = BackgroundPriority;
+    foreach (const Subscriber& subscriber, request.subscribers)
+        request.priority = qMax(request.priority, subscriber.priority);
+}
+
+void MediaAnalysisScheduler::clear()
+{
+    while (!m_queue.isEmpty())
+        discard(m_queue.takeLast());
+}
+
+void MediaAnalysisScheduler::onTaskFinished(const QString& device)
+{
+    --m_running;
+    if (!device.isEmpty())
+        --m_runningPerDevice[device];
+    dispatch();
+}
+
+QString MediaAnalysisScheduler::deviceForPath(const QString& path)
+{
+    if (path.isEmpty())
+        return QString();
+    if (m_deviceForPath.contains(path))
+        return m_deviceForPath.value(path);
+    if (!m_lookups.contains(path)) {
+        m_lookups << path;
+        m_lookupPool.start(new DeviceLookup(path));
+    }
+    return kUnknownDevicePrefix + path;
+}
+
+void MediaAnalysisScheduler::onDeviceFound(const QString& path, const QString& device,
+                                           const QString& fileSystemType)
+{
+    m_lookups.remove(path);
+    m_deviceForPath[path] = device;
+    if (!device.isEmpty() && !m_deviceLimits.contains(device)) {
+        const QString& type = fileSystemType;
+        bool isNetwork = type.startsWith("nfs") || type == "cifs" || type == "smbfs"
+                || type == "smb2" || type == "afpfs" || type == "webdav" || type.startsWith("fuse.sshfs");
+        m_deviceLimits[device] = isNetwork? kMaxDecodersPerNetworkDevice : kMaxDecodersPerLocalDevice;
+        LOG_DEBUG() << "device" << device << type << "limit" << m_deviceLimits[device];
+    }
+    // The tasks already running keep counting against the folder until they finish.
+    for (int i = 0; i < m_queue.size(); ++i) {
+        if (m_queue[i].path == path)
+            m_queue[i].device = device;
+    }
+    dispatch();
+}
+
+int MediaAnalysisScheduler::deviceLimit(const QString& device) const
+{
+    if (device.isEmpty())
+        return m_pool.maxThreadCount();
+    if (device.startsWith(kUnknownDevicePrefix))
+        return kMaxDecodersPerNetworkDevice;
+    return m_deviceLimits.value(device, kMaxDecodersPerLocalDevice);
+}
+
+void MediaAnalysisScheduler::dispatch()
+{
+    while (m_running < m_pool.maxThreadCount() && !m_queue.isEmpty()) {
+        // Choose the highest priority request, oldest first, whose device is not saturated.
+        int best = -1;
+        for (int i = 0; i < m_queue.size(); ++i) {
+            const Request& request = m_queue.at(i);
+            if (!request.device.isEmpty()
+                    && m_runningPerDevice.value(request.device) >= deviceLimit(request.device))
+                continue;
+            if (best < 0 || request.priority > m_queue.at(best).priority
+                    || (request.priority == m_queue.at(best).priority
+                        && request.sequence < m_queue.at(best).sequence))
+                best = i;
+        }
+        if (best < 0)
+            break;
+        Request request = m_queue.takeAt(best);
+        ++m_running;
+        if (!request.device.isEmpty())
+            ++m_runningPerDevice[request.device];
+        m_pool.start(new ScheduledTask(request.task, request.device));
+    }
+}
+
+void MediaAnalysisScheduler::discard(const Request& request)
+{
+    if (request.task->autoDelete())
+        delete request.task;
+}
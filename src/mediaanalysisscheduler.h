@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEDIAANALYSISSCHEDULER_H
+#define MEDIAANALYSISSCHEDULER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+#include <QPersistentModelIndex>
+#include <QPointer>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+class QRunnable;
+
+/// Runs thumbnail and waveform tasks on a dedicated thread pool.
+///
+/// Requests are identified by the object that made them and an optional model
+/// index so that they can be canceled when no longer wanted. A task that
+/// serves several requesters subscribes each of them and stays queued until
+/// the last one cancels. When a view
+/// scrolls, the requester calls reprioritize(), and the scheduler asks it for
+/// the new priority of each pending index through its invokable method
+/// int analysisPriority(const QModelIndex&). Tasks that read media files are
+/// also limited per storage device, which is looked up on a worker thread
+/// since that can block on a network or dead mount. Until it is known, the
+/// tasks of a folder are limited like those of a network device. All methods
+/// must be called from the GUI thread.
+class MediaAnalysisScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        BackgroundPriority = 0,
+        NearVisiblePriority,
+        VisiblePriority
+    };
+
+    static MediaAnalysisScheduler& singleton();
+
+    /// Takes ownership of task unless its autoDelete() is false.
+    void start(QRunnable* task, const QString& resource, QObject* requester,
+               const QModelIndex& index = QModelIndex(), Priority priority = VisiblePriority);
+    /// Adds a requester to a pending task and raises its priority if needed;
+    /// returns false if the task is not pending.
+    bool subscribe(QRunnable* task, QObject* requester, const QModelIndex& index,
+                   Priority priority = VisiblePriority);
+    void reprioritize(QObject* requester);
+    void cancel(QObject* requester, const QModelIndex& index);
+    void cancel(QObject* requester);
+    void clear();
+    int pendingCount() const { return m_queue.size(); }
+    bool isIdle() const { return m_queue.isEmpty() && !m_running; }
+
+private slots:
+    void onTaskFinished(const QString& device);
+    void onReprioritizeTimeout();
+    void onDeviceFound(const QString& path, const QString& device, const QString& fileSystemType);
+
+private:
+    explicit MediaAnalysisScheduler(QObject* parent = 0);
+
+    struct Subscriber {
+        QPointer<QObject> requester;
+        QPersistentModelIndex index;
+        Priority priority;
+    };
+
+    struct Request {
+        QRunnable* task;
+        QString path;
+        QString device;
+        QList<Subscriber> subscribers;
+        // The highest priority of the subscribers
+        Priority priority;
+        quint64 sequence;
+    };
+
+    QString deviceForPath(const QString& path);
+    int deviceLimit(const QString& device) const;
+    void dispatch();
+    void discard(const Request& request);
+    void unsubscribe(QObject* requester, const QModelIndex* index);
+    void updatePriority(Request& request);
+
+    QThreadPool m_pool;
+    QThreadPool m_lookupPool;
+    QList<Request> m_queue;
+    QHash<QString, int> m_runningPerDevice;
+    QHash<QString, QString> m_deviceForPath;
+    QSet<QString> m_lookups;
+    QHash<QString, int> m_deviceLimits;
+    QList<QPointer<QObject> > m_reprioritize;
+    QTimer m_reprioritizeTimer;
+    int m_running;
+    quint64 m_sequence;
+};
+
+#define ANALYSIS MediaAnalysisScheduler::singleton()
+
+#endif // MEDIAANALYSISSCHEDULER_H
@@ -21,13 +21,11 @@
 #include <QMetaType>
 #include <QFileInfo>
 #include <QUuid>
-#include <QTemporaryFile>
-#include <QXmlStreamReader>
+#include <QElapsedTimer>
 #include <Logger.h>
 #include <Mlt.h>
 #include <cmath>
 #include <clocale>
-#include <unistd.h>
 
 #include "glwidget.h"
 #include "settings.h"
@@ -36,6 +34,8 @@
 #include "controllers/filtercontroller.h"
 #include "qmltypes/qmlmetadata.h"
 #include "util.h"
+#include "startuptimer.h"
+#include "projectsaver.h"
 
 namespace Mlt {
 
@@ -46,7 +46,10 @@ const QString XmlMimeType("application/vnd.mlt+xml");
 Controller::Controller()
 {
     LOG_DEBUG() << "begin";
+    QElapsedTimer timer;
+    timer.start();
     m_repo = Mlt::Factory::init();
+    StartupTimer::add("mlt factory", timer.elapsed());
     resetLocale();
     m_profile.reset(new Mlt::Profile(kDefaultMltProfile));
     m_filtersClipboard.reset(new Mlt::Producer(profile(), "color", "black"));
@@ -408,6 +411,8 @@ void Controller::onWindowResize()
 
 void Controller::seek(int position)
 {
+    LOG_SPAN("seek");
+    loggerSpan.setArgument("position", position);
     setVolume(m_volume, false);
     if (m_producer) {
         // Always pause before seeking (if not already paused).
@@ -440,114 +445,47 @@ void Controller::refreshConsumer(bool scrubAudio)
 
 bool Controller::saveXML(const QString& filename, Service* service, bool withRelativePaths, bool verify)
 {
+    if (verify)
+        return ProjectSaver::writeFile(filename, serializeXML(filename, service, withRelativePaths));
+
     QMutexLocker locker(&m_saveXmlMutex);
-    QFileInfo fi(filename);
-    QTemporaryFile tmp;
-    QString mltFileName = filename;
-    // First, write to a temp file.
-    if (verify) {
-        tmp.setFileTemplate(fi.absolutePath().append("/shotcut-XXXXXX.mlt"));
-        tmp.open();
-        tmp.close();
-        mltFileName = tmp.fileName();
-        LOG_DEBUG() << "writing temporary XML file" << mltFileName;
-    }
-    Consumer c(profile(), "xml", mltFileName.toUtf8().constData());
+    Consumer c(profile(), "xml", filename.toUtf8().constData());
+    return runXmlConsumer(c, filename, service, withRelativePaths);
+}
+
+QByteArray Controller::serializeXML(const QString& filename, Service* service, bool withRelativePaths)
+{
+    static const char* propertyName = "string";
+    QMutexLocker locker(&m_saveXmlMutex);
+    Consumer c(profile(), "xml", propertyName);
+    if (!runXmlConsumer(c, filename, service, withRelativePaths))
+        return QByteArray();
+    return QByteArray(c.get(propertyName));
+}
+
+bool Controller::runXmlConsumer(Consumer& c, const QString& filename, Service* service, bool withRelativePaths)
+{
     Service s(service? service->get_service() : m_producer->get_service());
-    if (s.is_valid()) {
-        s.set(kShotcutProjectAudioChannels, m_audioChannels);
-        s.set(kShotcutProjectFolder, m_projectFolder.isEmpty()? 0 : 1);
-        int ignore = s.get_int("ignore_points");
-        if (ignore)
-            s.set("ignore_points", 0);
-        c.set("time_format", "clock");
-        c.set("no_meta", 1);
-        c.set("store", "shotcut");
-        if (withRelativePaths) {
-            c.set("root", fi.absolutePath().toUtf8().constData());
-            c.set("no_root", 1);
-        }
-        c.set("title", QString("Shotcut version ").append(SHOTCUT_VERSION).toUtf8().constData());
-        c.connect(s);
-        c.start();
-        if (ignore)
-            s.set("ignore_points", ignore);
-
-        if (verify) {
-            // Check if the temp file is well-formed XML.
-            tmp.open();
-            QXmlStreamReader xml(&tmp);
-            while (!xml.atEnd())
-                xml.readNext();
-            tmp.close();
-            if (!xml.hasError()) {
-                // QFile::rename() can fail and remove the destination file. See its docs.
-                // So, save an existing target file as a backup.
-                QString backupName;
-                if (QFile::exists(filename)) {
-                    QTemporaryFile backupTmp;
-                    backupTmp.setFileTemplate(
-                        QString("%1/%2 - backup - XXXXXX.mlt").arg(fi.absolutePath()).arg(fi.completeBaseName()));
-                    // Only remove the backup file if we successfully move the temp file to target.
-                    backupTmp.setAutoRemove(false);
-                    QFile existingFile(filename);
-                    if (existingFile.open(QIODevice::ReadOnly)) {
-                        // Copy contents of existing file to temporary backup file.
-                        backupTmp.open();
-                        backupName = backupTmp.fileName();
-                        LOG_DEBUG() << "copy to backup" << filename << backupName;
-                        QByteArray buffer;
-                        while (!(buffer = existingFile.read(1048576LL /*1MiB*/)).isEmpty()) {
-                            backupTmp.write(buffer);
-                        }
-                        if (existingFile.error() != QFileDevice::NoError) {
-                            LOG_ERROR() << "backup error" << existingFile.errorString();
-                            return false;
-                        }
-                        if (backupTmp.size() != existingFile.size()) {
-                            LOG_ERROR() << "backup file size problem: existing file size" << existingFile.size() << ", backup file size" << backupTmp.size();
-                            return false;
-                        }
-                        backupTmp.close();
-                        existingFile.close();
-                        // Remove the existing file as its name becomes the target for rename.
-                        if (!existingFile.remove()) {
-                            LOG_ERROR() << "failed to remove existing file" << filename;
-                            return false;
-                        }
-                    } else {
-                        // Do not overwrite the backup file.
-                        LOG_ERROR() << "failed to open existing file" << filename << "for backup:" << existingFile.errorString();
-                        return false;
-                    }
-                }
-                // If the file is good, then move it into place.
-                LOG_DEBUG() << "rename" << mltFileName << filename;
-                tmp.setAutoRemove(false);
-                int attempts = 5;
-                for (int i = 0; i < attempts; i++) {
-                    if (tmp.rename(filename)) {
-                        // Double-check the rename operation.
-                        if (QFile::exists(filename) && QFile::exists(backupName))
-                            QFile::remove(backupName);
-                        return true;
-                    } 
-                    LOG_WARNING() << "rename failed, trying again";
-                    
-#ifdef Q_OS_WIN
-                    ::Sleep(200);
-#else
-                    ::usleep(200000);
-#endif
-                }
-                LOG_ERROR() << "rename failed" << mltFileName << filename;
-                return false;
-            }
-        } else {
-            return true;
-        }
+    if (!s.is_valid())
+        return false;
+    s.set(kShotcutProjectAudioChannels, m_audioChannels);
+    s.set(kShotcutProjectFolder, m_projectFolder.isEmpty()? 0 : 1);
+    int ignore = s.get_int("ignore_points");
+    if (ignore)
+        s.set("ignore_points", 0);
+    c.set("time_format", "clock");
+    c.set("no_meta", 1);
+    c.set("store", "shotcut");
+    if (withRelativePaths) {
+        c.set("root", QFileInfo(filename).absolutePath().toUtf8().constData());
+        c.set("no_root", 1);
     }
-    return false;
+    c.set("title", QString("Shotcut version ").append(SHOTCUT_VERSION).toUtf8().constData());
+    c.connect(s);
+    c.start();
+    if (ignore)
+        s.set("ignore_points", ignore);
+    return true;
 }
 
 QString Controller::XML(Service* service, bool withProfile, bool withMetadata)
@@ -90,6 +90,8 @@ public:
     virtual void seek(int position);
     void refreshConsumer(bool scrubAudio = false);
     bool saveXML(const QString& filename, Service* service = nullptr, bool withRelativePaths = true, bool verify = true);
+    /// Returns the XML as saveXML() writes it for filename, for saving in another thread.
+    QByteArray serializeXML(const QString& filename, Service* service = nullptr, bool withRelativePaths = true);
     QString XML(Service* service = nullptr, bool withProfile = false, bool withMetadata = false);
     int consumerChanged();
     void setProfile(const QString& profile_name);
@@ -179,6 +181,7 @@ private:
     QString m_projectFolder;
     QMutex m_saveXmlMutex;
 
+    bool runXmlConsumer(Consumer& c, const QString& filename, Service* service, bool withRelativePaths);
     static void on_jack_started(mlt_properties owner, void* object, const mlt_position *position);
     void onJackStarted(int position);
     static void on_jack_stopped(mlt_properties owner, void* object, const mlt_position *position);
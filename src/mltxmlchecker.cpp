@@ -24,6 +24,8 @@
 #include <QCoreApplication>
 #include <QUrl>
 #include <QRegExp>
+#include <QElapsedTimer>
+#include <QtConcurrent/QtConcurrentRun>
 #include <Logger.h>
 #include <clocale>
 
@@ -45,6 +47,11 @@ static bool isNetworkResource(const QString& string)
     return (schemaTest.exactMatch(string) && QUrl(string).isValid() && !string.startsWith("plain:"));
 }
 
+static bool fileExists(const QString& filePath)
+{
+    return QFileInfo::exists(filePath);
+}
+
 static bool isNumericProperty(const QString& name)
 {
     return  name == "length" || name == "geometry" ||
@@ -62,19 +69,26 @@ MltXmlChecker::MltXmlChecker()
     , m_numericValueChanged(false)
 {
     m_unlinkedFilesModel.setColumnCount(ColumnCount);
+    // Checking files on network storage is bound by latency more than CPU.
+    m_statPool.setMaxThreadCount(8);
 }
 
 bool MltXmlChecker::check(const QString& fileName)
 {
     LOG_DEBUG() << "begin";
+    QElapsedTimer timer;
+    timer.start();
 
     QFile file(fileName);
+    m_resourceChecks.clear();
+    m_resourceCheckIndex.clear();
+    m_newXmlBuffer.close();
+    m_newXmlBuffer.setData(QByteArray());
     if (file.open(QIODevice::ReadOnly | QIODevice::Text) &&
-            m_tempFile.open()) {
-        m_tempFile.resize(0);
+            m_newXmlBuffer.open(QIODevice::WriteOnly)) {
         m_fileInfo = QFileInfo(fileName);
         m_xml.setDevice(&file);
-        m_newXml.setDevice(&m_tempFile);
+        m_newXml.setDevice(&m_newXmlBuffer);
         m_newXml.setAutoFormatting(true);
         m_newXml.setAutoFormattingIndent(2);
         if (m_xml.readNextStartElement()) {
@@ -122,12 +136,27 @@ bool MltXmlChecker::check(const QString& fileName)
             }
         }
     }
-    if (m_tempFile.isOpen()) {
+    qint64 parseTime = timer.restart();
+    addUnlinkedFiles();
+    qint64 statTime = timer.restart();
+
+    // A document without corrections is opened as is, so do not write it.
+    m_newXmlBuffer.close();
+    const QByteArray& newXml = m_newXmlBuffer.data();
+    bool isWritten = false;
+    if (m_isCorrected && m_xml.error() == QXmlStreamReader::NoError && m_tempFile.open()) {
+        m_tempFile.resize(0);
+        isWritten = m_tempFile.write(newXml) == newXml.size();
         m_tempFile.close();
-//        m_tempFile.open();
-//        LOG_DEBUG() << m_tempFile.readAll().constData();
-//        m_tempFile.close();
+        if (!isWritten)
+            LOG_ERROR() << "failed to write" << m_tempFile.fileName();
     }
+    LOG_INFO() << "parsed in" << parseTime << "ms, checked" << m_resourceChecks.size()
+               << "files in" << statTime << "ms more, wrote" << (isWritten? newXml.size() : 0)
+               << "bytes in" << timer.elapsed() << "ms";
+    m_newXmlBuffer.setData(QByteArray());
+    m_resourceChecks.clear();
+    m_resourceCheckIndex.clear();
     LOG_DEBUG() << "end";
     return m_xml.error() == QXmlStreamReader::NoError;
 }
@@ -412,17 +441,34 @@ void MltXmlChecker::checkUnlinkedFile(const QString& mlt_service)
     if (!m_resource.info.filePath().isEmpty() && !isNetworkResource(m_resource.info.filePath()))
     // not an image sequence
     if ((mlt_service != "pixbuf" && mlt_service != "qimage") || fileName.indexOf('%') == -1)
-    // file does not exist
-    if (!m_resource.info.exists())
-    // not already in the model
-    if (m_unlinkedFilesModel.findItems(filePath,
-            Qt::MatchFixedString | Qt::MatchCaseSensitive).isEmpty()) {
-        LOG_ERROR() << "file not found: " << m_resource.info.filePath();
-        QIcon icon(":/icons/oxygen/32x32/status/task-reject.png");
-        QStandardItem* item = new QStandardItem(icon, filePath);
-        item->setToolTip(item->text());
-        item->setData(m_resource.hash, ShotcutHashRole);
-        m_unlinkedFilesModel.appendRow(item);
+    // not already being checked
+    if (!m_resourceCheckIndex.contains(filePath)) {
+        // Check whether the file exists in the background while parsing continues.
+        ResourceCheck check;
+        check.filePath = filePath;
+        check.hash = m_resource.hash;
+        check.exists = QtConcurrent::run(&m_statPool, fileExists, m_resource.info.absoluteFilePath());
+        m_resourceCheckIndex.insert(filePath, m_resourceChecks.size());
+        m_resourceChecks << check;
+    }
+}
+
+void MltXmlChecker::addUnlinkedFiles()
+{
+    // Add the files that do not exist to the model in document order.
+    for (int i = 0; i < m_resourceChecks.size(); ++i) {
+        ResourceCheck& check = m_resourceChecks[i];
+        if (!check.exists.result()
+                // not already in the model
+                && m_unlinkedFilesModel.findItems(check.filePath,
+                    Qt::MatchFixedString | Qt::MatchCaseSensitive).isEmpty()) {
+            LOG_ERROR() << "file not found: " << QDir::fromNativeSeparators(check.filePath);
+            QIcon icon(":/icons/oxygen/32x32/status/task-reject.png");
+            QStandardItem* item = new QStandardItem(icon, check.filePath);
+            item->setToolTip(item->text());
+            item->setData(check.hash, ShotcutHashRole);
+            m_unlinkedFilesModel.appendRow(item);
+        }
     }
 }
 
@@ -470,7 +516,9 @@ bool MltXmlChecker::fixVersion1701WindowsPathBug(QString& value)
 
 void MltXmlChecker::checkIncludesSelf(QVector<MltProperty>& properties)
 {
-    if (m_resource.info.canonicalFilePath() == m_fileInfo.canonicalFilePath()) {
+    // Compare the names first to avoid resolving the path of every resource.
+    if (m_resource.info.fileName() == m_fileInfo.fileName()
+            && m_resource.info.canonicalFilePath() == m_fileInfo.canonicalFilePath()) {
         LOG_WARNING() << "This project tries to include itself; breaking that!";
         for (auto& p : properties) {
             if (p.first == "mlt_service")
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2014-2016 Meltytech, LLC
+ * Copyright (c) 2014-2019 Meltytech, LLC
  * Author: Dan Dennedy <dan@dennedy.org>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -27,6 +27,11 @@
 #include <QStandardItemModel>
 #include <QVector>
 #include <QPair>
+#include <QBuffer>
+#include <QHash>
+#include <QList>
+#include <QFuture>
+#include <QThreadPool>
 
 class QUIDevice;
 
@@ -68,6 +73,7 @@ private:
     void checkGpuEffects(const QString& mlt_service);
     void checkCpuEffects(const QString& mlt_service);
     void checkUnlinkedFile(const QString& mlt_service);
+    void addUnlinkedFiles();
     bool fixUnlinkedFile(QString& value);
     void fixStreamIndex(QString& value);
     bool fixVersion1701WindowsPathBug(QString& value);
@@ -82,6 +88,8 @@ private:
     bool m_usesLocale;
     QChar m_decimalPoint;
     QTemporaryFile m_tempFile;
+    // The checked document is only written to m_tempFile if it was corrected.
+    QBuffer m_newXmlBuffer;
     bool m_numericValueChanged;
     QFileInfo m_fileInfo;
     QStandardItemModel m_unlinkedFilesModel;
@@ -102,6 +110,16 @@ private:
             prefix.clear();
         }
     } m_resource;
+
+    // Resources whose existence is checked in parallel while parsing.
+    struct ResourceCheck {
+        QString filePath;
+        QString hash;
+        QFuture<bool> exists;
+    };
+    QList<ResourceCheck> m_resourceChecks;
+    QHash<QString, int> m_resourceCheckIndex;
+    QThreadPool m_statPool;
 };
 
 #endif // MLTXMLCHECKER_H
@@ -25,7 +25,6 @@
 #include <QImage>
 #include <QCryptographicHash>
 #include <QRgb>
-#include <QThreadPool>
 #include <QMutex>
 #include <QTime>
 #include <Logger.h>
@@ -40,20 +39,25 @@ static void deleteQVariantList(QVariantList* list)
 
 AudioLevelsTask::AudioLevelsTask(Mlt::Producer& producer, QObject* object, const QModelIndex& index)
     : QRunnable()
-    , m_object(object)
     , m_isCanceled(false)
     , m_isForce(false)
 {
-    m_producers << ProducerAndIndex(new Mlt::Producer(producer), index);
+    Subscriber subscriber = { new Mlt::Producer(producer), object, index };
+    m_subscribers << subscriber;
 }
 
 AudioLevelsTask::~AudioLevelsTask()
 {
-    foreach (ProducerAndIndex p, m_producers)
-        delete p.first;
+    // A task canceled before it ran is still in the list.
+    tasksListMutex.lock();
+    tasksList.removeOne(this);
+    tasksListMutex.unlock();
+    foreach (Subscriber s, m_subscribers)
+        delete s.producer;
 }
 
-void AudioLevelsTask::start(Mlt::Producer& producer, QObject* object, const QModelIndex& index, bool force)
+void AudioLevelsTask::start(Mlt::Producer& producer, QObject* object, const QModelIndex& index, bool force,
+                            MediaAnalysisScheduler::Priority priority)
 {
     if (Settings.timelineShowWaveforms() && producer.is_valid()) {
 
@@ -64,24 +68,31 @@ void AudioLevelsTask::start(Mlt::Producer& producer, QObject* object, const QMod
             return;
 
         AudioLevelsTask* task = new AudioLevelsTask(producer, object, index);
+        AudioLevelsTask* existing = 0;
         tasksListMutex.lock();
         // See if there is already a task for this MLT service and resource.
         foreach (AudioLevelsTask* t, tasksList) {
             if (*t == *task) {
                 // If so, then just add ourselves to be notified upon completion.
-                delete task;
-                task = 0;
-                t->m_producers << ProducerAndIndex(new Mlt::Producer(producer), index);
+                existing = t;
+                Subscriber subscriber = { new Mlt::Producer(producer), object, index };
+                t->m_subscribers << subscriber;
                 break;
             }
         }
-        if (task) {
-            // Otherwise, start a new audio levels generation thread.
+        if (!existing) {
+            // Otherwise, queue a new audio levels generation task.
             task->m_isForce = force;
             tasksList << task;
-            QThreadPool::globalInstance()->start(task);
         }
         tasksListMutex.unlock();
+        if (existing) {
+            delete task;
+            // Keep the task queued until every requester cancels it.
+            ANALYSIS.subscribe(existing, object, index, priority);
+        } else {
+            ANALYSIS.start(task, QString::fromUtf8(producer.get("resource")), object, index, priority);
+        }
     }
 }
 
@@ -99,9 +110,9 @@ void AudioLevelsTask::closeAll()
 
 bool AudioLevelsTask::operator==(AudioLevelsTask &b)
 {
-    if (!m_producers.isEmpty() && !b.m_producers.isEmpty()) {
-        Mlt::Producer* a_producer = m_producers.first().first;
-        Mlt::Producer* b_producer = b.m_producers.first().first;
+    if (!m_subscribers.isEmpty() && !b.m_subscribers.isEmpty()) {
+        Mlt::Producer* a_producer = m_subscribers.first().producer;
+        Mlt::Producer* b_producer = b.m_subscribers.first().producer;
         return a_producer && a_producer->is_valid() && b_producer && b_producer->is_valid()
                 && !qstrcmp(a_producer->get("resource"), b_producer->get("resource"));
     }
@@ -111,7 +122,7 @@ bool AudioLevelsTask::operator==(AudioLevelsTask &b)
 Mlt::Producer* AudioLevelsTask::tempProducer()
 {
     if (!m_tempProducer) {
-        Mlt::Producer* producer = m_producers.first().first;
+        Mlt::Producer* producer = m_subscribers.first().producer;
         QString service = producer->get("mlt_service");
         if (service == "avformat-novalidate")
             service = "avformat";
@@ -137,7 +148,7 @@ Mlt::Producer* AudioLevelsTask::tempProducer()
 QString AudioLevelsTask::cacheKey()
 {
     QString key = QString("%1 audiolevels");
-    Mlt::Producer* producer = m_producers.first().first;
+    Mlt::Producer* producer = m_subscribers.first().producer;
     if (producer->get(kShotcutHashProperty)) {
         key = key.arg(producer->get(kShotcutHashProperty));
     } else {
@@ -184,7 +195,7 @@ void AudioLevelsTask::run()
             if (frame && frame->is_valid() && !frame->get_int("test_audio")) {
                 mlt_audio_format format = mlt_audio_s16;
                 int frequency = 48000;
-                int samples = mlt_sample_calculator(m_producers.first().first->get_fps(), frequency, i);
+                int samples = mlt_sample_calculator(m_subscribers.first().producer->get_fps(), frequency, i);
                 frame->get_audio(format, frequency, channels, samples);
                 // for each channel
                 for (int channel = 0; channel < channels; channel++)
@@ -200,12 +211,7 @@ void AudioLevelsTask::run()
             // Incrementally update the audio levels every 5 seconds.
             if (updateTime.elapsed() > 5*1000 && !m_isCanceled) {
                 updateTime.restart();
-                foreach (ProducerAndIndex p, m_producers) {
-                    QVariantList* levelsCopy = new QVariantList(levels);
-                    p.first->set(kAudioLevelsProperty, levelsCopy, 0, (mlt_destructor) deleteQVariantList);
-                    if (-1 != m_object->metaObject()->indexOfMethod("audioLevelsReady(QModelIndex)"))
-                        QMetaObject::invokeMethod(m_object, "audioLevelsReady", Q_ARG(const QModelIndex&, p.second));
-                }
+                setLevels(levels);
             }
         }
         if (!m_isCanceled) {
@@ -260,12 +266,17 @@ void AudioLevelsTask::run()
     }
     tasksListMutex.unlock();
 
-    if (levels.size() > 0 && !m_isCanceled) {
-        foreach (ProducerAndIndex p, m_producers) {
-            QVariantList* levelsCopy = new QVariantList(levels);
-            p.first->set(kAudioLevelsProperty, levelsCopy, 0, (mlt_destructor) deleteQVariantList);
-            if (-1 != m_object->metaObject()->indexOfMethod("audioLevelsReady(QModelIndex)"))
-                QMetaObject::invokeMethod(m_object, "audioLevelsReady", Q_ARG(const QModelIndex&, p.second));
-        }
+    if (levels.size() > 0 && !m_isCanceled)
+        setLevels(levels);
+}
+
+void AudioLevelsTask::setLevels(const QVariantList& levels)
+{
+    foreach (Subscriber s, m_subscribers) {
+        QVariantList* levelsCopy = new QVariantList(levels);
+        s.producer->set(kAudioLevelsProperty, levelsCopy, 0, (mlt_destructor) deleteQVariantList);
+        QObject* object = s.object;
+        if (object && -1 != object->metaObject()->indexOfMethod("audioLevelsReady(QModelIndex)"))
+            QMetaObject::invokeMethod(object, "audioLevelsReady", Q_ARG(const QModelIndex&, s.index));
     }
 }
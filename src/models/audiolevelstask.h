@@ -20,8 +20,10 @@
 #define AUDIOLEVELSTASK_H
 
 #include "multitrackmodel.h"
+#include "mediaanalysisscheduler.h"
 #include <QRunnable>
 #include <QPersistentModelIndex>
+#include <QPointer>
 #include <QList>
 #include <MltProducer.h>
 #include <MltProfile.h>
@@ -31,7 +33,8 @@ class AudioLevelsTask : public QRunnable
 public:
     AudioLevelsTask(Mlt::Producer& producer, QObject* object, const QModelIndex& index);
     virtual ~AudioLevelsTask();
-    static void start(Mlt::Producer& producer, QObject* object, const QModelIndex& index, bool force = false);
+    static void start(Mlt::Producer& producer, QObject* object, const QModelIndex& index, bool force = false,
+                      MediaAnalysisScheduler::Priority priority = MediaAnalysisScheduler::VisiblePriority);
     static void closeAll();
     bool operator==(AudioLevelsTask& b);
 
@@ -39,12 +42,18 @@ protected:
     void run();
 
 private:
+    // Each requester of the same resource gets the levels on its own producer.
+    struct Subscriber {
+        Mlt::Producer* producer;
+        QPointer<QObject> object;
+        QPersistentModelIndex index;
+    };
+
     Mlt::Producer* tempProducer();
     QString cacheKey();
+    void setLevels(const QVariantList& levels);
 
-    QObject* m_object;
-    typedef QPair<Mlt::Producer*, QPersistentModelIndex> ProducerAndIndex;
-    QList<ProducerAndIndex> m_producers;
+    QList<Subscriber> m_subscribers;
     QScopedPointer<Mlt::Producer> m_tempProducer;
     bool m_isCanceled;
     bool m_isForce;
@@ -25,22 +25,32 @@
 #include "shotcut_mlt_properties.h"
 #include "controllers/filtercontroller.h"
 #include "qmltypes/qmlmetadata.h"
+#include "startuptimer.h"
 
 #include <QScopedPointer>
 #include <QApplication>
 #include <qmath.h>
 #include <QTimer>
+#include <QTime>
 
 #include <Logger.h>
 
 static const quintptr NO_PARENT_ID = quintptr(-1);
 static const char* kShotcutDefaultTransition = "lumaMix";
+static const int kVisibleRangeTimeoutMs = 1000;
+static const int kAudioLevelsBatchSize = 50;
 
 MultitrackModel::MultitrackModel(QObject *parent)
     : QAbstractItemModel(parent)
     , m_tractor(0)
     , m_isMakingTransition(false)
+    , m_visibleStart(0)
+    , m_visibleEnd(0)
+    , m_isRippleAllTracksForced(false)
+    , m_isWaitingForVisibleRange(false)
 {
+    m_audioLevelsTimer.setSingleShot(true);
+    connect(&m_audioLevelsTimer, SIGNAL(timeout()), SLOT(requestPendingAudioLevels()));
     connect(this, SIGNAL(modified()), SLOT(adjustBackgroundDuration()));
     connect(this, SIGNAL(modified()), SLOT(adjustTrackFilters()));
     connect(this, SIGNAL(reloadRequested()), SLOT(reload()), Qt::QueuedConnection);
@@ -423,10 +433,10 @@ int MultitrackModel::trimClipIn(int trackIndex, int clipIndex, int delta, bool r
             continue;
 
         //when not rippling, never touch the other tracks
-        if (trackIndex != i && (!ripple || !Settings.timelineRippleAllTracks()))
+        if (trackIndex != i && (!ripple || !rippleAllTracks()))
             continue;
 
-        if (Settings.timelineRippleAllTracks()) {
+        if (rippleAllTracks()) {
             if (track->get_int(kTrackLockProperty))
                 continue;
 
@@ -580,10 +590,10 @@ int MultitrackModel::trimClipOut(int trackIndex, int clipIndex, int delta, bool
         int filterOut = MLT.filterOut(playlist, clipIndex);
 
         //when not rippling, never touch the other tracks
-        if (trackIndex != i && (!ripple || !Settings.timelineRippleAllTracks()))
+        if (trackIndex != i && (!ripple || !rippleAllTracks()))
             continue;
 
-        if (Settings.timelineRippleAllTracks()) {
+        if (rippleAllTracks()) {
             if (track->get_int(kTrackLockProperty))
                 continue;
 
@@ -756,7 +766,7 @@ bool MultitrackModel::moveClip(int fromTrack, int toTrack, int clipIndex, int po
             int duration = position - clipStart;
             QList<int> trackList;
             trackList << fromTrack;
-            if (Settings.timelineRippleAllTracks()) {
+            if (rippleAllTracks()) {
                 for (int i = 0; i < m_trackList.count(); ++i) {
                     if (i == fromTrack)
                         continue;
@@ -1069,7 +1079,7 @@ int MultitrackModel::insertClip(int trackIndex, Mlt::Producer &clip, int positio
             result = targetIndex;
         }
         if (result >= 0) {
-            if (Settings.timelineRippleAllTracks()) {
+            if (rippleAllTracks()) {
                 //fill in/expand blanks in all the other tracks
                 QList<int> tracksToInsertBlankInto;
                 for (int j = 0; j < m_trackList.count(); ++j) {
@@ -1149,7 +1159,7 @@ void MultitrackModel::removeClip(int trackIndex, int clipIndex)
             consolidateBlanks(playlist, trackIndex);
 
             // Ripple all unlocked tracks.
-            if (clipPlaytime > 0 && Settings.timelineRippleAllTracks())
+            if (clipPlaytime > 0 && rippleAllTracks())
             for (int j = 0; j < m_trackList.count(); ++j) {
                 if (j == trackIndex)
                     continue;
@@ -2197,7 +2207,7 @@ bool MultitrackModel::moveClipToTrack(int fromTrack, int toTrack, int clipIndex,
         endRemoveRows();
 
         // Ripple all unlocked tracks.
-        if (clipPlaytime > 0 && Settings.timelineRippleAllTracks()) {
+        if (clipPlaytime > 0 && rippleAllTracks()) {
             for (int i = 0; i < m_trackList.count(); ++i) {
                 if (i == fromTrack || i == toTrack)
                     continue;
@@ -2286,7 +2296,7 @@ void MultitrackModel::moveClipToEnd(Mlt::Playlist& playlist, int trackIndex, int
     consolidateBlanks(playlist, trackIndex);
 
     // Ripple all unlocked tracks.
-    if (clipPlaytime > 0 && ripple && Settings.timelineRippleAllTracks())
+    if (clipPlaytime > 0 && ripple && rippleAllTracks())
     for (int j = 0; j < m_trackList.count(); ++j) {
         if (j == trackIndex)
             continue;
@@ -2362,7 +2372,7 @@ void MultitrackModel::relocateClip(Mlt::Playlist& playlist, int trackIndex, int
         endRemoveRows();
 
         // Ripple all unlocked tracks.
-        if (clipPlaytime > 0 && Settings.timelineRippleAllTracks()) {
+        if (clipPlaytime > 0 && rippleAllTracks()) {
             for (int i = 0; i < m_trackList.count(); ++i) {
                 if (i == trackIndex)
                     continue;
@@ -2448,7 +2458,7 @@ void MultitrackModel::moveClipInBlank(Mlt::Playlist& playlist, int trackIndex, i
     }
 
     // Ripple all unlocked tracks.
-    if (clipPlaytime > 0 && ripple && Settings.timelineRippleAllTracks()) {
+    if (clipPlaytime > 0 && ripple && rippleAllTracks()) {
         QList<int> otherTracksToRipple;
         for (int i = 0; i < m_trackList.count(); ++i) {
             if (i == trackIndex)
@@ -2520,6 +2530,28 @@ void MultitrackModel::audioLevelsReady(const QModelIndex& index)
     emit dataChanged(index, index, roles);
 }
 
+void MultitrackModel::setRippleAllTracksForced(bool force)
+{
+    m_isRippleAllTracksForced = force;
+}
+
+bool MultitrackModel::rippleAllTracks() const
+{
+    return m_isRippleAllTracksForced || Settings.timelineRippleAllTracks();
+}
+
+void MultitrackModel::setVisibleRange(int start, int end)
+{
+    m_visibleStart = start;
+    m_visibleEnd = qMax(start, end);
+    if (m_isWaitingForVisibleRange) {
+        getAudioLevels();
+    } else {
+        // Re-prioritize the waveforms that have not started yet.
+        ANALYSIS.reprioritize(this);
+    }
+}
+
 bool MultitrackModel::createIfNeeded()
 {
     if (!m_tractor) {
@@ -3147,6 +3179,11 @@ int MultitrackModel::getDuration()
 
 void MultitrackModel::load()
 {
+    QTime loadTime; loadTime.start();
+    ANALYSIS.cancel(this);
+    m_isWaitingForVisibleRange = false;
+    m_pendingAudioLevels.clear();
+    m_audioLevelsTimer.stop();
     if (m_tractor) {
         beginResetModel();
         delete m_tractor;
@@ -3168,21 +3205,31 @@ void MultitrackModel::load()
         return;
     }
 
+    QTime phaseTime; phaseTime.start();
     loadPlaylist();
     addBlackTrackIfNeeded();
     MLT.updateAvformatCaching(m_tractor->count());
     refreshTrackList();
+    LOG_DEBUG() << "refreshTrackList" << phaseTime.restart() << "ms";
     convertOldDoc();
+    LOG_DEBUG() << "convertOldDoc" << phaseTime.restart() << "ms";
     consolidateBlanksAllTracks();
+    LOG_DEBUG() << "consolidateBlanksAllTracks" << phaseTime.restart() << "ms";
     adjustBackgroundDuration();
     adjustTrackFilters();
+    LOG_DEBUG() << "adjustTrackFilters" << phaseTime.restart() << "ms";
     if (m_trackList.count() > 0) {
         beginInsertRows(QModelIndex(), 0, m_trackList.count() - 1);
         endInsertRows();
-        getAudioLevels();
+        // Show the tracks first. The waveforms are requested once the view
+        // reports the range it shows, or after a timeout without a view.
+        m_isWaitingForVisibleRange = true;
+        m_audioLevelsTimer.start(kVisibleRangeTimeoutMs);
     }
     emit loaded();
     emit filteredChanged();
+    LOG_INFO() << "loaded" << m_trackList.count() << "tracks in" << loadTime.elapsed() << "ms";
+    StartupTimer::add("timeline load", loadTime.elapsed());
 }
 
 void MultitrackModel::reload(bool asynchronous)
@@ -3202,6 +3249,10 @@ void MultitrackModel::reload(bool asynchronous)
 void MultitrackModel::close()
 {
     if (!m_tractor) return;
+    ANALYSIS.cancel(this);
+    m_isWaitingForVisibleRange = false;
+    m_pendingAudioLevels.clear();
+    m_audioLevelsTimer.stop();
     if (m_trackList.count() > 0) {
         beginRemoveRows(QModelIndex(), 0, m_trackList.count() - 1);
         m_trackList.clear();
@@ -3300,6 +3351,9 @@ void MultitrackModel::refreshTrackList()
 
 void MultitrackModel::getAudioLevels()
 {
+    m_isWaitingForVisibleRange = false;
+    m_pendingAudioLevels.clear();
+    m_audioLevelsTimer.stop();
     for (int trackIx = 0; trackIx < m_trackList.size(); trackIx++) {
         int i = m_trackList.at(trackIx).mlt_index;
         QScopedPointer<Mlt::Producer> track(m_tractor->track(i));
@@ -3308,10 +3362,78 @@ void MultitrackModel::getAudioLevels()
             QScopedPointer<Mlt::Producer> clip(playlist.get_clip(clipIx));
             if (clip && clip->is_valid() && !clip->is_blank() && clip->get_int("audio_index") > -1) {
                 QModelIndex index = createIndex(clipIx, 0, trackIx);
-                AudioLevelsTask::start(clip->parent(), this, index);
+                int start = playlist.clip_start(clipIx);
+                MediaAnalysisScheduler::Priority priority =
+                    visibilityPriority(start, start + playlist.clip_length(clipIx));
+                // Only the clips in or near the view are requested right away.
+                if (priority == MediaAnalysisScheduler::BackgroundPriority)
+                    m_pendingAudioLevels << QPersistentModelIndex(index);
+                else
+                    AudioLevelsTask::start(clip->parent(), this, index, false, priority);
             }
         }
     }
+    if (!m_pendingAudioLevels.isEmpty())
+        m_audioLevelsTimer.start(0);
+}
+
+void MultitrackModel::requestPendingAudioLevels()
+{
+    if (!m_tractor)
+        return;
+    if (m_isWaitingForVisibleRange) {
+        getAudioLevels();
+        return;
+    }
+    // Request a batch at a time so that the UI keeps responding.
+    for (int n = 0; n < kAudioLevelsBatchSize && !m_pendingAudioLevels.isEmpty(); ++n) {
+        QPersistentModelIndex index = m_pendingAudioLevels.takeFirst();
+        // The clip may have been removed since.
+        if (!index.isValid() || int(index.internalId()) >= m_trackList.size())
+            continue;
+        int trackIx = index.internalId();
+        QScopedPointer<Mlt::Producer> track(m_tractor->track(m_trackList.at(trackIx).mlt_index));
+        if (!track)
+            continue;
+        Mlt::Playlist playlist(*track);
+        int clipIx = index.row();
+        QScopedPointer<Mlt::Producer> clip(playlist.get_clip(clipIx));
+        if (clip && clip->is_valid() && !clip->is_blank() && clip->get_int("audio_index") > -1) {
+            int start = playlist.clip_start(clipIx);
+            AudioLevelsTask::start(clip->parent(), this, index, false,
+                visibilityPriority(start, start + playlist.clip_length(clipIx)));
+        }
+    }
+    if (!m_pendingAudioLevels.isEmpty())
+        m_audioLevelsTimer.start(0);
+}
+
+MediaAnalysisScheduler::Priority MultitrackModel::visibilityPriority(int start, int end) const
+{
+    int span = m_visibleEnd - m_visibleStart;
+    if (end >= m_visibleStart && start <= m_visibleEnd)
+        return MediaAnalysisScheduler::VisiblePriority;
+    if (end >= m_visibleStart - span && start <= m_visibleEnd + span)
+        return MediaAnalysisScheduler::NearVisiblePriority;
+    return MediaAnalysisScheduler::BackgroundPriority;
+}
+
+int MultitrackModel::analysisPriority(const QModelIndex& index) const
+{
+    if (!m_tractor || !index.isValid() || index.internalId() == NO_PARENT_ID)
+        return MediaAnalysisScheduler::BackgroundPriority;
+    int trackIndex = index.internalId();
+    if (trackIndex >= m_trackList.size())
+        return MediaAnalysisScheduler::BackgroundPriority;
+    QScopedPointer<Mlt::Producer> track(m_tractor->track(m_trackList.at(trackIndex).mlt_index));
+    if (!track)
+        return MediaAnalysisScheduler::BackgroundPriority;
+    Mlt::Playlist playlist(*track);
+    int clipIndex = index.row();
+    if (clipIndex >= playlist.count())
+        return MediaAnalysisScheduler::BackgroundPriority;
+    int start = playlist.clip_start(clipIndex);
+    return visibilityPriority(start, start + playlist.clip_length(clipIndex));
 }
 
 void MultitrackModel::addBlackTrackIfNeeded()
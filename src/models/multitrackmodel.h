@@ -21,8 +21,11 @@
 #include <QAbstractItemModel>
 #include <QList>
 #include <QString>
+#include <QTimer>
+#include <QPersistentModelIndex>
 #include <MltTractor.h>
 #include <MltPlaylist.h>
+#include "mediaanalysisscheduler.h"
 
 typedef enum {
     PlaylistTrackType = 0,
@@ -90,6 +93,8 @@ public:
     QModelIndex parent(const QModelIndex &index) const;
     QHash<int, QByteArray> roleNames() const;
     Q_INVOKABLE void audioLevelsReady(const QModelIndex &index);
+    Q_INVOKABLE void setVisibleRange(int start, int end);
+    Q_INVOKABLE int analysisPriority(const QModelIndex& index) const;
     bool createIfNeeded();
     void addBackgroundTrack();
     int addAudioTrack();
@@ -109,6 +114,9 @@ public:
     void insertOrAdjustBlankAt(QList<int> tracks, int position, int length);
     bool mergeClipWithNext(int trackIndex, int clipIndex, bool dryrun);
     void adjustClipFilters(Mlt::Producer& producer, int in, int out, int inDelta, int outDelta);
+    /// Ripples edits across all tracks regardless of the Ripple All Tracks setting.
+    void setRippleAllTracksForced(bool force);
+    bool rippleAllTracks() const;
 
 signals:
     void created();
@@ -175,6 +183,14 @@ private:
     Mlt::Tractor* m_tractor;
     TrackList m_trackList;
     bool m_isMakingTransition;
+    int m_visibleStart;
+    int m_visibleEnd;
+    bool m_isRippleAllTracksForced;
+    // The waveforms of a loaded project wait for the view to report its range.
+    bool m_isWaitingForVisibleRange;
+    // Clips outside the view whose waveforms are requested in batches.
+    QList<QPersistentModelIndex> m_pendingAudioLevels;
+    QTimer m_audioLevelsTimer;
 
     bool moveClipToTrack(int fromTrack, int toTrack, int clipIndex, int position, bool ripple);
     void moveClipToEnd(Mlt::Playlist& playlist, int trackIndex, int clipIndex, int position, bool ripple);
@@ -183,6 +199,7 @@ private:
     void consolidateBlanks(Mlt::Playlist& playlist, int trackIndex);
     void consolidateBlanksAllTracks();
     void getAudioLevels();
+    MediaAnalysisScheduler::Priority visibilityPriority(int start, int end) const;
     void addBlackTrackIfNeeded();
     void convertOldDoc();
     Mlt::Transition* getTransition(const QString& name, int trackIndex) const;
@@ -202,6 +219,7 @@ private:
 private slots:
     void adjustBackgroundDuration();
     void adjustTrackFilters();
+    void requestPendingAudioLevels();
 };
 
 #endif // MULTITRACKMODEL_H
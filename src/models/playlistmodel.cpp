@@ -23,13 +23,14 @@
 #include <QImage>
 #include <QColor>
 #include <QPainter>
-#include <QThreadPool>
 #include <Logger.h>
 #include <QApplication>
 #include <QPalette>
 #include <QCryptographicHash>
 #include <QScopedPointer>
 #include <QDir>
+#include <QCollator>
+#include <algorithm>
 
 #include "settings.h"
 #include "database.h"
@@ -40,6 +41,71 @@ static void deleteQImage(QImage* image)
     delete image;
 }
 
+// Returns the name of a clip as the playlist shows it.
+static QString displayName(Mlt::ClipInfo* info)
+{
+    QString result;
+    if (info->producer && info->producer->is_valid())
+        result = info->producer->get(kShotcutCaptionProperty);
+    if (result.isNull())
+        result = Util::baseName(QString::fromUtf8(info->resource));
+    if (result == "<producer>" && info->producer && info->producer->is_valid())
+        result = QString::fromUtf8(info->producer->get("mlt_service"));
+    return result;
+}
+
+struct LessByName
+{
+    LessByName(const QVector<PlaylistModel::RowKeys>& keys) : keys(keys)
+    {
+        collator.setNumericMode(true);
+        collator.setCaseSensitivity(Qt::CaseInsensitive);
+    }
+    bool operator()(int a, int b) const { return collator.compare(keys[a].name, keys[b].name) < 0; }
+    const QVector<PlaylistModel::RowKeys>& keys;
+    QCollator collator;
+};
+
+struct LessByIn
+{
+    LessByIn(const QVector<PlaylistModel::RowKeys>& keys) : keys(keys) {}
+    bool operator()(int a, int b) const { return keys[a].in < keys[b].in; }
+    const QVector<PlaylistModel::RowKeys>& keys;
+};
+
+struct LessByDuration
+{
+    LessByDuration(const QVector<PlaylistModel::RowKeys>& keys) : keys(keys) {}
+    bool operator()(int a, int b) const { return keys[a].duration < keys[b].duration; }
+    const QVector<PlaylistModel::RowKeys>& keys;
+};
+
+struct LessByDate
+{
+    LessByDate(const QVector<PlaylistModel::RowKeys>& keys) : keys(keys) {}
+    bool operator()(int a, int b) const { return keys[a].date < keys[b].date; }
+    const QVector<PlaylistModel::RowKeys>& keys;
+};
+
+/// Swaps the arguments of a comparator so that a stable sort in descending
+/// order keeps rows with equal values in their order.
+template <typename Less>
+struct Greater
+{
+    Greater(const Less& less) : less(less) {}
+    bool operator()(int a, int b) const { return less(b, a); }
+    Less less;
+};
+
+template <typename Less>
+static void stableSort(QVector<int>& rows, const Less& less, Qt::SortOrder order)
+{
+    if (order == Qt::DescendingOrder)
+        std::stable_sort(rows.begin(), rows.end(), Greater<Less>(less));
+    else
+        std::stable_sort(rows.begin(), rows.end(), less);
+}
+
 class UpdateThumbnailTask : public QRunnable
 {
     PlaylistModel* m_model;
@@ -159,6 +225,8 @@ PlaylistModel::PlaylistModel(QObject *parent)
     , m_playlist(0)
     , m_dropRow(-1)
     , m_mode(Invalid)
+    , m_visibleFirst(0)
+    , m_visibleLast(-1)
 {
     qRegisterMetaType<QVector<int> >("QVector<int>");
 }
@@ -212,21 +280,39 @@ QVariant PlaylistModel::data(const QModelIndex &index, int role) const
             return QVariant();
     }
 
-    QScopedPointer<Mlt::ClipInfo> info(m_playlist->clip_info(index.row()));
     switch (field) {
     case FIELD_INDEX:
         return QString::number(index.row() + 1);
+    case FIELD_IN:
+    case FIELD_DURATION:
+    case FIELD_DATE:
+        {
+        const RowKeys& keys = rowKeys(index.row());
+        if (!keys.hasProducer)
+            return "";
+        if (field == FIELD_IN)
+            return m_playlist->frames_to_time(keys.in);
+        if (field == FIELD_DURATION)
+            return m_playlist->frames_to_time(keys.duration);
+        if (!keys.date)
+            return "";
+        return QDateTime::fromMSecsSinceEpoch(keys.date).toString("yyyy-MM-dd HH:mm:ss");
+        }
+    default:
+        break;
+    }
+
+    QScopedPointer<Mlt::ClipInfo> info(m_playlist->clip_info(index.row()));
+    switch (field) {
     case FIELD_RESOURCE:
         {
         QString result;
         if (role == Qt::DisplayRole) {
             // Prefer caption for display
-            if (info->producer && info->producer->is_valid())
-                result = info->producer->get(kShotcutCaptionProperty);
-            if (result.isNull())
-                result = Util::baseName(QString::fromUtf8(info->resource));
-            if (result == "<producer>" && info->producer && info->producer->is_valid())
-                result = QString::fromUtf8(info->producer->get("mlt_service"));
+            result = displayName(info.data());
+            // The caption can change without the model knowing.
+            if (index.row() < m_rowKeys.size() && m_rowKeys[index.row()].isValid)
+                m_rowKeys[index.row()].name = result;
         } else {
             // Prefer detail or full path for tooltip
             if (info->producer && info->producer->is_valid())
@@ -251,34 +337,12 @@ QVariant PlaylistModel::data(const QModelIndex &index, int role) const
             MAIN.getHash(*info->producer);
         return result;
     }
-    case FIELD_IN:
-        if (info->producer && info->producer->is_valid()) {
-            return info->producer->frames_to_time(info->frame_in);
-        } else
-            return "";
-    case FIELD_DURATION:
-        if (info->producer && info->producer->is_valid()) {
-            return info->producer->frames_to_time(info->frame_count);
-        } else
-            return "";
     case FIELD_START:
         if (info->producer && info->producer->is_valid()) {
             return info->producer->frames_to_time(info->start);
         }
         else
             return "";
-    case FIELD_DATE:
-        if (info->producer && info->producer->is_valid()) {
-            int64_t ms = info->producer->get_creation_time();
-            if (!ms) {
-                return "";
-            }
-            else {
-               return QDateTime::fromMSecsSinceEpoch(ms).toString("yyyy-MM-dd HH:mm:ss");
-            }
-        }
-        else
-            return "";
     case FIELD_THUMBNAIL:
         {
             QString setting = Settings.playlistThumbnails();
@@ -332,6 +396,25 @@ QVariant PlaylistModel::data(const QModelIndex &index, int role) const
             }
             return image;
         }
+    case FIELD_THUMBNAIL_KEY:
+        {
+            QString setting = Settings.playlistThumbnails();
+            if (setting == "hidden")
+                return QString();
+
+            QScopedPointer<Mlt::Producer> producer(m_playlist->get_clip(index.row()));
+            if (!producer || !producer->is_valid())
+                return QString();
+            Mlt::Producer parent(producer->get_parent());
+            QImage* in = parent.is_valid()? (QImage*) parent.get_data(kThumbnailInProperty) : 0;
+            if (!in)
+                return QString();
+            QImage* out = 0;
+            if (setting == "wide" || setting == "tall")
+                out = (QImage*) parent.get_data(kThumbnailOutProperty);
+            // QImage::cacheKey() changes whenever a task stores a new image.
+            return QString("%1 %2 %3").arg(setting).arg(in->cacheKey()).arg(out? out->cacheKey() : 0);
+        }
     }
     return QVariant();
 }
@@ -430,39 +513,76 @@ bool PlaylistModel::moveRows(const QModelIndex &, int sourceRow, int count, cons
 
 void PlaylistModel::sort(int column, Qt::SortOrder order)
 {
-    if (!m_playlist) return;
+    if (!m_playlist || rowCount() < 2) return;
+    reorder(sortedRows(column, order));
+}
 
-    int index = 0;
+/// Returns the rows in the order of sorting by a column: row i of the sorted
+/// playlist is row result[i] of the current one. Rows with equal values keep
+/// their order.
+QVector<int> PlaylistModel::sortedRows(int column, Qt::SortOrder order) const
+{
     int count = rowCount();
-    if (count < 2) return;
-
-    // Create a list mapping values to their original index.
-    QVector<QPair<QString, int>> indexMap(count);
-    for (index = 0; index < count; index++) {
-        QModelIndex modelIndex = createIndex(index, column);
-        QString key = data(modelIndex, Qt::DisplayRole).toString();
-        indexMap[index] = qMakePair(key, index);
-    }
-    // Sort the list.
-    std::sort(indexMap.begin(), indexMap.end());
-
-    // Move the sorted indexes into a list to be used to reorder the playlist.
-    QVector<int> indexList(count);
-    QVector<QPair<QString, int>>::iterator itr = indexMap.begin();
-    index = 0;
-    while (itr != indexMap.end()) {
-        if (order == Qt::AscendingOrder) {
-            indexList[index] = itr->second;
-        } else {
-            indexList[count - index - 1] = itr->second;
+    QVector<int> rows(count);
+    for (int i = 0; i < count; ++i)
+        rows[i] = i;
+    if (count < 2)
+        return rows;
+
+    for (int i = 0; i < count; ++i)
+        rowKeys(i);
+    switch (column) {
+    case COLUMN_RESOURCE:
+        // A caption can be changed on a clip's producer, such as in its
+        // properties, without the model knowing, so read the names again.
+        for (int i = 0; i < count; ++i) {
+            QScopedPointer<Mlt::ClipInfo> info(m_playlist->clip_info(i));
+            if (info)
+                m_rowKeys[i].name = displayName(info.data());
         }
-        index++;
-        itr++;
+        stableSort(rows, LessByName(m_rowKeys), order);
+        break;
+    case COLUMN_IN:
+        stableSort(rows, LessByIn(m_rowKeys), order);
+        break;
+    case COLUMN_DURATION:
+        stableSort(rows, LessByDuration(m_rowKeys), order);
+        break;
+    case COLUMN_DATE:
+        stableSort(rows, LessByDate(m_rowKeys), order);
+        break;
+    default:
+        // The other columns are in the order of the rows.
+        break;
     }
+    return rows;
+}
 
-    m_playlist->reorder(indexList.data());
+/// Moves row rows[i] of the playlist to row i. The views keep their
+/// selection and current item, which move with the rows.
+void PlaylistModel::reorder(const QVector<int>& rows)
+{
+    if (!m_playlist || rows.size() != rowCount()) return;
 
-    emit dataChanged(createIndex(0, 0), createIndex(rowCount(), columnCount()));
+    emit layoutAboutToBeChanged();
+    m_playlist->reorder(rows.constData());
+    if (m_rowKeys.size() == rows.size()) {
+        QVector<RowKeys> keys(rows.size());
+        for (int i = 0; i < rows.size(); ++i)
+            keys[i] = m_rowKeys[rows[i]];
+        m_rowKeys.swap(keys);
+    } else {
+        m_rowKeys.clear();
+    }
+    QVector<int> newRows(rows.size());
+    for (int i = 0; i < rows.size(); ++i)
+        newRows[rows[i]] = i;
+    QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    foreach (const QModelIndex& index, from)
+        to << createIndex(newRows[index.row()], index.column());
+    changePersistentIndexList(from, to);
+    emit layoutChanged();
     emit modified();
 }
 
@@ -565,9 +685,11 @@ QModelIndex PlaylistModel::createIndex(int row, int column) const
 void PlaylistModel::clear()
 {
     if (!m_playlist) return;
+    ANALYSIS.cancel(this);
     if (rowCount()) {
         beginRemoveRows(QModelIndex(), 0, rowCount() - 1);
         m_playlist->clear();
+        m_rowKeys.clear();
         endRemoveRows();
     }
     emit cleared();
@@ -590,6 +712,7 @@ void PlaylistModel::load()
     MLT.producer()->set("mlt_type", "mlt_producer");
     MLT.producer()->set("resource", "<playlist>");
     m_playlist = new Mlt::Playlist(*MLT.producer());
+    m_rowKeys.clear();
     if (!m_playlist->is_valid()) {
         delete m_playlist;
         m_playlist = 0;
@@ -611,11 +734,11 @@ void PlaylistModel::append(Mlt::Producer& producer, bool emitModified)
     int in = producer.get_in();
     int out = producer.get_out();
     producer.set_in_and_out(0, producer.get_length() - 1);
-    QThreadPool::globalInstance()->start(
-        new UpdateThumbnailTask(this, producer, in, out, count), 1);
     beginInsertRows(QModelIndex(), count, count);
     m_playlist->append(producer, in, out);
+    insertRowKeys(count);
     endInsertRows();
+    startThumbnailTask(producer, in, out, count);
     if (emitModified)
         emit modified();
 }
@@ -626,19 +749,21 @@ void PlaylistModel::insert(Mlt::Producer& producer, int row)
     int in = producer.get_in();
     int out = producer.get_out();
     producer.set_in_and_out(0, producer.get_length() - 1);
-    QThreadPool::globalInstance()->start(
-        new UpdateThumbnailTask(this, producer, in, out, row), 1);
     beginInsertRows(QModelIndex(), row, row);
     m_playlist->insert(producer, row, in, out);
+    insertRowKeys(row);
     endInsertRows();
+    startThumbnailTask(producer, in, out, row);
     emit modified();
 }
 
 void PlaylistModel::remove(int row)
 {
     if (!m_playlist) return;
+    ANALYSIS.cancel(this, createIndex(row, 0));
     beginRemoveRows(QModelIndex(), row, row);
     m_playlist->remove(row);
+    removeRowKeys(row);
     endRemoveRows();
     if (m_playlist->count() == 0)
         emit cleared();
@@ -652,10 +777,10 @@ void PlaylistModel::update(int row, Mlt::Producer& producer)
     int in = producer.get_in();
     int out = producer.get_out();
     producer.set_in_and_out(0, producer.get_length() - 1);
-    QThreadPool::globalInstance()->start(
-        new UpdateThumbnailTask(this, producer, in, out, row), 1);
+    startThumbnailTask(producer, in, out, row);
     m_playlist->remove(row);
     m_playlist->insert(producer, row, in, out);
+    invalidateRowKeys(row);
     emit dataChanged(createIndex(row, 0), createIndex(row, columnCount()));
     emit modified();
 }
@@ -666,6 +791,7 @@ void PlaylistModel::appendBlank(int frames)
     int count = m_playlist->count();
     beginInsertRows(QModelIndex(), count, count);
     m_playlist->blank(frames - 1);
+    insertRowKeys(count);
     endInsertRows();
     emit modified();
 }
@@ -675,6 +801,7 @@ void PlaylistModel::insertBlank(int frames, int row)
     createIfNeeded();
     beginInsertRows(QModelIndex(), row, row);
     m_playlist->insert_blank(row, frames - 1);
+    insertRowKeys(row);
     endInsertRows();
     emit modified();
 }
@@ -692,6 +819,10 @@ void PlaylistModel::move(int from, int to)
 {
     if (!m_playlist) return;
     m_playlist->move(from, to);
+    if (m_rowKeys.size() == m_playlist->count())
+        m_rowKeys.move(from, to);
+    else
+        m_rowKeys.clear();
     emit dataChanged(createIndex(from, 0), createIndex(from, columnCount()));
     emit dataChanged(createIndex(to, 0), createIndex(to, columnCount()));
     emit modified();
@@ -715,17 +846,70 @@ void PlaylistModel::showThumbnail(int row)
 void PlaylistModel::refreshThumbnails()
 {
     if (m_playlist && m_playlist->is_valid()) {
+        ANALYSIS.cancel(this);
         for (int i = 0; i < m_playlist->count(); i++) {
             Mlt::ClipInfo* info = m_playlist->clip_info(i);
             if (info && info->producer && info->producer->is_valid()) {
-                QThreadPool::globalInstance()->start(
-                    new UpdateThumbnailTask(this, *info->producer, info->frame_in, info->frame_out, i), 1);
+                startThumbnailTask(*info->producer, info->frame_in, info->frame_out, i);
             }
             delete info;
         }
     }
 }
 
+void PlaylistModel::setVisibleRows(int first, int last)
+{
+    if (first == m_visibleFirst && last == m_visibleLast)
+        return;
+    m_visibleFirst = first;
+    m_visibleLast = last;
+    ANALYSIS.reprioritize(this);
+
+    // Start the thumbnails that were deferred for the rows now in or near view.
+    if (!m_playlist || last < first)
+        return;
+    int span = last - first + 1;
+    int end = qMin(last + span, m_playlist->count() - 1);
+    for (int row = qMax(0, first - span); row <= end; ++row) {
+        QScopedPointer<Mlt::ClipInfo> info(m_playlist->clip_info(row));
+        if (info && info->producer && info->producer->is_valid()
+                && info->producer->get_int(kThumbnailDeferredProperty)) {
+            startThumbnailTask(*info->producer, info->frame_in, info->frame_out, row);
+        }
+    }
+}
+
+int PlaylistModel::analysisPriority(const QModelIndex& index) const
+{
+    // Until a view reports what it shows, keep the requests in order.
+    if (m_visibleLast < m_visibleFirst)
+        return MediaAnalysisScheduler::VisiblePriority;
+    int row = index.row();
+    int span = m_visibleLast - m_visibleFirst + 1;
+    if (row >= m_visibleFirst && row <= m_visibleLast)
+        return MediaAnalysisScheduler::VisiblePriority;
+    if (row >= m_visibleFirst - span && row <= m_visibleLast + span)
+        return MediaAnalysisScheduler::NearVisiblePriority;
+    return MediaAnalysisScheduler::BackgroundPriority;
+}
+
+void PlaylistModel::startThumbnailTask(Mlt::Producer& producer, int in, int out, int row)
+{
+    // Replace any request for this row that has not started yet.
+    QModelIndex index = createIndex(row, 0);
+    ANALYSIS.cancel(this, index);
+    // Leave the rows far from view until setVisibleRows() brings them near.
+    int priority = analysisPriority(index);
+    if (priority == MediaAnalysisScheduler::BackgroundPriority) {
+        producer.set(kThumbnailDeferredProperty, 1);
+        return;
+    }
+    producer.set(kThumbnailDeferredProperty, 0);
+    ANALYSIS.start(new UpdateThumbnailTask(this, producer, in, out, row),
+                   QString::fromUtf8(producer.get("resource")), this, index,
+                   MediaAnalysisScheduler::Priority(priority));
+}
+
 void PlaylistModel::setPlaylist(Mlt::Playlist& playlist)
 {
     if (playlist.is_valid()) {
@@ -738,6 +922,7 @@ void PlaylistModel::setPlaylist(Mlt::Playlist& playlist)
             delete m_playlist;
         }
         m_playlist = new Mlt::Playlist(playlist);
+        m_rowKeys.clear();
         if (!m_playlist->is_valid()) {
             delete m_playlist;
             m_playlist = 0;
@@ -766,11 +951,58 @@ void PlaylistModel::setInOut(int row, int in, int out)
             outChanged = info->frame_out != out;
         }
         m_playlist->resize_clip(row, in, out);
-        QThreadPool::globalInstance()->start(
-            new UpdateThumbnailTask(this, *info->producer, in, out, row), 1);
+        invalidateRowKeys(row);
+        startThumbnailTask(*info->producer, in, out, row);
         emit dataChanged(createIndex(row, COLUMN_IN), createIndex(row, COLUMN_START));
         emit modified();
         if (inChanged) emit this->inChanged(in);
         if (outChanged) emit this->outChanged(out);
     }
 }
+
+const PlaylistModel::RowKeys& PlaylistModel::rowKeys(int row) const
+{
+    // Start over if the playlist was changed without the model.
+    if (m_rowKeys.size() != m_playlist->count())
+        m_rowKeys = QVector<RowKeys>(m_playlist->count());
+    RowKeys& keys = m_rowKeys[row];
+    if (!keys.isValid) {
+        keys = RowKeys();
+        keys.isValid = true;
+        QScopedPointer<Mlt::ClipInfo> info(m_playlist->clip_info(row));
+        if (info) {
+            keys.name = displayName(info.data());
+            if (info->producer && info->producer->is_valid()) {
+                keys.hasProducer = true;
+                keys.in = info->frame_in;
+                keys.duration = info->frame_count;
+                keys.date = info->producer->get_creation_time();
+            }
+        }
+    }
+    return keys;
+}
+
+/// Inserts an empty entry for a row just inserted into the playlist.
+void PlaylistModel::insertRowKeys(int row)
+{
+    if (m_rowKeys.size() == m_playlist->count() - 1)
+        m_rowKeys.insert(row, RowKeys());
+    else
+        m_rowKeys.clear();
+}
+
+/// Removes the entry of a row just removed from the playlist.
+void PlaylistModel::removeRowKeys(int row)
+{
+    if (m_rowKeys.size() == m_playlist->count() + 1)
+        m_rowKeys.remove(row);
+    else
+        m_rowKeys.clear();
+}
+
+void PlaylistModel::invalidateRowKeys(int row)
+{
+    if (row >= 0 && row < m_rowKeys.size())
+        m_rowKeys[row].isValid = false;
+}
@@ -21,7 +21,9 @@
 #include <QAbstractTableModel>
 #include <qmimedata.h>
 #include <QStringList>
+#include <QVector>
 #include "mltcontroller.h"
+#include "mediaanalysisscheduler.h"
 #include "MltPlaylist.h"
 
 #define kDetailedMode "detailed"
@@ -58,6 +60,21 @@ public:
         FIELD_DURATION,
         FIELD_START,
         FIELD_DATE,
+        /// Identifies the thumbnail images of a row, or empty without one, so
+        /// that a view can cache what it draws from FIELD_THUMBNAIL.
+        FIELD_THUMBNAIL_KEY,
+    };
+
+    /// The values of a row to show and sort by, read from the playlist once
+    /// and kept in step with the rows by the methods that change them.
+    struct RowKeys {
+        RowKeys() : isValid(false), hasProducer(false), in(0), duration(0), date(0) {}
+        bool isValid;
+        bool hasProducer;
+        QString name;
+        int in;
+        int duration;
+        qint64 date;
     };
 
     static const int THUMBNAIL_WIDTH = 80;
@@ -74,6 +91,8 @@ public:
     bool removeRows(int row, int count, const QModelIndex & parent = QModelIndex());
     bool moveRows(const QModelIndex &sourceParent, int sourceRow, int count, const QModelIndex &destinationParent, int destinationChild);
     void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+    QVector<int> sortedRows(int column, Qt::SortOrder order = Qt::AscendingOrder) const;
+    void reorder(const QVector<int>& rows);
     Qt::ItemFlags flags(const QModelIndex &index) const;
     QStringList mimeTypes() const;
     QMimeData *mimeData(const QModelIndexList &indexes) const;
@@ -84,6 +103,8 @@ public:
     void createIfNeeded();
     void showThumbnail(int row);
     void refreshThumbnails();
+    void setVisibleRows(int first, int last);
+    Q_INVOKABLE int analysisPriority(const QModelIndex& index) const;
     Mlt::Playlist* playlist() { return m_playlist; }
     void setPlaylist(Mlt::Playlist& playlist);
     void setInOut(int row, int in, int out);
@@ -119,6 +140,16 @@ private:
     int m_dropRow;
     ViewMode m_mode;
     QList<int> m_rowsRemoved;
+    int m_visibleFirst;
+    int m_visibleLast;
+
+    mutable QVector<RowKeys> m_rowKeys;
+
+    const RowKeys& rowKeys(int row) const;
+    void insertRowKeys(int row);
+    void removeRowKeys(int row);
+    void invalidateRowKeys(int row);
+    void startThumbnailTask(Mlt::Producer& producer, int in, int out, int row);
 };
 
 #endif // PLAYLISTMODEL_H
@@ -23,6 +23,7 @@
 #include "settings.h"
 #include "util.h"
 #include "widgets/newprojectfolder.h"
+#include "widgets/framestatswidget.h"
 
 #include <QtWidgets>
 #include <limits>
@@ -121,6 +122,10 @@ Player::Player(QWidget *parent)
     m_horizontalScroll = new QScrollBar(Qt::Horizontal);
     glayout->addWidget(m_horizontalScroll, 1, 0);
     m_horizontalScroll->hide();
+    m_frameStatsWidget = new FrameStatsWidget;
+    glayout->addWidget(m_frameStatsWidget, 0, 0, Qt::AlignLeft | Qt::AlignTop);
+    m_frameStatsWidget->raise();
+    m_frameStatsWidget->setVisible(Settings.playerFrameStats());
 
     // Add the new project widget.
     m_projectWidget = new NewProjectFolder(this);
@@ -1061,3 +1066,8 @@ void Player::toggleGrid(bool checked)
             m_gridDefaultAction->trigger();
     }
 }
+
+void Player::setFrameStatsVisible(bool visible)
+{
+    m_frameStatsWidget->setVisible(visible);
+}
@@ -38,6 +38,7 @@ class QTabBar;
 class QHBoxLayout;
 class QPushButton;
 class TransportControllable;
+class FrameStatsWidget;
 class QLabel;
 class QPropertyAnimation;
 class QPushButton;
@@ -108,6 +109,7 @@ public slots:
     void enableTab(TabIndex index, bool enabled = true);
     void onTabBarClicked(int index);
     void setStatusLabel(const QString& text, int timeoutSeconds, QAction* action);
+    void setFrameStatsVisible(bool visible);
 
 protected:
     void resizeEvent(QResizeEvent* event);
@@ -166,6 +168,7 @@ private:
     QTimer m_statusTimer;
     QMenu* m_zoomMenu;
     QWidget* m_projectWidget;
+    FrameStatsWidget* m_frameStatsWidget;
 
 private slots:
     void updateSelection();
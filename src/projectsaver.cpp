@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "projectsaver.h"
+#include <Logger.h>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <QXmlStreamReader>
+#include <QRunnable>
+#include <QElapsedTimer>
+#include <unistd.h>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+static const qint64 kChunkSize = 1048576LL; // 1 MiB
+
+class ProjectSaveTask : public QRunnable
+{
+public:
+    ProjectSaveTask(ProjectSaver* saver, const QString& filename, const QByteArray& xml)
+        : QRunnable()
+        , m_saver(saver)
+        , m_filename(filename)
+        , m_xml(xml)
+    {}
+
+    void run()
+    {
+        QElapsedTimer timer;
+        timer.start();
+        QString errorString;
+        bool success = ProjectSaver::writeFile(m_filename, m_xml, &errorString, m_saver);
+        LOG_DEBUG() << m_filename << "written in" << timer.elapsed() << "ms";
+        m_saver->reportFinished(m_filename, success, errorString);
+    }
+
+private:
+    ProjectSaver* m_saver;
+    QString m_filename;
+    QByteArray m_xml;
+};
+
+ProjectSaver::ProjectSaver(QObject* parent)
+    : QObject(parent)
+    , m_succeeded(1)
+{
+    // Saves must not overtake each other.
+    m_threadPool.setMaxThreadCount(1);
+}
+
+ProjectSaver::~ProjectSaver()
+{
+    m_threadPool.waitForDone();
+}
+
+void ProjectSaver::save(const QString& filename, const QByteArray& xml)
+{
+    m_threadPool.start(new ProjectSaveTask(this, filename, xml));
+}
+
+bool ProjectSaver::waitForFinished()
+{
+    m_threadPool.waitForDone();
+    // Report each failure once so that a later wait is not blocked by it.
+    return m_succeeded.fetchAndStoreOrdered(1);
+}
+
+void ProjectSaver::reportProgress(const QString& filename, int percent)
+{
+    // Emitted from the worker; receivers in the GUI thread get a queued call.
+    emit progressUpdated(filename, percent);
+}
+
+void ProjectSaver::reportFinished(const QString& filename, bool success, const QString& errorString)
+{
+    if (!success)
+        m_succeeded.store(0);
+    if (success)
+        emit saved(filename);
+    else
+        emit failed(filename, errorString);
+}
+
+bool ProjectSaver::writeFile(const QString& filename, const QByteArray& xml,
+                             QString* errorString, ProjectSaver* saver)
+{
+    QString ignored;
+    if (!errorString)
+        errorString = &ignored;
+    if (xml.isEmpty()) {
+        *errorString = "nothing to save";
+        LOG_ERROR() << *errorString << filename;
+        return false;
+    }
+
+    // Check that the XML is well-formed before touching any file.
+    QXmlStreamReader reader(xml);
+    while (!reader.atEnd())
+        reader.readNext();
+    if (reader.hasError()) {
+        *errorString = reader.errorString();
+        LOG_ERROR() << "XML is not well-formed" << filename << *errorString;
+        return false;
+    }
+    if (saver)
+        saver->reportProgress(filename, 10);
+
+    // Write to a temporary file next to the target.
+    QFileInfo fi(filename);
+    QTemporaryFile tmp;
+    tmp.setFileTemplate(fi.absolutePath().append("/shotcut-XXXXXX.mlt"));
+    if (!tmp.open()) {
+        *errorString = tmp.errorString();
+        LOG_ERROR() << "failed to create temporary file" << tmp.fileTemplate() << *errorString;
+        return false;
+    }
+    LOG_DEBUG() << "writing temporary XML file" << tmp.fileName();
+    for (qint64 offset = 0; offset < xml.size(); offset += kChunkSize) {
+        qint64 n = qMin(kChunkSize, xml.size() - offset);
+        if (tmp.write(xml.constData() + offset, n) != n) {
+            *errorString = tmp.errorString();
+            LOG_ERROR() << "failed to write temporary file" << tmp.fileName() << *errorString;
+            return false;
+        }
+        if (saver)
+            saver->reportProgress(filename, 10 + 40 * (offset + n) / xml.size());
+    }
+    if (!tmp.flush()) {
+        *errorString = tmp.errorString();
+        LOG_ERROR() << "failed to write temporary file" << tmp.fileName() << *errorString;
+        return false;
+    }
+    tmp.close();
+
+    // QFile::rename() can fail and remove the destination file. See its docs.
+    // So, save an existing target file as a backup.
+    QString backupName;
+    if (QFile::exists(filename)) {
+        QTemporaryFile backupTmp;
+        backupTmp.setFileTemplate(
+            QString("%1/%2 - backup - XXXXXX.mlt").arg(fi.absolutePath()).arg(fi.completeBaseName()));
+        // Only remove the backup file if we successfully move the temp file to target.
+        backupTmp.setAutoRemove(false);
+        QFile existingFile(filename);
+        if (!existingFile.open(QIODevice::ReadOnly)) {
+            // Do not overwrite the backup file.
+            *errorString = existingFile.errorString();
+            LOG_ERROR() << "failed to open existing file" << filename << "for backup:" << *errorString;
+            return false;
+        }
+        if (!backupTmp.open()) {
+            *errorString = backupTmp.errorString();
+            LOG_ERROR() << "failed to create backup file" << backupTmp.fileTemplate() << *errorString;
+            return false;
+        }
+        backupName = backupTmp.fileName();
+        LOG_DEBUG() << "copy to backup" << filename << backupName;
+        qint64 size = existingFile.size();
+        qint64 copied = 0;
+        QByteArray buffer;
+        while (!(buffer = existingFile.read(kChunkSize)).isEmpty()) {
+            if (backupTmp.write(buffer) != buffer.size()) {
+                *errorString = backupTmp.errorString();
+                LOG_ERROR() << "backup error" << *errorString;
+                return false;
+            }
+            copied += buffer.size();
+            if (saver)
+                saver->reportProgress(filename, 50 + 40 * copied / size);
+        }
+        if (existingFile.error() != QFileDevice::NoError) {
+            *errorString = existingFile.errorString();
+            LOG_ERROR() << "backup error" << *errorString;
+            return false;
+        }
+        if (backupTmp.size() != size) {
+            *errorString = QString("backup file size problem: existing file size %1, backup file size %2")
+                    .arg(size).arg(backupTmp.size());
+            LOG_ERROR() << *errorString;
+            return false;
+        }
+        backupTmp.close();
+        existingFile.close();
+        // Remove the existing file as its name becomes the target for rename.
+        if (!existingFile.remove()) {
+            *errorString = existingFile.errorString();
+            LOG_ERROR() << "failed to remove existing file" << filename;
+            return false;
+        }
+    }
+
+    // The file is good, so move it into place.
+    LOG_DEBUG() << "rename" << tmp.fileName() << filename;
+    tmp.setAutoRemove(false);
+    int attempts = 5;
+    for (int i = 0; i < attempts; i++) {
+        if (tmp.rename(filename)) {
+            // Double-check the rename operation.
+            if (QFile::exists(filename) && QFile::exists(backupName))
+                QFile::remove(backupName);
+            if (saver)
+                saver->reportProgress(filename, 100);
+            return true;
+        }
+        LOG_WARNING() << "rename failed, trying again";
+#ifdef Q_OS_WIN
+        ::Sleep(200);
+#else
+        ::usleep(200000);
+#endif
+    }
+    *errorString = tmp.errorString();
+    LOG_ERROR() << "rename failed" << tmp.fileName() << filename;
+    return false;
+}
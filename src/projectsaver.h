@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROJECTSAVER_H
+#define PROJECTSAVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+/// Writes serialized MLT XML to a file in a background thread.
+///
+/// The XML is produced on the GUI thread, which is the only part of a save
+/// that touches the service graph. Checking that it is well-formed, writing
+/// a temporary file, backing up the existing file and renaming into place
+/// run on a worker. Saves run one at a time in the order requested.
+class ProjectSaver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProjectSaver(QObject* parent = 0);
+    ~ProjectSaver();
+
+    /// Starts writing xml to filename and returns immediately.
+    void save(const QString& filename, const QByteArray& xml);
+    /// Blocks until all requested saves are done and returns whether all of them
+    /// succeeded since the previous call.
+    bool waitForFinished();
+
+    /// Writes xml to filename in the calling thread, replacing the file only after
+    /// the new contents are completely written. Optionally reports progress to saver.
+    static bool writeFile(const QString& filename, const QByteArray& xml,
+                          QString* errorString = 0, ProjectSaver* saver = 0);
+
+signals:
+    void progressUpdated(const QString& filename, int percent);
+    void saved(const QString& filename);
+    void failed(const QString& filename, const QString& errorString);
+
+private:
+    friend class ProjectSaveTask;
+    void reportProgress(const QString& filename, int percent);
+    void reportFinished(const QString& filename, bool success, const QString& errorString);
+
+    QThreadPool m_threadPool;
+    QAtomicInt m_succeeded;
+};
+
+#endif // PROJECTSAVER_H
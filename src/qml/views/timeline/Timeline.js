@@ -35,6 +35,12 @@ function scrollIfNeeded() {
     }
 }
 
+function updateVisibleRange() {
+    if (!scrollView) return;
+    var start = scrollView.flickableItem.contentX / multitrack.scaleFactor;
+    multitrack.setVisibleRange(start, start + scrollView.width / multitrack.scaleFactor);
+}
+
 function dragging(pos, duration) {
     if (tracksRepeater.count > 0) {
         var headerHeight = ruler.height + toolbar.height
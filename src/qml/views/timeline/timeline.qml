@@ -262,7 +262,11 @@ Rectangle {
                     width: root.width - headerWidth
                     height: root.height - ruler.height - toolbar.height
                     // workaround to fix https://github.com/mltframework/shotcut/issues/777
-                    flickableItem.onContentXChanged: rulerFlickable.contentX = flickableItem.contentX
+                    flickableItem.onContentXChanged: {
+                        rulerFlickable.contentX = flickableItem.contentX
+                        Logic.updateVisibleRange()
+                    }
+                    onWidthChanged: Logic.updateVisibleRange()
         
                     MouseArea {
                         width: tracksContainer.width + headerWidth
@@ -602,8 +606,14 @@ Rectangle {
 
     Connections {
         target: multitrack
-        onLoaded: toolbar.scaleSlider.value = Math.pow(multitrack.scaleFactor - 0.01, 1.0 / 3.0)
-        onScaleFactorChanged: Logic.scrollIfNeeded()
+        onLoaded: {
+            toolbar.scaleSlider.value = Math.pow(multitrack.scaleFactor - 0.01, 1.0 / 3.0)
+            Logic.updateVisibleRange()
+        }
+        onScaleFactorChanged: {
+            Logic.scrollIfNeeded()
+            Logic.updateVisibleRange()
+        }
     }
 
     // This provides continuous scrolling at the left/right edges.
@@ -21,6 +21,7 @@
 #include "controllers/filtercontroller.h"
 #include "jobqueue.h"
 #include "jobs/encodejob.h"
+#include "jobs/loudnessjob.h"
 #include "shotcut_mlt_properties.h"
 #include "settings.h"
 #include "util.h"
@@ -291,6 +292,16 @@ void QmlFilter::analyze(bool isAudio)
 {
     Mlt::Service service(mlt_service(m_filter.get_data("service")));
 
+    if (isAudio) {
+        // Measure loudness natively instead of rendering with melt.
+        LoudnessJob* job = new LoudnessJob(tr("Analyze %1")
+            .arg(QFileInfo(QString::fromUtf8(service.get("resource"))).fileName()));
+        job->addFilter(service, m_filter);
+        connect(job, &AbstractJob::finished, this, &QmlFilter::analyzeFinished);
+        JOBS.add(job);
+        return;
+    }
+
     // get temp filename for input xml
     QTemporaryFile tmp;
     tmp.open();
@@ -298,9 +309,9 @@ void QmlFilter::analyze(bool isAudio)
     m_filter.set("results", NULL, 0);
     int disable = m_filter.get_int("disable");
     m_filter.set("disable", 0);
-    if (!isAudio) m_filter.set("analyze", 1);
+    m_filter.set("analyze", 1);
     MLT.saveXML(tmp.fileName(), &service, false, false);
-    if (!isAudio) m_filter.set("analyze", 0);
+    m_filter.set("analyze", 0);
     m_filter.set("disable", disable);
 
     // get temp filename for output xml
@@ -324,10 +335,7 @@ void QmlFilter::analyze(bool isAudio)
         dom.documentElement().insertAfter(consumerNode, profiles.at(profiles.length() - 1));
     consumerNode.setAttribute("mlt_service", "xml");
     consumerNode.setAttribute("all", 1);
-    if (isAudio)
-        consumerNode.setAttribute("video_off", 1);
-    else
-        consumerNode.setAttribute("audio_off", 1);
+    consumerNode.setAttribute("audio_off", 1);
     consumerNode.setAttribute("no_meta", 1);
     consumerNode.setAttribute("resource", tmpTarget.fileName());
 
@@ -697,6 +705,44 @@ void AnalyzeDelegate::updateJob(EncodeJob* job, const QString& results)
 
 #endif
 
+void AnalyzeDelegate::applyResults(const QString& results)
+{
+#if LIBMLT_VERSION_INT >= MLT_VERSION_CPP_UPDATED
+    // look for filters by UUID in each pending export job.
+    foreach (AbstractJob* job, JOBS.jobs()) {
+        if (!job->ran() && typeid(*job) == typeid(EncodeJob)) {
+            updateJob(dynamic_cast<EncodeJob*>(job), results);
+        }
+    }
+
+    // Locate filters in memory by UUID.
+    FindFilterParser graphParser(m_uuid);
+    if (MAIN.isMultitrackValid()) {
+        graphParser.start(*MAIN.multitrack());
+        foreach (Mlt::Filter filter, graphParser.filters())
+            updateFilter(filter, results);
+    }
+    if (MAIN.playlist() && MAIN.playlist()->count() > 0) {
+        graphParser.start(*MAIN.playlist());
+        foreach (Mlt::Filter filter, graphParser.filters())
+            updateFilter(filter, results);
+    }
+    if (MLT.producer() && MLT.producer()->is_valid()) {
+        graphParser.start(*MLT.producer());
+        foreach (Mlt::Filter filter, graphParser.filters())
+            updateFilter(filter, results);
+    }
+    if (MLT.savedProducer() && MLT.savedProducer()->is_valid()) {
+        graphParser.start(*MLT.savedProducer());
+        foreach (Mlt::Filter filter, graphParser.filters())
+            updateFilter(filter, results);
+    }
+#else
+    updateFilter(m_filter, results);
+#endif
+    emit MAIN.filterController()->attachedModel()->changed();
+}
+
 void AnalyzeDelegate::onAnalyzeFinished(AbstractJob *job, bool isSuccess)
 {
     QString fileName = job->objectName();
@@ -704,45 +750,11 @@ void AnalyzeDelegate::onAnalyzeFinished(AbstractJob *job, bool isSuccess)
     if (isSuccess) {
 #if LIBMLT_VERSION_INT >= MLT_VERSION_CPP_UPDATED
         QString results = resultsFromXml(fileName, m_serviceName);
-        if (!results.isEmpty()) {
-            // look for filters by UUID in each pending export job.
-            foreach (AbstractJob* job, JOBS.jobs()) {
-                if (!job->ran() && typeid(*job) == typeid(EncodeJob)) {
-                    updateJob(dynamic_cast<EncodeJob*>(job), results);
-                }
-            }
-    
-            // Locate filters in memory by UUID.
-            FindFilterParser graphParser(m_uuid);
-            if (MAIN.isMultitrackValid()) {
-                graphParser.start(*MAIN.multitrack());
-                foreach (Mlt::Filter filter, graphParser.filters())
-                    updateFilter(filter, results);
-            }
-            if (MAIN.playlist() && MAIN.playlist()->count() > 0) {
-                graphParser.start(*MAIN.playlist());
-                foreach (Mlt::Filter filter, graphParser.filters())
-                    updateFilter(filter, results);
-            }
-            if (MLT.producer() && MLT.producer()->is_valid()) {
-                graphParser.start(*MLT.producer());
-                foreach (Mlt::Filter filter, graphParser.filters())
-                    updateFilter(filter, results);
-            }
-            if (MLT.savedProducer() && MLT.savedProducer()->is_valid()) {
-                graphParser.start(*MLT.savedProducer());
-                foreach (Mlt::Filter filter, graphParser.filters())
-                    updateFilter(filter, results);
-            }
-            emit MAIN.filterController()->attachedModel()->changed();
-        }
 #else
         QString results = resultsFromXml(fileName, m_filter.get("mlt_service"));
-        if (!results.isEmpty()) {
-            updateFilter(m_filter, results);
-            emit MAIN.filterController()->attachedModel()->changed();
-        }
 #endif
+        if (!results.isEmpty())
+            applyResults(results);
     } else if (!job->property("filename").isNull()) {
         QFile file(job->property("filename").toString());
         if (file.exists() && file.size() == 0)
@@ -137,6 +137,8 @@ class AnalyzeDelegate : public QObject
     Q_OBJECT
 public:
     explicit AnalyzeDelegate(Mlt::Filter& filter);
+    /// Sets the results on the filter and its copies in memory and in pending jobs.
+    void applyResults(const QString& results);
 
 public slots:
     void onAnalyzeFinished(AbstractJob *job, bool isSuccess);
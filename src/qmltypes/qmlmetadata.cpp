@@ -20,6 +20,7 @@
 #include "util.h"
 #include <Logger.h>
 #include <QVersionNumber>
+#include <QDataStream>
 
 QmlMetadata::QmlMetadata(QObject *parent)
     : QObject(parent)
@@ -48,6 +49,26 @@ void QmlMetadata::loadSettings()
     }
 }
 
+void QmlMetadata::serialize(QDataStream& stream) const
+{
+    stream << objectName() << qint32(m_type) << m_name << m_mlt_service << m_needsGPU
+           << m_qmlFileName << m_vuiFileName << m_isAudio << m_isHidden << m_isFavorite
+           << m_gpuAlt << m_allowMultiple << m_isClipOnly << m_isGpuCompatible;
+    m_keyframes.serialize(stream);
+}
+
+void QmlMetadata::deserialize(QDataStream& stream)
+{
+    QString name;
+    qint32 type;
+    stream >> name >> type >> m_name >> m_mlt_service >> m_needsGPU
+           >> m_qmlFileName >> m_vuiFileName >> m_isAudio >> m_isHidden >> m_isFavorite
+           >> m_gpuAlt >> m_allowMultiple >> m_isClipOnly >> m_isGpuCompatible;
+    setObjectName(name);
+    m_type = PluginType(type);
+    m_keyframes.deserialize(stream);
+}
+
 void QmlMetadata::setType(QmlMetadata::PluginType type)
 {
     m_type = type;
@@ -177,6 +198,28 @@ void QmlKeyframesMetadata::setDisabled()
     m_enabled = m_allowAnimateIn = m_allowAnimateOut = false;
 }
 
+void QmlKeyframesMetadata::serialize(QDataStream& stream) const
+{
+    stream << m_allowTrim << m_allowAnimateIn << m_allowAnimateOut << m_simpleProperties
+           << m_minimumVersion << m_enabled << qint32(m_parameters.size());
+    foreach (QmlKeyframesParameter* parameter, m_parameters)
+        parameter->serialize(stream);
+}
+
+void QmlKeyframesMetadata::deserialize(QDataStream& stream)
+{
+    qint32 count = 0;
+    stream >> m_allowTrim >> m_allowAnimateIn >> m_allowAnimateOut >> m_simpleProperties
+           >> m_minimumVersion >> m_enabled >> count;
+    qDeleteAll(m_parameters);
+    m_parameters.clear();
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QmlKeyframesParameter* parameter = new QmlKeyframesParameter(this);
+        parameter->deserialize(stream);
+        m_parameters << parameter;
+    }
+}
+
 QmlKeyframesParameter::QmlKeyframesParameter(QObject* parent)
     : QObject(parent)
     , m_isSimple(false)
@@ -185,3 +228,15 @@ QmlKeyframesParameter::QmlKeyframesParameter(QObject* parent)
     , m_maximum(0.0)
 {
 }
+
+void QmlKeyframesParameter::serialize(QDataStream& stream) const
+{
+    stream << m_name << m_property << m_gangedProperties << m_isSimple << m_isCurve
+           << m_minimum << m_maximum;
+}
+
+void QmlKeyframesParameter::deserialize(QDataStream& stream)
+{
+    stream >> m_name >> m_property >> m_gangedProperties >> m_isSimple >> m_isCurve
+           >> m_minimum >> m_maximum;
+}
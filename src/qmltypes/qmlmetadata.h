@@ -24,6 +24,8 @@
 #include <QUrl>
 #include <QQmlListProperty>
 
+class QDataStream;
+
 class QmlKeyframesParameter : public QObject
 {
     Q_OBJECT
@@ -46,6 +48,8 @@ public:
     bool isCurve() const { return m_isCurve; }
     double minimum() const { return m_minimum; }
     double maximum() const { return m_maximum; }
+    void serialize(QDataStream& stream) const;
+    void deserialize(QDataStream& stream);
 
 signals:
     void changed();
@@ -85,6 +89,8 @@ public:
     QmlKeyframesParameter *parameter(int index) const { return m_parameters[index]; }
     void checkVersion(const QString& version);
     void setDisabled();
+    void serialize(QDataStream& stream) const;
+    void deserialize(QDataStream& stream);
 
 signals:
     void changed();
@@ -130,6 +136,9 @@ public:
 
     explicit QmlMetadata(QObject *parent = 0);
     void loadSettings();
+    /// Writes the values set by the metadata QML for the metadata cache.
+    void serialize(QDataStream& stream) const;
+    void deserialize(QDataStream& stream);
 
     PluginType type() const { return m_type; }
     void setType(PluginType);
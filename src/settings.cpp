@@ -442,6 +442,16 @@ void ShotcutSettings::setPlayerZoom(float f)
     settings.setValue("player/zoom", f);
 }
 
+bool ShotcutSettings::playerFrameStats() const
+{
+    return settings.value("player/frameStats", false).toBool();
+}
+
+void ShotcutSettings::setPlayerFrameStats(bool b)
+{
+    settings.setValue("player/frameStats", b);
+}
+
 QString ShotcutSettings::playlistThumbnails() const
 {
     return settings.value("playlist/thumbnails", "small").toString();
@@ -603,6 +613,66 @@ void ShotcutSettings::setLoudnessScopeShowMeter(const QString& meter, bool b)
     settings.setValue("scope/loudness/" + meter, b);
 }
 
+QString ShotcutSettings::videoWaveformScopeMode() const
+{
+    return settings.value("scope/waveform/mode", "luma").toString();
+}
+
+void ShotcutSettings::setVideoWaveformScopeMode(const QString& mode)
+{
+    settings.setValue("scope/waveform/mode", mode);
+}
+
+int ShotcutSettings::videoWaveformScopeDecimation() const
+{
+    return qBound(1, settings.value("scope/waveform/decimation", 1).toInt(), 4);
+}
+
+void ShotcutSettings::setVideoWaveformScopeDecimation(int decimation)
+{
+    settings.setValue("scope/waveform/decimation", decimation);
+}
+
+QString ShotcutSettings::audioPeakMeterScopeBallistics() const
+{
+    return settings.value("scope/peakmeter/ballistics", "ppm").toString();
+}
+
+void ShotcutSettings::setAudioPeakMeterScopeBallistics(const QString& ballistics)
+{
+    settings.setValue("scope/peakmeter/ballistics", ballistics);
+}
+
+int ShotcutSettings::audioSpectrumScopeSize() const
+{
+    return qBound(1024, settings.value("scope/spectrum/size", 8192).toInt(), 32768);
+}
+
+void ShotcutSettings::setAudioSpectrumScopeSize(int size)
+{
+    settings.setValue("scope/spectrum/size", size);
+}
+
+QString ShotcutSettings::audioSpectrumScopeWindow() const
+{
+    return settings.value("scope/spectrum/window", "hann").toString();
+}
+
+void ShotcutSettings::setAudioSpectrumScopeWindow(const QString& window)
+{
+    settings.setValue("scope/spectrum/window", window);
+}
+
+int ShotcutSettings::audioSpectrumScopeOverlap() const
+{
+    return qBound(0, settings.value("scope/spectrum/overlap", 50).toInt(), 75);
+}
+
+void ShotcutSettings::setAudioSpectrumScopeOverlap(int percent)
+{
+    settings.setValue("scope/spectrum/overlap", percent);
+}
+
 int ShotcutSettings::drawMethod() const
 {
 #ifdef Q_OS_WIN
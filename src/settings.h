@@ -124,6 +124,8 @@ public:
     void setPlayerVolume(int);
     float playerZoom() const;
     void setPlayerZoom(float);
+    bool playerFrameStats() const;
+    void setPlayerFrameStats(bool);
 
     QString playlistThumbnails() const;
     void setPlaylistThumbnails(const QString&);
@@ -163,6 +165,18 @@ public:
 
     bool loudnessScopeShowMeter(const QString& meter) const;
     void setLoudnessScopeShowMeter(const QString& meter, bool b);
+    QString videoWaveformScopeMode() const;
+    void setVideoWaveformScopeMode(const QString& mode);
+    int videoWaveformScopeDecimation() const;
+    void setVideoWaveformScopeDecimation(int decimation);
+    QString audioPeakMeterScopeBallistics() const;
+    void setAudioPeakMeterScopeBallistics(const QString& ballistics);
+    int audioSpectrumScopeSize() const;
+    void setAudioSpectrumScopeSize(int size);
+    QString audioSpectrumScopeWindow() const;
+    void setAudioSpectrumScopeWindow(const QString& window);
+    int audioSpectrumScopeOverlap() const;
+    void setAudioSpectrumScopeOverlap(int percent);
 
     int drawMethod() const;
     void setDrawMethod(int);
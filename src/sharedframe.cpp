@@ -16,19 +16,198 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "sharedframe.h"
+#include <QMutex>
+#include <cmath>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define AUDIO_SSE2
+#   include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#   define AUDIO_NEON
+#   include <arm_neon.h>
+#endif
 
 class FrameData : public QSharedData
 {
 public:
-    FrameData() : f((mlt_frame)0) {};
-    FrameData(Mlt::Frame& frame) : f(frame) {};
+    enum AudioView {
+        PlanarView = 1,
+        InterleavedView = 2,
+        LevelsView = 4
+    };
+
+    FrameData() : f((mlt_frame)0), audioViews(0) {};
+    FrameData(Mlt::Frame& frame) : f(frame), audioViews(0) {};
     ~FrameData() {};
 
     Mlt::Frame f;
+
+    // Audio views computed on demand (mutex protected).
+    QMutex audioMutex;
+    int audioViews;
+    QVector<float> audioPlanar;
+    QVector<float> audioInterleaved;
+    QVector<float> audioPeaks;
+    QVector<float> audioRms;
 private:
     Q_DISABLE_COPY(FrameData)
 };
 
+// Converts interleaved 16-bit samples to planar float samples.
+static void convertS16ToPlanar(const int16_t* audio, int channels, int samples, float* planes)
+{
+    const float scale = 1.0f / 32768.0f;
+    int i = 0;
+#if defined(AUDIO_SSE2)
+    // Stereo is deinterleaved 4 sample frames at a time.
+    if (channels == 2) {
+        const __m128 vScale = _mm_set1_ps(scale);
+        float* left = planes;
+        float* right = planes + samples;
+        for (; i + 4 <= samples; i += 4) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(audio + i * 2));
+            // Sign extend the even (left) and odd (right) 16-bit samples.
+            __m128i l = _mm_srai_epi32(_mm_slli_epi32(in, 16), 16);
+            __m128i r = _mm_srai_epi32(in, 16);
+            _mm_storeu_ps(left + i, _mm_mul_ps(_mm_cvtepi32_ps(l), vScale));
+            _mm_storeu_ps(right + i, _mm_mul_ps(_mm_cvtepi32_ps(r), vScale));
+        }
+    }
+#elif defined(AUDIO_NEON)
+    if (channels == 2) {
+        const float32x4_t vScale = vdupq_n_f32(scale);
+        float* left = planes;
+        float* right = planes + samples;
+        for (; i + 4 <= samples; i += 4) {
+            int16x4x2_t in = vld2_s16(audio + i * 2);
+            vst1q_f32(left + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(in.val[0])), vScale));
+            vst1q_f32(right + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(in.val[1])), vScale));
+        }
+    }
+#endif
+    for (int c = 0; c < channels; ++c) {
+        float* plane = planes + c * samples;
+        for (int j = i; j < samples; ++j)
+            plane[j] = audio[j * channels + c] * scale;
+    }
+}
+
+// Computes the peak and RMS level of float samples.
+static void measure(const float* samples, int count, float* peak, float* rms)
+{
+    float maximum = 0.0f;
+    float sum = 0.0f;
+    int i = 0;
+#if defined(AUDIO_SSE2)
+    const __m128 vAbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 vMaximum = _mm_setzero_ps();
+    __m128 vSum = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 in = _mm_loadu_ps(samples + i);
+        vMaximum = _mm_max_ps(vMaximum, _mm_and_ps(in, vAbsMask));
+        vSum = _mm_add_ps(vSum, _mm_mul_ps(in, in));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, vMaximum);
+    maximum = qMax(qMax(lanes[0], lanes[1]), qMax(lanes[2], lanes[3]));
+    _mm_storeu_ps(lanes, vSum);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(AUDIO_NEON)
+    float32x4_t vMaximum = vdupq_n_f32(0.0f);
+    float32x4_t vSum = vdupq_n_f32(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t in = vld1q_f32(samples + i);
+        vMaximum = vmaxq_f32(vMaximum, vabsq_f32(in));
+        vSum = vmlaq_f32(vSum, in, in);
+    }
+    float lanes[4];
+    vst1q_f32(lanes, vMaximum);
+    maximum = qMax(qMax(lanes[0], lanes[1]), qMax(lanes[2], lanes[3]));
+    vst1q_f32(lanes, vSum);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < count; ++i) {
+        maximum = qMax(maximum, qAbs(samples[i]));
+        sum += samples[i] * samples[i];
+    }
+    *peak = maximum;
+    *rms = count > 0? std::sqrt(sum / count) : 0.0f;
+}
+
+// Computes the requested audio view and those it depends on. The caller
+// holds the audio mutex.
+static void computeAudioView(FrameData* d, const SharedFrame& frame, int view)
+{
+    if (d->audioViews & view)
+        return;
+    int channels = frame.get_audio_channels();
+    int samples = frame.get_audio_samples();
+    if (!frame.is_valid() || channels <= 0 || samples <= 0) {
+        d->audioViews |= view;
+        return;
+    }
+    if (view != FrameData::PlanarView)
+        computeAudioView(d, frame, FrameData::PlanarView);
+
+    switch (view) {
+    case FrameData::PlanarView: {
+        const void* audio = frame.get_audio();
+        if (!audio)
+            break;
+        d->audioPlanar.resize(channels * samples);
+        float* planes = d->audioPlanar.data();
+        switch (frame.get_audio_format()) {
+        case mlt_audio_s16:
+            convertS16ToPlanar(static_cast<const int16_t*>(audio), channels, samples, planes);
+            break;
+        case mlt_audio_s32:
+            for (int i = 0; i < channels * samples; ++i)
+                planes[i] = static_cast<const int32_t*>(audio)[i] / 2147483648.0f;
+            break;
+        case mlt_audio_s32le:
+            for (int c = 0; c < channels; ++c)
+                for (int i = 0; i < samples; ++i)
+                    planes[c * samples + i] = static_cast<const int32_t*>(audio)[i * channels + c] / 2147483648.0f;
+            break;
+        case mlt_audio_float:
+            memcpy(planes, audio, channels * samples * sizeof(float));
+            break;
+        case mlt_audio_f32le:
+            for (int c = 0; c < channels; ++c)
+                for (int i = 0; i < samples; ++i)
+                    planes[c * samples + i] = static_cast<const float*>(audio)[i * channels + c];
+            break;
+        default:
+            d->audioPlanar.clear();
+            break;
+        }
+        break;
+    }
+    case FrameData::InterleavedView:
+        if (!d->audioPlanar.isEmpty()) {
+            d->audioInterleaved.resize(channels * samples);
+            const float* planes = d->audioPlanar.constData();
+            float* out = d->audioInterleaved.data();
+            for (int c = 0; c < channels; ++c)
+                for (int i = 0; i < samples; ++i)
+                    out[i * channels + c] = planes[c * samples + i];
+        }
+        break;
+    case FrameData::LevelsView:
+        if (!d->audioPlanar.isEmpty()) {
+            d->audioPeaks.resize(channels);
+            d->audioRms.resize(channels);
+            for (int c = 0; c < channels; ++c)
+                measure(d->audioPlanar.constData() + c * samples, samples, &d->audioPeaks[c], &d->audioRms[c]);
+        }
+        break;
+    default:
+        break;
+    }
+    d->audioViews |= view;
+}
+
 SharedFrame::SharedFrame()
   : d(new FrameData)
 {
@@ -202,3 +381,31 @@ const int16_t* SharedFrame::get_audio() const
     int samples = get_audio_samples();
     return (int16_t*)d->f.get_audio(format, frequency, channels, samples);
 }
+
+const float* SharedFrame::get_audio_float_planar() const
+{
+    QMutexLocker locker(&d->audioMutex);
+    computeAudioView(d.data(), *this, FrameData::PlanarView);
+    return d->audioPlanar.isEmpty()? 0 : d->audioPlanar.constData();
+}
+
+const float* SharedFrame::get_audio_float_interleaved() const
+{
+    QMutexLocker locker(&d->audioMutex);
+    computeAudioView(d.data(), *this, FrameData::InterleavedView);
+    return d->audioInterleaved.isEmpty()? 0 : d->audioInterleaved.constData();
+}
+
+QVector<float> SharedFrame::get_audio_peaks() const
+{
+    QMutexLocker locker(&d->audioMutex);
+    computeAudioView(d.data(), *this, FrameData::LevelsView);
+    return d->audioPeaks;
+}
+
+QVector<float> SharedFrame::get_audio_rms() const
+{
+    QMutexLocker locker(&d->audioMutex);
+    computeAudioView(d.data(), *this, FrameData::LevelsView);
+    return d->audioRms;
+}
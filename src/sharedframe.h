@@ -21,6 +21,7 @@
 
 #include <QObject>
 #include <QExplicitlySharedDataPointer>
+#include <QVector>
 #include <MltFrame.h>
 #include <stdint.h>
 
@@ -42,6 +43,10 @@ class FrameData;
   the frame data (e.g. to resize the image), then the object must call clone()
   to receive it's own non-const copy of the frame.
 
+  The audio is also available as float samples and per-channel levels. These
+  views are computed on first use, at most once per frame, and shared by all
+  copies.
+
   TODO: Consider providing a similar class in Mlt++.
 */
 
@@ -69,6 +74,18 @@ public:
     int get_audio_frequency() const;
     int get_audio_samples() const;
     const int16_t* get_audio() const;
+    /*!
+      Returns the audio as planar float samples, one plane of
+      get_audio_samples() per channel, or 0 if the format is not supported.
+      The pointer is valid as long as a copy of this frame exists.
+    */
+    const float* get_audio_float_planar() const;
+    //! Returns the audio as interleaved float samples, like get_audio_float_planar().
+    const float* get_audio_float_interleaved() const;
+    //! Returns the peak level of each channel where 1.0 is full scale.
+    QVector<float> get_audio_peaks() const;
+    //! Returns the RMS level of each channel where 1.0 is full scale.
+    QVector<float> get_audio_rms() const;
 private:
     QExplicitlySharedDataPointer<FrameData> d;
 };
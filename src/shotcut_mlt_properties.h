@@ -80,6 +80,7 @@
 #define kFilterOutProperty "_shotcut:filter_out"
 #define kThumbnailInProperty "_shotcut:thumbnail-in"
 #define kThumbnailOutProperty "_shotcut:thumbnail-out"
+#define kThumbnailDeferredProperty "_shotcut:thumbnail-deferred"
 #define kUndoIdProperty "_shotcut:undo_id"
 #define kUuidProperty "_shotcut:uuid"
 #define kMultitrackItemProperty "_shotcut:multitrack-item"
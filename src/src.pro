@@ -43,6 +43,11 @@ SOURCES += main.cpp\
     dialogs/addencodepresetdialog.cpp \
     dialogs/filedatedialog.cpp \
     jobqueue.cpp \
+    mediaanalysisscheduler.cpp \
+    fftengine.cpp \
+    loudnessmeter.cpp \
+    startuptimer.cpp \
+    framestats.cpp \
     docks/jobsdock.cpp \
     dialogs/textviewerdialog.cpp \
     models/playlistmodel.cpp \
@@ -76,24 +81,33 @@ SOURCES += main.cpp\
     qmltypes/qmlview.cpp \
     qmltypes/thumbnailprovider.cpp \
     commands/timelinecommands.cpp \
+    commands/timelinebenchmark.cpp \
     util.cpp \
     widgets/lumamixtransition.cpp \
     autosavefile.cpp \
+    filerelinker.cpp \
+    projectsaver.cpp \
     widgets/directshowvideowidget.cpp \
     jobs/abstractjob.cpp \
     jobs/meltjob.cpp \
     jobs/encodejob.cpp \
     jobs/postjobaction.cpp \
     jobs/videoqualityjob.cpp \
+    jobs/loudnessjob.cpp \
     commands/playlistcommands.cpp \
     docks/scopedock.cpp \
     controllers/scopecontroller.cpp \
+    widgets/scopes/audioanalysis.cpp \
+    widgets/scopes/scopeframecache.cpp \
     widgets/scopes/scopewidget.cpp \
     widgets/scopes/audioloudnessscopewidget.cpp \
     widgets/scopes/audiopeakmeterscopewidget.cpp \
     widgets/scopes/audiospectrumscopewidget.cpp \
     widgets/scopes/audiowaveformscopewidget.cpp \
     widgets/scopes/videohistogramscopewidget.cpp \
+    widgets/scopes/videorgbparadescopewidget.cpp \
+    widgets/scopes/videovectorscopewidget.cpp \
+    widgets/scopes/videowaveformkernel.cpp \
     widgets/scopes/videowaveformscopewidget.cpp \
     sharedframe.cpp \
     widgets/audioscale.cpp \
@@ -116,6 +130,7 @@ SOURCES += main.cpp\
     widgets/textproducerwidget.cpp \
     dialogs/listselectiondialog.cpp \
     widgets/newprojectfolder.cpp \
+    widgets/framestatswidget.cpp \
     qmltypes/webvfxtemplatesmodel.cpp \
     widgets/playlistlistview.cpp
 
@@ -155,6 +170,11 @@ HEADERS  += mainwindow.h \
     dialogs/addencodepresetdialog.h \
     dialogs/filedatedialog.h \
     jobqueue.h \
+    mediaanalysisscheduler.h \
+    fftengine.h \
+    loudnessmeter.h \
+    startuptimer.h \
+    framestats.h \
     docks/jobsdock.h \
     dialogs/textviewerdialog.h \
     models/playlistmodel.h \
@@ -189,24 +209,33 @@ HEADERS  += mainwindow.h \
     qmltypes/qmlview.h \
     qmltypes/thumbnailprovider.h \
     commands/timelinecommands.h \
+    commands/timelinebenchmark.h \
     util.h \
     widgets/lumamixtransition.h \
     autosavefile.h \
+    filerelinker.h \
+    projectsaver.h \
     widgets/directshowvideowidget.h \
     jobs/abstractjob.h \
     jobs/meltjob.h \
     jobs/encodejob.h \
     jobs/postjobaction.h \
     jobs/videoqualityjob.h \
+    jobs/loudnessjob.h \
     commands/playlistcommands.h \
     docks/scopedock.h \
     controllers/scopecontroller.h \
+    widgets/scopes/audioanalysis.h \
+    widgets/scopes/scopeframecache.h \
     widgets/scopes/scopewidget.h \
     widgets/scopes/audioloudnessscopewidget.h \
     widgets/scopes/audiopeakmeterscopewidget.h \
     widgets/scopes/audiospectrumscopewidget.h \
     widgets/scopes/audiowaveformscopewidget.h \
     widgets/scopes/videohistogramscopewidget.h \
+    widgets/scopes/videorgbparadescopewidget.h \
+    widgets/scopes/videovectorscopewidget.h \
+    widgets/scopes/videowaveformkernel.h \
     widgets/scopes/videowaveformscopewidget.h \
     dataqueue.h \
     sharedframe.h \
@@ -231,6 +260,7 @@ HEADERS  += mainwindow.h \
     widgets/textproducerwidget.h \
     dialogs/listselectiondialog.h \
     widgets/newprojectfolder.h \
+    widgets/framestatswidget.h \
     qmltypes/webvfxtemplatesmodel.h \
     widgets/playlistlistview.h
 
@@ -348,7 +378,7 @@ win32 {
         MLT_PATH = ..\\..\\..
     }
     INCLUDEPATH += $$MLT_PATH\\include\\mlt++ $$MLT_PATH\\include\\mlt
-    LIBS += -L$$MLT_PATH\\lib -lmlt++ -lmlt -lopengl32
+    LIBS += -L$$MLT_PATH\\lib -lmlt++ -lmlt -lopengl32 -lpsapi
     CONFIG(debug, debug|release) {
         INCLUDEPATH += $$PWD/../drmingw/include
         LIBS += -L$$PWD/../drmingw/x64/lib -lexchndl
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "startuptimer.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QList>
+#include <Logger.h>
+#include <cstdio>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+struct StartupPhase
+{
+    QString name;
+    qint64 ms;
+    bool isSeparate;
+};
+
+static QMutex mutex;
+static QElapsedTimer timer;
+static qint64 lastMark = 0;
+static QList<StartupPhase> phases;
+
+void StartupTimer::start()
+{
+    QMutexLocker locker(&mutex);
+    timer.start();
+    lastMark = 0;
+    phases.clear();
+}
+
+void StartupTimer::finish()
+{
+    QMutexLocker locker(&mutex);
+    timer.invalidate();
+    phases.clear();
+}
+
+void StartupTimer::mark(const QString& phase)
+{
+    QMutexLocker locker(&mutex);
+    if (!timer.isValid())
+        return;
+    qint64 now = timer.elapsed();
+    StartupPhase p = { phase, now - lastMark, false };
+    phases << p;
+    lastMark = now;
+    LOG_INFO() << "phase" << phase << "took" << p.ms << "ms, total" << now << "ms";
+}
+
+void StartupTimer::add(const QString& phase, qint64 ms)
+{
+    QMutexLocker locker(&mutex);
+    if (!timer.isValid())
+        return;
+    StartupPhase p = { phase, ms, true };
+    phases << p;
+    LOG_INFO() << "phase" << phase << "took" << ms << "ms (separate)";
+}
+
+bool StartupTimer::contains(const QString& phase)
+{
+    QMutexLocker locker(&mutex);
+    foreach (StartupPhase p, phases) {
+        if (p.name == phase)
+            return true;
+    }
+    return false;
+}
+
+qint64 StartupTimer::elapsed()
+{
+    QMutexLocker locker(&mutex);
+    return timer.isValid()? timer.elapsed() : 0;
+}
+
+qint64 StartupTimer::peakMemoryKiB()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize / 1024;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+        return 0;
+#if defined(Q_OS_MAC)
+    // macOS reports bytes, while Linux reports kilobytes.
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+void StartupTimer::report()
+{
+    QMutexLocker locker(&mutex);
+    QString text;
+    foreach (StartupPhase p, phases) {
+        text += QString("%1 %2 ms%3\n").arg(p.name, -24).arg(p.ms, 6)
+                .arg(p.isSeparate? " (separate)" : "");
+    }
+    text += QString("%1 %2 ms\n").arg("total", -24).arg(lastMark, 6);
+    text += QString("%1 %2 MiB\n").arg("peak memory", -24).arg(peakMemoryKiB() / 1024, 6);
+    fputs(text.toUtf8().constData(), stdout);
+    fflush(stdout);
+    LOG_INFO() << "benchmark\n" << text;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STARTUPTIMER_H
+#define STARTUPTIMER_H
+
+#include <QString>
+#include <QtGlobal>
+
+/// Records the duration of the phases of startup and logs each one.
+///
+/// It is also used to profile opening a project, for which start() is called
+/// again right before the open. Nothing is recorded after finish().
+///
+/// The phases on the GUI thread are consecutive: each call to mark() ends the
+/// phase that began with the previous one. Work that overlaps them, such as on
+/// another thread or nested in a phase, is recorded with add(). All methods
+/// are thread-safe.
+class StartupTimer
+{
+public:
+    /// Starts timing, which main() should do first.
+    static void start();
+    /// Stops recording, which main() does when startup is over.
+    static void finish();
+    /// Ends the current phase on the GUI thread and begins the next one.
+    static void mark(const QString& phase);
+    /// Records a phase that was timed separately.
+    static void add(const QString& phase, qint64 ms);
+    static bool contains(const QString& phase);
+    /// Returns the milliseconds since start().
+    static qint64 elapsed();
+    /// Returns the peak resident memory of the process.
+    static qint64 peakMemoryKiB();
+    /// Prints the phases, the total and the peak memory to stdout and the log.
+    static void report();
+
+private:
+    StartupTimer() {}
+};
+
+#endif // STARTUPTIMER_H
@@ -22,15 +22,27 @@
 #include <QColor>
 #include <QtAlgorithms>
 #include <QToolTip>
+#include <QTimer>
+#include <QEvent>
 
 static const int TEXT_PAD = 2;
+static const int BLOCK_INTERVAL_MS = 16;
+static const double MAX_BLOCK_BACKLOG_SECONDS = 0.2;
 
 AudioMeterWidget::AudioMeterWidget(QWidget *parent): QWidget(parent)
+  , m_pixmapsValid(false)
+  , m_blockChannels(0)
+  , m_blockDuration(0.0)
+  , m_blockTime(0.0)
+  , m_blockTimer(new QTimer(this))
 {
     const QFont& font = QWidget::font();
     const int fontSize = font.pointSize() - (font.pointSize() > 10? 2 : (font.pointSize() > 8? 1 : 0));
     QWidget::setFont(QFont(font.family(), fontSize));
     QWidget::setMouseTracking(true);
+    m_blockTimer->setTimerType(Qt::PreciseTimer);
+    m_blockTimer->setInterval(BLOCK_INTERVAL_MS);
+    connect(m_blockTimer, SIGNAL(timeout()), SLOT(onBlockTimeout()));
 }
 
 void AudioMeterWidget::setDbLabels(const QVector<int>& labels)
@@ -62,21 +74,83 @@ void AudioMeterWidget::setOrientation(Qt::Orientation orientation)
 
 void AudioMeterWidget::showAudio(const QVector<double>& dbLevels)
 {
-    m_levels = dbLevels;
-    if (m_peaks.size() != m_levels.size()) {
-        m_peaks = m_levels;
-        calcGraphRect();
-    } else {
-        for (int i = 0; i < m_levels.size(); i++)
+    QVector<double> peaks = dbLevels;
+    if (m_peaks.size() == dbLevels.size()) {
+        for (int i = 0; i < dbLevels.size(); i++)
         {
-            m_peaks[i] = m_peaks[i] - 0.2;
-            if (m_levels[i] >= m_peaks[i]) {
-                m_peaks[i] = m_levels[i];
+            peaks[i] = m_peaks[i] - 0.2;
+            if (dbLevels[i] >= peaks[i]) {
+                peaks[i] = dbLevels[i];
             }
         }
     }
+    setLevels(dbLevels, peaks);
+}
+
+void AudioMeterWidget::showBlocks(const QVector<double>& dbLevels, const QVector<double>& dbPeaks,
+                                  int channels, double blockDuration)
+{
+    if (channels <= 0 || blockDuration <= 0.0)
+        return;
+    if (channels != m_blockChannels) {
+        m_blockLevels.clear();
+        m_blockPeaks.clear();
+        m_blockChannels = channels;
+    }
+    m_blockDuration = blockDuration;
+    m_blockLevels += dbLevels;
+    m_blockPeaks += dbPeaks;
+
+    // Drop the oldest blocks if the display falls behind.
+    int maxBlocks = qMax(1, int(MAX_BLOCK_BACKLOG_SECONDS / blockDuration));
+    int excess = m_blockLevels.size() / channels - maxBlocks;
+    if (excess > 0) {
+        m_blockLevels.remove(0, excess * channels);
+        m_blockPeaks.remove(0, excess * channels);
+    }
+    if (!m_blockTimer->isActive()) {
+        m_blockTime = m_blockDuration;
+        m_blockClock.start();
+        m_blockTimer->start();
+        onBlockTimeout();
+    }
+}
+
+void AudioMeterWidget::onBlockTimeout()
+{
+    m_blockTime += m_blockClock.restart() / 1000.0;
+    int queued = m_blockLevels.size() / m_blockChannels;
+    int count = qMin(queued, int(m_blockTime / m_blockDuration));
+    if (count > 0) {
+        m_blockTime -= count * m_blockDuration;
+        // Show the highest level of the blocks due since the last update so
+        // that short transients are not missed.
+        QVector<double> levels(m_blockChannels, -100.0);
+        QVector<double> peaks(m_blockChannels);
+        for (int b = 0; b < count; b++) {
+            for (int c = 0; c < m_blockChannels; c++) {
+                levels[c] = qMax(levels[c], m_blockLevels[b * m_blockChannels + c]);
+                peaks[c] = m_blockPeaks[b * m_blockChannels + c];
+            }
+        }
+        m_blockLevels.remove(0, count * m_blockChannels);
+        m_blockPeaks.remove(0, count * m_blockChannels);
+        setLevels(levels, peaks);
+    }
+    if (m_blockLevels.isEmpty())
+        m_blockTimer->stop();
+}
+
+void AudioMeterWidget::setLevels(const QVector<double>& dbLevels, const QVector<double>& dbPeaks)
+{
+    bool resized = m_levels.size() != dbLevels.size();
+    m_levels = dbLevels;
+    m_peaks = dbPeaks;
+    if (resized)
+        calcGraphRect();
     update();
-    updateToolTip();
+    if (underMouse())
+        updateToolTip();
 }
 
 void AudioMeterWidget::calcGraphRect()
@@ -132,6 +206,50 @@ void AudioMeterWidget::calcGraphRect()
     if (m_maxDb > 0.0 ) {
         m_gradient.setColorAt(IEC_ScaleMax(m_maxDb, m_maxDb), Qt::darkRed);
     }
+    m_pixmapsValid = false;
+}
+
+void AudioMeterWidget::updatePixmaps()
+{
+    int ratio = devicePixelRatio();
+    QSize size = this->size() * ratio;
+
+    m_labelsPixmap = QPixmap(size);
+    m_labelsPixmap.setDevicePixelRatio(ratio);
+    m_labelsPixmap.fill(Qt::transparent);
+    QPainter p(&m_labelsPixmap);
+    p.setRenderHints(QPainter::Antialiasing);
+    p.setFont(font());
+    drawDbLabels(p);
+    drawChanLabels(p);
+    p.end();
+
+    // Every bar at full scale; paintEvent() copies the part for the level.
+    m_barsPixmap = QPixmap(size);
+    m_barsPixmap.setDevicePixelRatio(ratio);
+    m_barsPixmap.fill(Qt::transparent);
+    p.begin(&m_barsPixmap);
+    p.setRenderHints(QPainter::Antialiasing);
+    p.setBrush(m_gradient);
+    p.setPen(QPen(Qt::transparent, 1));
+    int chanCount = m_levels.size();
+    QRectF bar;
+    for (int i = 0; i < chanCount; i++) {
+        if (m_orient == Qt::Horizontal) {
+            bar.setLeft(m_graphRect.left());
+            bar.setRight(m_graphRect.left() + m_barSize.width());
+            bar.setBottom(m_graphRect.bottom() - (chanCount - 1 - i) * m_barSize.height() - 1);
+            bar.setTop(bar.bottom() - m_barSize.height() + 1);
+        } else {
+            bar.setLeft(m_graphRect.left() + i * m_barSize.width() + 1);
+            bar.setRight(bar.left() + m_barSize.width() - 1);
+            bar.setBottom(m_graphRect.bottom());
+            bar.setTop(m_graphRect.bottom() - m_barSize.height());
+        }
+        p.drawRoundedRect(bar, 3, 3);
+    }
+    p.end();
+    m_pixmapsValid = true;
 }
 
 void AudioMeterWidget::drawDbLabels(QPainter& p)
@@ -249,7 +367,7 @@ void AudioMeterWidget::drawBars(QPainter& p)
             bar.setRight(bar.left() + m_barSize.width() * level);
             bar.setBottom(m_graphRect.bottom() - (chanCount - 1 - i) * m_barSize.height() - 1);
             bar.setTop(bar.bottom() - m_barSize.height() + 1);
-            p.drawRoundedRect(bar, 3, 3);
+            drawBarPixmap(p, bar);
         }
     } else {
         for (int i = 0; i < chanCount; i++) {
@@ -258,11 +376,18 @@ void AudioMeterWidget::drawBars(QPainter& p)
             bar.setRight(bar.left() + m_barSize.width() - 1);
             bar.setBottom(m_graphRect.bottom());
             bar.setTop(bar.bottom() - m_barSize.height() * level);
-            p.drawRoundedRect(bar, 3, 3);
+            drawBarPixmap(p, bar);
         }
     }
 }
 
+void AudioMeterWidget::drawBarPixmap(QPainter& p, const QRectF& rect)
+{
+    qreal ratio = m_barsPixmap.devicePixelRatio();
+    QRectF source(rect.topLeft() * ratio, rect.size() * ratio);
+    p.drawPixmap(rect, m_barsPixmap, source);
+}
+
 void AudioMeterWidget::drawPeaks(QPainter& p)
 {
     int chanCount = m_peaks.size();
@@ -279,7 +404,7 @@ void AudioMeterWidget::drawPeaks(QPainter& p)
             bar.setRight(bar.left() + 3);
             bar.setBottom(m_graphRect.bottom() - (chanCount - 1 - i) * m_barSize.height() - 1);
             bar.setTop(bar.bottom() - m_barSize.height() + 1);
-            p.drawRoundedRect(bar, 3, 3);
+            drawBarPixmap(p, bar);
         }
     } else {
         for (int i = 0; i < chanCount; i++) {
@@ -292,7 +417,7 @@ void AudioMeterWidget::drawPeaks(QPainter& p)
             if (bar.bottom() > m_graphRect.bottom())
                 continue;
             bar.setTop(bar.bottom() - 3);
-            p.drawRoundedRect(bar, 3, 3);
+            drawBarPixmap(p, bar);
         }
     }
 }
@@ -339,19 +464,13 @@ void AudioMeterWidget::paintEvent(QPaintEvent* /*e*/)
     if (!isVisible())
         return;
 
-    QPainter p(this);
-    p.setRenderHints( QPainter::Antialiasing );
-
-    drawDbLabels(p);
-    drawChanLabels(p);
-
-    p.setBrush(m_gradient);
-    QPen pen(Qt::transparent, 1);
-    p.setPen(pen);
+    if (!m_pixmapsValid)
+        updatePixmaps();
 
+    QPainter p(this);
+    p.drawPixmap(0, 0, m_labelsPixmap);
     drawBars(p);
     drawPeaks(p);
-
     p.end();
 }
 
@@ -360,6 +479,13 @@ void AudioMeterWidget::resizeEvent(QResizeEvent*)
     calcGraphRect();
 }
 
+void AudioMeterWidget::changeEvent(QEvent* event)
+{
+    if (event->type() == QEvent::PaletteChange || event->type() == QEvent::FontChange)
+        m_pixmapsValid = false;
+    QWidget::changeEvent(event);
+}
+
 void AudioMeterWidget::mouseMoveEvent(QMouseEvent*)
 {
     updateToolTip();
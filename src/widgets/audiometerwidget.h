@@ -23,9 +23,12 @@
 #include <QVector>
 #include <QStringList>
 #include <QLinearGradient>
+#include <QPixmap>
+#include <QElapsedTimer>
 #include <stdint.h>
 
 class QLabel;
+class QTimer;
 
 class AudioMeterWidget : public QWidget
 {
@@ -39,17 +42,31 @@ public:
 
 public slots:
     void showAudio(const QVector<double>& dbLevels);
+    /*!
+      Queues meter blocks to be shown one after another at display rate.
+      \a dbLevels and \a dbPeaks hold the levels and held peaks of each block
+      interleaved by channel, and \a blockDuration is in seconds.
+    */
+    void showBlocks(const QVector<double>& dbLevels, const QVector<double>& dbPeaks,
+                    int channels, double blockDuration);
 
 protected:
     void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
     void resizeEvent(QResizeEvent*) Q_DECL_OVERRIDE;
     void mouseMoveEvent(QMouseEvent*) Q_DECL_OVERRIDE;
+    void changeEvent(QEvent*) Q_DECL_OVERRIDE;
+
+private slots:
+    void onBlockTimeout();
 
 private:
+    void setLevels(const QVector<double>& dbLevels, const QVector<double>& dbPeaks);
     void calcGraphRect();
+    void updatePixmaps();
     void drawDbLabels(QPainter&);
     void drawChanLabels(QPainter&);
     void drawBars(QPainter&);
+    void drawBarPixmap(QPainter&, const QRectF& rect);
     void drawPeaks(QPainter&);
     void updateToolTip();
     QRectF m_graphRect;
@@ -62,6 +79,17 @@ private:
     QLinearGradient m_gradient;
     double m_maxDb;
     QString m_chanLabelUnits;
+    // The labels and the bars at full scale are drawn once into pixmaps.
+    QPixmap m_labelsPixmap;
+    QPixmap m_barsPixmap;
+    bool m_pixmapsValid;
+    QVector<double> m_blockLevels;
+    QVector<double> m_blockPeaks;
+    int m_blockChannels;
+    double m_blockDuration;
+    double m_blockTime;
+    QElapsedTimer m_blockClock;
+    QTimer* m_blockTimer;
 };
 
 #endif
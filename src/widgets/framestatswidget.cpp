@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "framestatswidget.h"
+#include "framestats.h"
+#include "settings.h"
+#include "util.h"
+#include <Logger.h>
+#include <QtWidgets>
+
+static const int kUpdateIntervalMs = 500;
+
+FrameStatsWidget::FrameStatsWidget(QWidget *parent)
+    : QLabel(parent)
+{
+    setAutoFillBackground(true);
+    setAlignment(Qt::AlignLeft | Qt::AlignTop);
+    setMargin(4);
+    QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    setFont(font);
+    QPalette pal = palette();
+    pal.setColor(QPalette::Window, QColor(0, 0, 0, 160));
+    pal.setColor(QPalette::WindowText, Qt::white);
+    setPalette(pal);
+
+    setContextMenuPolicy(Qt::ActionsContextMenu);
+    QAction* action = new QAction(tr("Export Frames..."), this);
+    connect(action, SIGNAL(triggered()), SLOT(exportFrames()));
+    addAction(action);
+    action = new QAction(tr("Reset Counters"), this);
+    connect(action, SIGNAL(triggered()), SLOT(resetCounters()));
+    addAction(action);
+
+    m_timer.setInterval(kUpdateIntervalMs);
+    connect(&m_timer, SIGNAL(timeout()), SLOT(updateText()));
+    updateText();
+}
+
+void FrameStatsWidget::showEvent(QShowEvent *)
+{
+    updateText();
+    m_timer.start();
+}
+
+void FrameStatsWidget::hideEvent(QHideEvent *)
+{
+    m_timer.stop();
+}
+
+void FrameStatsWidget::updateText()
+{
+    FrameStats::Summary s = FrameStats::summary();
+    setText(tr("render %1 fps\n"
+               "decode %2 fps\n"
+               "upload %3 ms\n"
+               "latency %4 ms\n"
+               "queue %5\n"
+               "skipped %6\n"
+               "dropped %7\n"
+               "late %8")
+            .arg(s.renderFps, 0, 'f', 0)
+            .arg(s.decodeFps, 0, 'f', 0)
+            .arg(s.uploadMs, 0, 'f', 1)
+            .arg(s.latencyMs, 0, 'f', 1)
+            .arg(s.queueDepth)
+            .arg(s.skipped)
+            .arg(s.dropped)
+            .arg(s.late));
+    adjustSize();
+}
+
+void FrameStatsWidget::exportFrames()
+{
+    QString caption = tr("Export Frames");
+    QString fileName = QFileDialog::getSaveFileName(this, caption, Settings.savePath(),
+                                                    tr("CSV (*.csv);;All Files (*)"));
+    if (fileName.isEmpty())
+        return;
+    if (QFileInfo(fileName).suffix().isEmpty())
+        fileName += ".csv";
+    if (Util::warnIfNotWritable(fileName, this, caption))
+        return;
+
+    QFile file(fileName);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        QTextStream stream(&file);
+        FrameStats::exportCsv(stream);
+    } else {
+        LOG_ERROR() << "failed to write" << fileName << file.errorString();
+    }
+}
+
+void FrameStatsWidget::resetCounters()
+{
+    FrameStats::reset();
+    updateText();
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAMESTATSWIDGET_H
+#define FRAMESTATSWIDGET_H
+
+#include <QLabel>
+#include <QTimer>
+
+/// An overlay for the player that shows the frame statistics of FrameStats.
+/// Its context menu exports the recorded frames and resets the counters.
+class FrameStatsWidget : public QLabel
+{
+    Q_OBJECT
+
+public:
+    explicit FrameStatsWidget(QWidget *parent = 0);
+
+protected:
+    void showEvent(QShowEvent *);
+    void hideEvent(QHideEvent *);
+
+private slots:
+    void updateText();
+    void exportFrames();
+    void resetCounters();
+
+private:
+    QTimer m_timer;
+};
+
+#endif // FRAMESTATSWIDGET_H
@@ -23,6 +23,7 @@
 
 #include <QDebug>
 #include <QPainter>
+#include <QPixmapCache>
 #include <QMouseEvent>
 #include <QtMath>
 #include <QScrollBar>
@@ -30,6 +31,7 @@
 PlaylistIconView::PlaylistIconView(QWidget *parent)
     : QAbstractItemView(parent)
     , m_gridSize(170, 100)
+    , m_thumbnailSize(PlaylistModel::THUMBNAIL_WIDTH, PlaylistModel::THUMBNAIL_HEIGHT)
     , m_draggingOverPos(QPoint())
     , m_itemsPerRow(3)
 {
@@ -64,8 +66,11 @@ void PlaylistIconView::rowsAboutToBeRemoved(const QModelIndex &parent, int start
 void PlaylistIconView::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
 {
     QAbstractItemView::dataChanged(topLeft, bottomRight, roles);
-    updateSizes();
-    viewport()->update();
+    // A finished thumbnail only changes its own cell.
+    if (topLeft.row() == bottomRight.row())
+        viewport()->update(visualRect(topLeft).translated(0, -verticalScrollBar()->value()));
+    else
+        viewport()->update();
 }
 
 void PlaylistIconView::selectionChanged(const QItemSelection& selected, const QItemSelection& deselected)
@@ -160,8 +165,13 @@ void PlaylistIconView::paintEvent(QPaintEvent*)
 
     QAbstractItemModel * m = model();
     QRect dragIndicator;
+    const int scroll = verticalScrollBar()->value();
+    const bool showThumbnails = Settings.playlistThumbnails() != "hidden";
+    const int firstRow = scroll / m_gridSize.height();
+    const int lastRow = qMin((scroll + viewport()->height()) / m_gridSize.height(),
+                             m->rowCount() / m_itemsPerRow);
 
-    for (int row = 0; row <= m->rowCount() / m_itemsPerRow; row++) {
+    for (int row = firstRow; row <= lastRow; row++) {
         for (int col = 0; col < m_itemsPerRow; col++) {
             const int rowIdx = row * m_itemsPerRow + col;
 
@@ -169,20 +179,19 @@ void PlaylistIconView::paintEvent(QPaintEvent*)
             if (!idx.isValid())
                 break;
 
-            QRect itemRect(col * m_gridSize.width(), row * m_gridSize.height() - verticalScrollBar()->value(),
+            QRect itemRect(col * m_gridSize.width(), row * m_gridSize.height() - scroll,
                     m_gridSize.width(), m_gridSize.height());
 
-            if (itemRect.bottom() < 0 || itemRect.top() > this->height())
-                continue;
-
-            const bool selected = selectedIndexes().contains(idx);
-            const QImage thumb = idx.data(Qt::DecorationRole).value<QImage>();
+            const bool selected = selectionModel()->isSelected(idx);
 
             QRect imageBoundingRect = itemRect;
             imageBoundingRect.setHeight(0.7 * imageBoundingRect.height());
             imageBoundingRect.adjust(0, 10, 0, 0);
 
-            QRect imageRect(QPoint(), thumb.size());
+            // Until its thumbnail is ready, a clip shows an empty frame.
+            const QPixmap thumb = showThumbnails? thumbnail(idx, imageBoundingRect.size()) : QPixmap();
+            QRect imageRect(QPoint(), thumb.isNull()? m_thumbnailSize.boundedTo(imageBoundingRect.size())
+                                                    : thumb.size());
             imageRect.moveCenter(imageBoundingRect.center());
 
             QRect textRect = itemRect;
@@ -205,7 +214,10 @@ void PlaylistIconView::paintEvent(QPaintEvent*)
                 painter.drawLine(buttonRect.bottomLeft(), buttonRect.bottomRight());
             }
 
-            painter.drawImage(imageRect, thumb);
+            if (!thumb.isNull())
+                painter.drawPixmap(imageRect, thumb);
+            else if (showThumbnails)
+                painter.fillRect(imageRect, pal.base());
             painter.setPen(pal.color(QPalette::WindowText));
             painter.drawText(textRect, Qt::AlignCenter,
                     painter.fontMetrics().elidedText(idx.data(Qt::DisplayRole).toString(), Qt::ElideMiddle, textRect.width()));
@@ -226,6 +238,28 @@ void PlaylistIconView::paintEvent(QPaintEvent*)
     }
 }
 
+QPixmap PlaylistIconView::thumbnail(const QModelIndex& index, const QSize& boundingSize) const
+{
+    // The model composes the thumbnail from the images of the clip, which
+    // only happens again when they change or the cell size does.
+    const QString key = index.data(PlaylistModel::FIELD_THUMBNAIL_KEY).toString();
+    if (key.isEmpty())
+        return QPixmap();
+    const QString pixmapKey = QString("playlist %1 %2x%3").arg(key)
+            .arg(boundingSize.width()).arg(boundingSize.height());
+    QPixmap pixmap;
+    if (!QPixmapCache::find(pixmapKey, &pixmap)) {
+        QImage image = index.data(Qt::DecorationRole).value<QImage>();
+        if (image.isNull())
+            return QPixmap();
+        if (image.width() > boundingSize.width() || image.height() > boundingSize.height())
+            image = image.scaled(boundingSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        pixmap = QPixmap::fromImage(image);
+        QPixmapCache::insert(pixmapKey, pixmap);
+    }
+    return pixmap;
+}
+
 void PlaylistIconView::mouseReleaseEvent(QMouseEvent *event)
 {
     if (m_draggingOverPos.isNull() && m_pendingSelect.isValid()) {
@@ -326,6 +360,7 @@ void PlaylistIconView::updateSizes()
     else
         size = QSize(PlaylistModel::THUMBNAIL_WIDTH, PlaylistModel::THUMBNAIL_HEIGHT);
 
+    m_thumbnailSize = size;
     size.setWidth(size.width() + 10);
 
     m_itemsPerRow = qMax(1, viewport()->width() / size.width());
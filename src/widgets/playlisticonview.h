@@ -59,9 +59,11 @@ private slots:
 
 private:
     int rowWidth() const;
+    QPixmap thumbnail(const QModelIndex& index, const QSize& boundingSize) const;
     QAbstractItemView::DropIndicatorPosition position(const QPoint &pos, const QRect &rect, const QModelIndex &index) const;
 
     QSize m_gridSize;
+    QSize m_thumbnailSize;
     QPoint m_draggingOverPos;
     int m_itemsPerRow;
     bool m_isToggleSelect {false};
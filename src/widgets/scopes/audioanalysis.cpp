@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audioanalysis.h"
+#include <QtConcurrent/QtConcurrent>
+#include <cmath>
+#include <string.h>
+
+// The scopes queue up to 3 frames, and they may lag behind each other.
+static const int kMaxEntries = 8;
+// Enough to absorb a burst of frames without losing loudness measurements.
+static const int kMaxQueuedFrames = 25;
+static const float kMinimumDb = -100.0f;
+// Digital peak meter (IEC 60268-18): instant attack, 20 dB return in 1.7 s.
+static const float kPpmReturnDbPerSecond = 20.0f / 1.7f;
+// VU meter: 99% of a step in 300 ms.
+static const float kVuTimeConstant = 0.3f / 4.605f;
+static const float kPeakHoldSeconds = 1.5f;
+static const float kPeakHoldReturnDbPerSecond = 20.0f;
+
+const double AudioAnalysis::kBlockDuration = 0.005;
+
+static inline float toDb(float level)
+{
+    return level > 0.0f? qMax(kMinimumDb, 20.0f * std::log10(level)) : kMinimumDb;
+}
+
+AudioAnalysis::AudioAnalysis(QObject* parent)
+    : QObject(parent)
+    , m_queue(kMaxQueuedFrames, DataQueue<SharedFrame>::OverflowModeDiscardOldest)
+    , m_isRunning(false)
+    , m_fft(0)
+    , m_fftFrequency(0)
+    , m_fftHopPosition(0)
+    , m_blockSize(0)
+    , m_blockPosition(0)
+    , m_resetLoudness(0)
+    , m_mutex(QMutex::NonRecursive)
+    , m_spectrumSize(8192)
+    , m_spectrumWindow(FftEngine::HannWindow)
+    , m_spectrumOverlap(50)
+{
+}
+
+AudioAnalysis::~AudioAnalysis()
+{
+    m_future.waitForFinished();
+    delete m_fft;
+}
+
+AudioAnalysis& AudioAnalysis::singleton()
+{
+    static AudioAnalysis* instance = 0;
+    if (!instance)
+        instance = new AudioAnalysis();
+    return *instance;
+}
+
+AudioAnalysis::ResultPointer AudioAnalysis::result(const SharedFrame& frame) const
+{
+    if (!frame.is_valid())
+        return ResultPointer();
+    QMutexLocker locker(&m_mutex);
+    const int16_t* audio = frame.get_audio();
+    foreach (const Entry& entry, m_entries) {
+        if (entry.frame.get_audio() == audio)
+            return entry.result;
+    }
+    return ResultPointer();
+}
+
+void AudioAnalysis::onNewFrame(const SharedFrame& frame)
+{
+    m_queue.push(frame);
+    if (!m_isRunning) {
+        m_isRunning = true;
+        m_future = QtConcurrent::run(this, &AudioAnalysis::analyzeInThread);
+    }
+}
+
+void AudioAnalysis::resetLoudness()
+{
+    m_resetLoudness.storeRelease(1);
+}
+
+void AudioAnalysis::setSpectrumSettings(int size, FftEngine::Window window, int overlap)
+{
+    QMutexLocker locker(&m_mutex);
+    m_spectrumSize = size;
+    m_spectrumWindow = window;
+    m_spectrumOverlap = qBound(0, overlap, 90);
+}
+
+void AudioAnalysis::onAnalysisComplete()
+{
+    m_isRunning = false;
+    // Pick up any frame that arrived after the worker emptied the queue.
+    if (m_queue.count() > 0) {
+        m_isRunning = true;
+        m_future = QtConcurrent::run(this, &AudioAnalysis::analyzeInThread);
+    }
+}
+
+void AudioAnalysis::analyzeInThread()
+{
+    while (m_queue.count() > 0)
+        analyze(m_queue.pop());
+    QMetaObject::invokeMethod(this, "onAnalysisComplete", Qt::QueuedConnection);
+}
+
+void AudioAnalysis::analyze(const SharedFrame& frame)
+{
+    if (!frame.is_valid())
+        return;
+    int channels = frame.get_audio_channels();
+    int frequency = frame.get_audio_frequency();
+    int samples = frame.get_audio_samples();
+    if (channels <= 0 || frequency <= 0 || samples <= 0)
+        return;
+    const float* audio = frame.get_audio_float_planar();
+    if (!audio)
+        return;
+
+    Result* result = new Result;
+    result->channels = channels;
+    result->frequency = frequency;
+    result->samples = samples;
+    result->peaks = frame.get_audio_peaks();
+    result->rms = frame.get_audio_rms();
+    QVector<const float*> planes(channels);
+    for (int c = 0; c < channels; ++c)
+        planes[c] = audio + c * samples;
+
+    updateSpectrum(result, audio);
+
+    if (m_resetLoudness.testAndSetOrdered(1, 0))
+        m_loudness.reset();
+    if (channels != m_loudness.channels() || frequency != m_loudness.frequency()) {
+        m_blockSize = qMax(1, qRound(frequency * kBlockDuration));
+        m_blockPosition = 0;
+        m_blockPeak.fill(0.0f, channels);
+        m_blockSquares.fill(0.0f, channels);
+        m_ppm.fill(kMinimumDb, channels);
+        m_vu.fill(0.0f, channels);
+        m_hold.fill(kMinimumDb, channels);
+        m_holdAge.fill(0.0f, channels);
+    }
+    measureBlocks(result, audio);
+    m_loudness.setFormat(channels, frequency);
+    m_loudness.process(planes.constData(), samples);
+    result->momentary = m_loudness.momentary();
+    result->shortTerm = m_loudness.shortTerm();
+    result->integrated = m_loudness.integrated();
+    result->range = m_loudness.range();
+    result->samplePeak = m_loudness.samplePeak();
+    result->truePeak = m_loudness.truePeak();
+    result->samplesProcessed = m_loudness.samplesProcessed();
+
+    m_mutex.lock();
+    Entry entry;
+    entry.frame = frame;
+    entry.result = ResultPointer(result);
+    m_entries.prepend(entry);
+    while (m_entries.size() > kMaxEntries)
+        m_entries.removeLast();
+    m_mutex.unlock();
+
+    emit frameAnalyzed(frame);
+}
+
+void AudioAnalysis::measureBlocks(Result* result, const float* audio)
+{
+    const int channels = result->channels;
+    const int samples = result->samples;
+    const float duration = float(m_blockSize) / result->frequency;
+    const float ppmReturn = kPpmReturnDbPerSecond * duration;
+    const float holdReturn = kPeakHoldReturnDbPerSecond * duration;
+    const float vuCoefficient = 1.0f - std::exp(-duration / kVuTimeConstant);
+    result->blockDuration = duration;
+    result->blockCount = (m_blockPosition + samples) / m_blockSize;
+    result->ppm.resize(result->blockCount * channels);
+    result->vu.resize(result->blockCount * channels);
+    result->peakHold.resize(result->blockCount * channels);
+
+    int block = 0;
+    int offset = 0;
+    while (offset < samples) {
+        int count = qMin(samples - offset, m_blockSize - m_blockPosition);
+        for (int c = 0; c < channels; ++c) {
+            const float* in = audio + c * samples + offset;
+            float peak = m_blockPeak[c];
+            float squares = m_blockSquares[c];
+            for (int i = 0; i < count; ++i) {
+                peak = qMax(peak, qAbs(in[i]));
+                squares += in[i] * in[i];
+            }
+            m_blockPeak[c] = peak;
+            m_blockSquares[c] = squares;
+        }
+        offset += count;
+        m_blockPosition += count;
+        if (m_blockPosition < m_blockSize)
+            break;
+
+        for (int c = 0; c < channels; ++c) {
+            float peakDb = toDb(m_blockPeak[c]);
+            m_ppm[c] = qMax(peakDb, m_ppm[c] - ppmReturn);
+            m_vu[c] += (std::sqrt(m_blockSquares[c] / m_blockSize) - m_vu[c]) * vuCoefficient;
+            if (peakDb >= m_hold[c]) {
+                m_hold[c] = peakDb;
+                m_holdAge[c] = 0.0f;
+            } else if (m_holdAge[c] < kPeakHoldSeconds) {
+                m_holdAge[c] += duration;
+            } else {
+                m_hold[c] = qMax(m_ppm[c], m_hold[c] - holdReturn);
+            }
+            result->ppm[block * channels + c] = m_ppm[c];
+            result->vu[block * channels + c] = toDb(m_vu[c]);
+            result->peakHold[block * channels + c] = m_hold[c];
+            m_blockPeak[c] = 0.0f;
+            m_blockSquares[c] = 0.0f;
+        }
+        m_blockPosition = 0;
+        ++block;
+    }
+}
+
+void AudioAnalysis::updateSpectrum(Result* result, const float* audio)
+{
+    m_mutex.lock();
+    int size = m_spectrumSize;
+    FftEngine::Window window = m_spectrumWindow;
+    int overlap = m_spectrumOverlap;
+    m_mutex.unlock();
+
+    const int channels = result->channels;
+    const int samples = result->samples;
+    if (!m_fft || m_fft->size() != size || result->frequency != m_fftFrequency) {
+        delete m_fft;
+        m_fft = new FftEngine(size, window);
+        m_fftFrequency = result->frequency;
+        m_fftHopPosition = 0;
+        m_fftInput.fill(0.0f, size);
+        m_fftPowers.fill(0.0f, m_fft->binCount());
+        m_fftSum.fill(0.0f, m_fft->binCount());
+        m_spectrum.fill(0.0f, m_fft->binCount());
+    } else if (m_fft->window() != window) {
+        m_fft->setWindow(window);
+    }
+
+    // The transforms use a sliding window of the most recent samples mixed to
+    // mono, advancing by a hop that depends on the overlap.
+    const int hop = qMax(1, size * (100 - overlap) / 100);
+    const float scale = 1.0f / channels;
+    const int binCount = m_fft->binCount();
+    float* input = m_fftInput.data();
+    float* sum = m_fftSum.data();
+    int transforms = 0;
+    int offset = 0;
+    while (offset < samples) {
+        int count = qMin(samples - offset, hop - m_fftHopPosition);
+        memmove(input, input + count, (size - count) * sizeof(float));
+        float* mix = input + size - count;
+        for (int i = 0; i < count; ++i) {
+            float value = 0.0f;
+            for (int c = 0; c < channels; ++c)
+                value += audio[c * samples + offset + i];
+            mix[i] = value * scale;
+        }
+        offset += count;
+        m_fftHopPosition += count;
+        if (m_fftHopPosition == hop) {
+            m_fftHopPosition = 0;
+            m_fft->powers(input, m_fftPowers.data());
+            const float* powers = m_fftPowers.constData();
+            if (transforms == 0) {
+                memcpy(sum, powers, binCount * sizeof(float));
+            } else {
+                for (int k = 0; k < binCount; ++k)
+                    sum[k] += powers[k];
+            }
+            ++transforms;
+        }
+    }
+    if (transforms > 0) {
+        float* spectrum = m_spectrum.data();
+        for (int k = 0; k < binCount; ++k)
+            spectrum[k] = std::sqrt(sum[k] / transforms);
+    }
+    // Shared with the result until the next frame with a transform.
+    result->spectrum = m_spectrum;
+    result->binWidth = double(result->frequency) / size;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOANALYSIS_H
+#define AUDIOANALYSIS_H
+
+#include "sharedframe.h"
+#include "dataqueue.h"
+#include "fftengine.h"
+#include "loudnessmeter.h"
+#include <QObject>
+#include <QAtomicInt>
+#include <QFuture>
+#include <QMutex>
+#include <QList>
+#include <QSharedPointer>
+#include <QVector>
+
+/*!
+  \class AudioAnalysis
+  \brief Analyzes the audio of displayed frames once for all audio scopes.
+
+  \threadsafe
+
+  Frames are analyzed in order in a worker thread. The peak and RMS level of
+  each channel, the spectrum of the channel mix and the loudness are computed
+  from the float views of the SharedFrame audio.
+  frameAnalyzed() is emitted afterwards, and the scopes fetch the result for
+  the frame with result() from their own refresh thread.
+*/
+
+class AudioAnalysis : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Result {
+        int channels;
+        int frequency;
+        int samples;
+        //! Linear levels per channel where 1.0 is full scale.
+        QVector<float> peaks;
+        QVector<float> rms;
+        //! Linear magnitudes from 0 Hz to the Nyquist frequency, averaged
+        //! over the transforms completed during the frame.
+        QVector<float> spectrum;
+        double binWidth;
+        //! Loudness values in LUFS and LU, and peaks in dBFS and dBTP.
+        double momentary;
+        double shortTerm;
+        double integrated;
+        double range;
+        double samplePeak;
+        double truePeak;
+        qint64 samplesProcessed;
+        //! Meter levels in dBFS of the blocks completed in this frame,
+        //! interleaved by channel, with PPM and VU ballistics applied.
+        int blockCount;
+        double blockDuration;
+        QVector<float> ppm;
+        QVector<float> vu;
+        QVector<float> peakHold;
+    };
+    typedef QSharedPointer<const Result> ResultPointer;
+
+    static const double kBlockDuration;
+
+    static AudioAnalysis& singleton();
+    ~AudioAnalysis();
+
+    //! Returns the result for an analyzed frame or a null pointer.
+    ResultPointer result(const SharedFrame& frame) const;
+
+public slots:
+    //! Queues a frame for analysis. Should be called from the GUI thread.
+    void onNewFrame(const SharedFrame& frame);
+    //! Restarts the loudness measurement with the next frame.
+    void resetLoudness();
+    /*!
+      Sets the size and window of the spectrum transforms and how much
+      consecutive transforms overlap, in percent.
+    */
+    void setSpectrumSettings(int size, FftEngine::Window window, int overlap);
+
+signals:
+    void frameAnalyzed(const SharedFrame& frame);
+
+private:
+    explicit AudioAnalysis(QObject* parent = 0);
+    void analyzeInThread();
+    void analyze(const SharedFrame& frame);
+    void measureBlocks(Result* result, const float* audio);
+    void updateSpectrum(Result* result, const float* audio);
+    Q_INVOKABLE void onAnalysisComplete();
+
+    struct Entry {
+        SharedFrame frame;
+        ResultPointer result;
+    };
+
+    DataQueue<SharedFrame> m_queue;
+
+    // Members accessed only in the GUI thread.
+    QFuture<void> m_future;
+    bool m_isRunning;
+
+    // Members accessed only in the worker thread.
+    FftEngine* m_fft;
+    int m_fftFrequency;
+    int m_fftHopPosition;
+    QVector<float> m_fftInput;
+    QVector<float> m_fftPowers;
+    QVector<float> m_fftSum;
+    QVector<float> m_spectrum;
+    LoudnessMeter m_loudness;
+    int m_blockSize;
+    int m_blockPosition;
+    QVector<float> m_blockPeak;
+    QVector<float> m_blockSquares;
+    QVector<float> m_ppm; // dB
+    QVector<float> m_vu; // linear
+    QVector<float> m_hold; // dB
+    QVector<float> m_holdAge;
+
+    QAtomicInt m_resetLoudness;
+
+    // Members accessed in multiple threads (mutex protected).
+    mutable QMutex m_mutex;
+    QList<Entry> m_entries;
+    int m_spectrumSize;
+    FftEngine::Window m_spectrumWindow;
+    int m_spectrumOverlap;
+};
+
+#endif // AUDIOANALYSIS_H
@@ -27,7 +27,6 @@
 #include <QMenu>
 #include <QLabel>
 #include <QTimer>
-#include <MltProfile.h>
 #include <math.h>
 #include "qmltypes/qmlutilities.h"
 #include "mltcontroller.h"
@@ -40,7 +39,6 @@ static double onedec( double in )
 
 AudioLoudnessScopeWidget::AudioLoudnessScopeWidget()
   : ScopeWidget("AudioLoudnessMeter")
-  , m_loudnessFilter(0)
   , m_peak(-100)
   , m_true_peak(-100)
   , m_newData(false)
@@ -49,14 +47,6 @@ AudioLoudnessScopeWidget::AudioLoudnessScopeWidget()
   , m_timeLabel(new QLabel(this))
 {
     LOG_DEBUG() << "begin";
-    m_loudnessFilter = new Mlt::Filter(MLT.profile(), "loudness_meter");
-    m_loudnessFilter->set("calc_program", Settings.loudnessScopeShowMeter("integrated"));
-    m_loudnessFilter->set("calc_shortterm", Settings.loudnessScopeShowMeter("shortterm"));
-    m_loudnessFilter->set("calc_momentary", Settings.loudnessScopeShowMeter("momentary"));
-    m_loudnessFilter->set("calc_range", Settings.loudnessScopeShowMeter("range"));
-    m_loudnessFilter->set("calc_peak", Settings.loudnessScopeShowMeter("peak"));
-    m_loudnessFilter->set("calc_true_peak", Settings.loudnessScopeShowMeter("truepeak"));
-
     setAutoFillBackground(true);
 
     // Use a timer to update the meters for two reasons:
@@ -130,36 +120,24 @@ AudioLoudnessScopeWidget::AudioLoudnessScopeWidget()
 AudioLoudnessScopeWidget::~AudioLoudnessScopeWidget()
 {
     m_timer->stop();
-    delete m_loudnessFilter;
 }
 
 void AudioLoudnessScopeWidget::refreshScope(const QSize& /*size*/, bool /*full*/)
 {
-    SharedFrame sFrame;
     while (m_queue.count() > 0) {
-        sFrame = m_queue.pop();
-        if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
-            mlt_audio_format format = mlt_audio_f32le;
-            int channels = sFrame.get_audio_channels();
-            int frequency = sFrame.get_audio_frequency();
-            int samples = sFrame.get_audio_samples();
-            if (channels && frequency && samples) {
-                Mlt::Frame mFrame = sFrame.clone(true, false, false);
-                m_loudnessFilter->process(mFrame);
-                mFrame.get_audio(format, frequency, channels, samples);
-                if( m_peak < m_loudnessFilter->get_double("peak") ) {
-                    m_peak = m_loudnessFilter->get_double("peak");
-                }
-                if( m_true_peak < m_loudnessFilter->get_double("true_peak") ) {
-                    m_true_peak = m_loudnessFilter->get_double("true_peak");
-                }
-                m_newData = true;
+        AudioAnalysis::ResultPointer result = AudioAnalysis::singleton().result(m_queue.pop());
+        if (result) {
+            QMutexLocker locker(&m_mutex);
+            if (m_peak < result->samplePeak) {
+                m_peak = result->samplePeak;
+            }
+            if (m_true_peak < result->truePeak) {
+                m_true_peak = result->truePeak;
             }
+            m_result = result;
+            m_newData = true;
         }
     }
-
-    // Update the time with every frame.
-    m_timeLabel->setText( m_loudnessFilter->get_time( "frames_processed" ) );
 }
 
 QString AudioLoudnessScopeWidget::getTitle()
@@ -196,7 +174,7 @@ void AudioLoudnessScopeWidget::setOrientation(Qt::Orientation orientation, bool
 
 void AudioLoudnessScopeWidget::onResetButtonClicked()
 {
-    m_loudnessFilter->set("reset", 1);
+    AudioAnalysis::singleton().resetLoudness();
     m_timeLabel->setText( "00:00:00:00" );
     setOrientation(m_orientation, true);
     resetQview();
@@ -204,7 +182,6 @@ void AudioLoudnessScopeWidget::onResetButtonClicked()
 
 void AudioLoudnessScopeWidget::onIntegratedToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_program", checked);
     Settings.setLoudnessScopeShowMeter("integrated", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -212,7 +189,6 @@ void AudioLoudnessScopeWidget::onIntegratedToggled(bool checked)
 
 void AudioLoudnessScopeWidget::onShorttermToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_shortterm", checked);
     Settings.setLoudnessScopeShowMeter("shortterm", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -220,7 +196,6 @@ void AudioLoudnessScopeWidget::onShorttermToggled(bool checked)
 
 void AudioLoudnessScopeWidget::onMomentaryToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_momentary", checked);
     Settings.setLoudnessScopeShowMeter("momentary", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -228,7 +203,6 @@ void AudioLoudnessScopeWidget::onMomentaryToggled(bool checked)
 
 void AudioLoudnessScopeWidget::onRangeToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_range", checked);
     Settings.setLoudnessScopeShowMeter("range", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -236,7 +210,6 @@ void AudioLoudnessScopeWidget::onRangeToggled(bool checked)
 
 void AudioLoudnessScopeWidget::onPeakToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_peak", checked);
     Settings.setLoudnessScopeShowMeter("peak", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -244,7 +217,6 @@ void AudioLoudnessScopeWidget::onPeakToggled(bool checked)
 
 void AudioLoudnessScopeWidget::onTruePeakToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_true_peak", checked);
     Settings.setLoudnessScopeShowMeter("truepeak", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -252,19 +224,26 @@ void AudioLoudnessScopeWidget::onTruePeakToggled(bool checked)
 
 void AudioLoudnessScopeWidget::updateMeters(void)
 {
+    QMutexLocker locker(&m_mutex);
     if (!m_newData) return;
-    if (m_loudnessFilter->get_int("calc_program") )
-        m_qview->rootObject()->setProperty("integrated", onedec(m_loudnessFilter->get_double("program")));
-    if (m_loudnessFilter->get_int("calc_shortterm") )
-        m_qview->rootObject()->setProperty("shortterm", onedec(m_loudnessFilter->get_double("shortterm")));
-    if (m_loudnessFilter->get_int("calc_momentary") )
-        m_qview->rootObject()->setProperty("momentary", onedec(m_loudnessFilter->get_double("momentary")));
-    if (m_loudnessFilter->get_int("calc_range") )
-        m_qview->rootObject()->setProperty("range", onedec(m_loudnessFilter->get_double("range")));
-    if (m_loudnessFilter->get_int("calc_peak") )
+    if (Settings.loudnessScopeShowMeter("integrated"))
+        m_qview->rootObject()->setProperty("integrated", onedec(m_result->integrated));
+    if (Settings.loudnessScopeShowMeter("shortterm"))
+        m_qview->rootObject()->setProperty("shortterm", onedec(m_result->shortTerm));
+    if (Settings.loudnessScopeShowMeter("momentary"))
+        m_qview->rootObject()->setProperty("momentary", onedec(m_result->momentary));
+    if (Settings.loudnessScopeShowMeter("range"))
+        m_qview->rootObject()->setProperty("range", onedec(m_result->range));
+    if (Settings.loudnessScopeShowMeter("peak"))
         m_qview->rootObject()->setProperty("peak", onedec(m_peak));
-    if (m_loudnessFilter->get_int("calc_true_peak") )
+    if (Settings.loudnessScopeShowMeter("truepeak"))
         m_qview->rootObject()->setProperty("truePeak", onedec(m_true_peak));
+
+    // Show the time since the reset.
+    if (MLT.producer() && MLT.producer()->is_valid() && m_result->frequency > 0) {
+        int frames = qRound(double(m_result->samplesProcessed) * MLT.profile().fps() / m_result->frequency);
+        m_timeLabel->setText(MLT.producer()->frames_to_time(frames));
+    }
     m_peak = -100;
     m_true_peak = -100;
     m_newData = false;
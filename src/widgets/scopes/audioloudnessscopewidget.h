@@ -23,7 +23,7 @@
 #include <QMutex>
 #include <QImage>
 #include <QVector>
-#include <MltFilter.h>
+#include "audioanalysis.h"
 
 class QQuickWidget;
 class QLabel;
@@ -58,8 +58,9 @@ private:
     // Functions run in scope thread.
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
 
-    // Members accessed by scope thread.
-    Mlt::Filter* m_loudnessFilter;
+    // Members accessed in multiple threads (mutex protected).
+    QMutex m_mutex;
+    AudioAnalysis::ResultPointer m_result;
     double m_peak;
     double m_true_peak;
     bool m_newData;
@@ -19,21 +19,22 @@
 #include "audiopeakmeterscopewidget.h"
 #include <Logger.h>
 #include <QVBoxLayout>
-#include <MltProfile.h>
+#include <QMenu>
+#include <QActionGroup>
+#include <QContextMenuEvent>
+#include "audioanalysis.h"
 #include "widgets/audiometerwidget.h"
-#include "mltcontroller.h"
-#include <cmath> // log10()
+#include "settings.h"
 
 AudioPeakMeterScopeWidget::AudioPeakMeterScopeWidget()
   : ScopeWidget("AudioPeakMeter")
-  , m_filter(0)
+  , m_mutex(QMutex::NonRecursive)
+  , m_isVu(Settings.audioPeakMeterScopeBallistics() == "vu")
   , m_audioMeter(0)
   , m_orientation((Qt::Orientation)-1)
   , m_channels( 0 )
 {
     LOG_DEBUG() << "begin";
-    m_filter = new Mlt::Filter(MLT.profile(), "audiolevel");
-    m_filter->set("iec_scale", 0);
     qRegisterMetaType< QVector<double> >("QVector<double>");
     setAutoFillBackground(true);
 
@@ -50,7 +51,6 @@ AudioPeakMeterScopeWidget::AudioPeakMeterScopeWidget()
 
 AudioPeakMeterScopeWidget::~AudioPeakMeterScopeWidget()
 {
-    delete m_filter;
 }
 
 void AudioPeakMeterScopeWidget::refreshScope(const QSize& /*size*/, bool /*full*/)
@@ -58,25 +58,21 @@ void AudioPeakMeterScopeWidget::refreshScope(const QSize& /*size*/, bool /*full*
     SharedFrame sFrame;
     while (m_queue.count() > 0) {
         sFrame = m_queue.pop();
-        if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
-            mlt_audio_format format = mlt_audio_s16;
-            int channels = sFrame.get_audio_channels();
-            int frequency = sFrame.get_audio_frequency();
-            int samples = sFrame.get_audio_samples();
-            Mlt::Frame mFrame = sFrame.clone(true, false, false);
-            m_filter->process(mFrame);
-            mFrame.get_audio( format, frequency, channels, samples );
-            QVector<double> levels;
-            for (int i = 0; i < channels; i++) {
-                QString s = QString("meta.media.audio_level.%1").arg(i);
-                double audioLevel = mFrame.get_double(s.toLatin1().constData());
-                if (audioLevel == 0.0) {
-                    levels << -100.0;
-                } else {
-                    levels << 20 * log10(audioLevel);
-                }
+        AudioAnalysis::ResultPointer result = AudioAnalysis::singleton().result(sFrame);
+        if (result) {
+            int channels = result->channels;
+            m_mutex.lock();
+            const QVector<float>& blockLevels = m_isVu? result->vu : result->ppm;
+            m_mutex.unlock();
+            QVector<double> levels(blockLevels.size());
+            QVector<double> peaks(blockLevels.size());
+            for (int i = 0; i < blockLevels.size(); i++) {
+                levels[i] = blockLevels[i];
+                peaks[i] = result->peakHold[i];
             }
-            QMetaObject::invokeMethod(m_audioMeter, "showAudio", Qt::QueuedConnection, Q_ARG(const QVector<double>&, levels));
+            QMetaObject::invokeMethod(m_audioMeter, "showBlocks", Qt::QueuedConnection,
+                                      Q_ARG(const QVector<double>&, levels), Q_ARG(const QVector<double>&, peaks),
+                                      Q_ARG(int, channels), Q_ARG(double, result->blockDuration));
             if (m_channels != channels) {
                 m_channels = channels;
                 QMetaObject::invokeMethod(this, "reconfigureMeter", Qt::QueuedConnection);
@@ -99,6 +95,37 @@ void AudioPeakMeterScopeWidget::setOrientation(Qt::Orientation orientation)
     }
 }
 
+void AudioPeakMeterScopeWidget::contextMenuEvent(QContextMenuEvent* event)
+{
+    QMenu menu(this);
+    m_mutex.lock();
+    bool isVu = m_isVu;
+    m_mutex.unlock();
+
+    QActionGroup ballisticsGroup(this);
+    connect(&ballisticsGroup, SIGNAL(triggered(QAction*)), SLOT(onBallisticsTriggered(QAction*)));
+    QAction* action = menu.addAction(tr("Peak Program Meter"));
+    action->setData("ppm");
+    action->setCheckable(true);
+    action->setChecked(!isVu);
+    ballisticsGroup.addAction(action);
+    action = menu.addAction(tr("VU Meter"));
+    action->setData("vu");
+    action->setCheckable(true);
+    action->setChecked(isVu);
+    ballisticsGroup.addAction(action);
+
+    menu.exec(event->globalPos());
+}
+
+void AudioPeakMeterScopeWidget::onBallisticsTriggered(QAction* action)
+{
+    Settings.setAudioPeakMeterScopeBallistics(action->data().toString());
+    m_mutex.lock();
+    m_isVu = action->data().toString() == "vu";
+    m_mutex.unlock();
+}
+
 void AudioPeakMeterScopeWidget::reconfigureMeter()
 {
     // Set the bar labels.
@@ -23,9 +23,9 @@
 #include <QMutex>
 #include <QImage>
 #include <QVector>
-#include <MltFilter.h>
 
 class AudioMeterWidget;
+class QAction;
 
 class AudioPeakMeterScopeWidget Q_DECL_FINAL : public ScopeWidget
 {
@@ -41,8 +41,12 @@ private:
     // Functions run in scope thread.
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
 
-    // Members accessed by scope thread.
-    Mlt::Filter* m_filter;
+    // Functions run in GUI thread.
+    void contextMenuEvent(QContextMenuEvent* event) Q_DECL_OVERRIDE;
+
+    // Members accessed in multiple threads (mutex protected).
+    QMutex m_mutex;
+    bool m_isVu;
 
     // Members accessed by GUI thread.
     AudioMeterWidget* m_audioMeter;
@@ -51,6 +55,7 @@ private:
 
 private slots:
     void reconfigureMeter();
+    void onBallisticsTriggered(QAction* action);
 };
 
 #endif // AUDIOPEAKMETERSCOPEWIDGET_H
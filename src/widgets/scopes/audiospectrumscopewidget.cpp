@@ -17,194 +17,337 @@
  */
 
 #include "audiospectrumscopewidget.h"
-#include "widgets/audiometerwidget.h"
+#include "settings.h"
 #include <Logger.h>
 #include <QPainter>
-#include <QtAlgorithms>
-#include <QVBoxLayout>
-#include <MltProfile.h>
+#include <QMenu>
+#include <QActionGroup>
+#include <QContextMenuEvent>
+#include <QMouseEvent>
+#include <QToolTip>
 #include <cmath>
 
-static const int WINDOW_SIZE = 8000; // 6 Hz FFT bins at 48kHz
-
-struct band
-{
-    float low;    // Low frequency
-    float center; // Center frequency
-    float high;   // High frequency
-    const char* label;
-};
-
-// Preferred frequencies from ISO R 266-1997 / ANSI S1.6-1984
-static const band BAND_TAB[] =
-{
-//     Low      Preferred  High                Band
-//     Freq      Center    Freq     Label       Num
-    {     1.12,     1.25,     1.41, "1.25"  }, //  1
-    {     1.41,     1.60,     1.78, "1.6"   }, //  2
-    {     1.78,     2.00,     2.24, "2.0"   }, //  3
-    {     2.24,     2.50,     2.82, "2.5"   }, //  4
-    {     2.82,     3.15,     3.55, "3.15"  }, //  5
-    {     3.55,     4.00,     4.44, "4.0"   }, //  6
-    {     4.44,     5.00,     6.00, "5.0"   }, //  7
-    {     6.00,     6.30,     7.00, "6.3"   }, //  8
-    {     7.00,     8.00,     9.00, "8.0"   }, //  9
-    {     9.00,    10.00,    11.00, "10"    }, // 10
-    {    11.00,    12.50,    14.00, "12.5"  }, // 11
-    {    14.00,    16.00,    18.00, "16"    }, // 12
-    {    18.00,    20.00,    22.00, "20"    }, // 13 - First in audible range
-    {    22.00,    25.00,    28.00, "25"    }, // 14
-    {    28.00,    31.50,    35.00, "31"    }, // 15
-    {    35.00,    40.00,    45.00, "40"    }, // 16
-    {    45.00,    50.00,    56.00, "50"    }, // 17
-    {    56.00,    63.00,    71.00, "63"    }, // 18
-    {    71.00,    80.00,    90.00, "80"    }, // 19
-    {    90.00,   100.00,   112.00, "100"   }, // 20
-    {   112.00,   125.00,   140.00, "125"   }, // 21
-    {   140.00,   160.00,   179.00, "160"   }, // 22
-    {   179.00,   200.00,   224.00, "200"   }, // 23
-    {   224.00,   250.00,   282.00, "250"   }, // 24
-    {   282.00,   315.00,   353.00, "315"   }, // 25
-    {   353.00,   400.00,   484.00, "400"   }, // 26
-    {   484.00,   500.00,   560.00, "500"   }, // 27
-    {   560.00,   630.00,   706.00, "630"   }, // 28
-    {   706.00,   800.00,   897.00, "800"   }, // 29
-    {   897.00,  1000.00,  1121.00, "1k"    }, // 30
-    {  1121.00,  1250.00,  1401.00, "1.3k"  }, // 31
-    {  1401.00,  1600.00,  1794.00, "1.6k"  }, // 32
-    {  1794.00,  2000.00,  2242.00, "2k"    }, // 33
-    {  2242.00,  2500.00,  2803.00, "2.5k"  }, // 34
-    {  2803.00,  3150.00,  3531.00, "3.2k"  }, // 35
-    {  3531.00,  4000.00,  4484.00, "4k"    }, // 36
-    {  4484.00,  5000.00,  5605.00, "5k"    }, // 37
-    {  5605.00,  6300.00,  7062.00, "6.3k"  }, // 38
-    {  7062.00,  8000.00,  8908.00, "8k"    }, // 39
-    {  8908.00, 10000.00, 11210.00, "10k"   }, // 40
-    { 11210.00, 12500.00, 14012.00, "13k"   }, // 41
-    { 14012.00, 16000.00, 17936.00, "16k"   }, // 42
-    { 17936.00, 20000.00, 22421.00, "20k"   }, // 43 - Last in audible range
-};
-
-static const int FIRST_AUDIBLE_BAND_INDEX = 12;
-static const int LAST_AUDIBLE_BAND_INDEX = 42;
-static const int AUDIBLE_BAND_COUNT = LAST_AUDIBLE_BAND_INDEX - FIRST_AUDIBLE_BAND_INDEX + 1;
+static const double MIN_FREQUENCY = 20.0;
+static const double MAX_FREQUENCY = 20000.0;
+static const double MIN_DB = -90.0;
+static const double MAX_DB = 0.0;
+// The displayed level falls no faster than this to make it easier to read.
+static const double FALL_DB_PER_SECOND = 60.0;
+static const int LABEL_PAD = 4;
+
+static FftEngine::Window windowFromString(const QString& window)
+{
+    if (window == "rectangular")
+        return FftEngine::RectangularWindow;
+    else if (window == "hamming")
+        return FftEngine::HammingWindow;
+    else if (window == "blackman-harris")
+        return FftEngine::BlackmanHarrisWindow;
+    else if (window == "flattop")
+        return FftEngine::FlatTopWindow;
+    return FftEngine::HannWindow;
+}
+
+static QString windowToString(FftEngine::Window window)
+{
+    switch (window) {
+    case FftEngine::RectangularWindow:
+        return "rectangular";
+    case FftEngine::HammingWindow:
+        return "hamming";
+    case FftEngine::BlackmanHarrisWindow:
+        return "blackman-harris";
+    case FftEngine::FlatTopWindow:
+        return "flattop";
+    default:
+        return "hann";
+    }
+}
+
+static void applySettings()
+{
+    AudioAnalysis::singleton().setSpectrumSettings(Settings.audioSpectrumScopeSize(),
+        windowFromString(Settings.audioSpectrumScopeWindow()), Settings.audioSpectrumScopeOverlap());
+}
+
+static double frequencyAt(double x, double width, double maxFrequency)
+{
+    return MIN_FREQUENCY * pow(maxFrequency / MIN_FREQUENCY, x / qMax(1.0, width - 1.0));
+}
+
+static double xForFrequency(double frequency, double width, double maxFrequency)
+{
+    return log(frequency / MIN_FREQUENCY) / log(maxFrequency / MIN_FREQUENCY) * (width - 1.0);
+}
 
 AudioSpectrumScopeWidget::AudioSpectrumScopeWidget()
   : ScopeWidget("AudioSpectrum")
-  , m_audioMeter(0)
+  , m_columnsBinWidth(0.0)
+  , m_columnsBinCount(0)
+  , m_mutex(QMutex::NonRecursive)
+  , m_maxFrequency(MAX_FREQUENCY)
 {
     LOG_DEBUG() << "begin";
-
-    // Setup this widget
-    qRegisterMetaType< QVector<double> >("QVector<double>");
-
-    // Create the FFT filter
-    Mlt::Profile profile;
-    m_filter = new Mlt::Filter(profile, "fft");
-    m_filter->set("window_size", WINDOW_SIZE);
-
-    // Add the audio signal widget
-    QVBoxLayout *vlayout = new QVBoxLayout(this);
-    vlayout->setContentsMargins(4, 4, 4, 4);
-    m_audioMeter = new AudioMeterWidget(this);
-    m_audioMeter->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
-    QVector<int> dbscale;
-    dbscale << -50 << -40 << -35 << -30 << -25 << -20 << -15 << -10 << -5 << 0;
-    m_audioMeter->setDbLabels(dbscale);
-    QStringList freqLabels;
-    for (int i = FIRST_AUDIBLE_BAND_INDEX; i <= LAST_AUDIBLE_BAND_INDEX; i++) {
-        freqLabels << BAND_TAB[i].label;
-    }
-    m_audioMeter->setChannelLabels(freqLabels);
-    m_audioMeter->setChannelLabelUnits("Hz");
-    vlayout->addWidget(m_audioMeter);
-
-    // Config the size.
-    m_audioMeter->setOrientation(Qt::Vertical);
-    m_audioMeter->setMinimumSize(200, 80);
-    m_audioMeter->setMaximumSize(600, 600);
+    applySettings();
+    setMouseTracking(true);
     setMinimumSize(204, 84);
-    setMaximumSize(604, 604);
-
+    m_refreshTime.start();
     LOG_DEBUG() << "end";
 }
 
 AudioSpectrumScopeWidget::~AudioSpectrumScopeWidget()
 {
-    delete m_filter;
-}
-
-void AudioSpectrumScopeWidget::processSpectrum()
-{
-    QVector<double> bands(AUDIBLE_BAND_COUNT);
-    float* bins = (float*)m_filter->get_data("bins");
-    int bin_count = m_filter->get_int("bin_count");
-    double bin_width = m_filter->get_double("bin_width");
-
-    int band = 0;
-    bool firstBandFound = false;
-    for (int bin = 0; bin < bin_count; bin++) {
-        // Loop through all the FFT bins and align bin frequencies with
-        // band frequencies.
-        double F = bin_width * (double)bin;
-
-        if (!firstBandFound) {
-            // Skip bins that come before the first band.
-            if (BAND_TAB[band + FIRST_AUDIBLE_BAND_INDEX].low > F) {
-                continue;
-            } else {
-                firstBandFound = true;
-                bands[band] = bins[bin];
-            }
-        } else if (BAND_TAB[band + FIRST_AUDIBLE_BAND_INDEX].high < F) {
-            // This bin is outside of this band - move to the next band.
-            band++;
-            if ((band + FIRST_AUDIBLE_BAND_INDEX) > LAST_AUDIBLE_BAND_INDEX) {
-                // Skip bins that come after the last band.
-                break;
-            }
-            bands[band] = bins[bin];
-        } else if (bands[band] < bins[bin] ) {
-            // Pick the highest bin level within this band to represent the
-            // whole band.
-            bands[band] = bins[bin];
+}
+
+void AudioSpectrumScopeWidget::updateColumns(const QRect& graph, double binWidth, int binCount)
+{
+    int width = graph.width();
+    m_columns.resize(width);
+    m_levels.fill(MIN_DB, width);
+    m_polygon.resize(width + 2);
+    for (int x = 0; x < width; x++) {
+        // The range of bins covered by this column.
+        double low = frequencyAt(x - 0.5, width, m_maxFrequency) / binWidth;
+        double high = frequencyAt(x + 0.5, width, m_maxFrequency) / binWidth;
+        double center = frequencyAt(x, width, m_maxFrequency) / binWidth;
+        Column& column = m_columns[x];
+        column.first = qBound(0, int(ceil(low)), binCount - 1);
+        column.last = qBound(0, int(floor(high)), binCount - 1);
+        column.fraction = 0.0f;
+        if (column.last <= column.first) {
+            // Narrower than a bin: interpolate between the nearest two.
+            column.first = qBound(0, int(floor(center)), binCount - 2);
+            column.last = column.first;
+            column.fraction = float(qBound(0.0, center - column.first, 1.0));
         }
     }
+    m_columnsBinWidth = binWidth;
+    m_columnsBinCount = binCount;
+}
 
-    // At this point, bands contains the magnitude of the signal for each
-    // band. Convert to dB.
-    for (band = 0; band < bands.size(); band++) {
-        double mag = bands[band];
-        double dB = mag > 0.0 ? 20 * log10( mag ) : -1000.0;
-        bands[band] = dB;
+void AudioSpectrumScopeWidget::drawGrid(const QSize& size)
+{
+    QFont font = QWidget::font();
+    int fontSize = font.pointSize() - (font.pointSize() > 10? 2 : (font.pointSize() > 8? 1 : 0));
+    font.setPointSize(fontSize);
+    QFontMetrics fm(font);
+    QRect graph(fm.width("-90") + LABEL_PAD * 2, fm.height() / 2, 0, 0);
+    graph.setRight(size.width() - fm.width("20k") / 2 - 1);
+    graph.setBottom(size.height() - fm.height() - LABEL_PAD - 1);
+
+    m_gridImage = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    m_gridImage.fill(Qt::transparent);
+    QPainter p(&m_gridImage);
+    p.setFont(font);
+    QColor lineColor = palette().text().color();
+    lineColor.setAlpha(60);
+    QColor textColor = palette().text().color();
+
+    // Level lines every 10 dB.
+    for (int db = int(MAX_DB); db >= int(MIN_DB); db -= 10) {
+        int y = graph.top() + qRound((MAX_DB - db) / (MAX_DB - MIN_DB) * graph.height());
+        p.setPen(lineColor);
+        p.drawLine(graph.left(), y, graph.right(), y);
+        QString label = QString::number(db);
+        p.setPen(textColor);
+        p.drawText(graph.left() - LABEL_PAD - fm.width(label), y + fm.ascent() / 2, label);
     }
 
-    // Update the audio signal widget
-    QMetaObject::invokeMethod(m_audioMeter, "showAudio", Qt::QueuedConnection, Q_ARG(const QVector<double>&, bands));
+    // Frequency lines at 1, 2 and 5 times the powers of ten.
+    static const double frequencies[] = { 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000 };
+    static const char* labels[] = { "20", "50", "100", "200", "500", "1k", "2k", "5k", "10k", "20k" };
+    for (unsigned i = 0; i < sizeof(frequencies) / sizeof(frequencies[0]); i++) {
+        if (frequencies[i] > m_maxFrequency)
+            break;
+        int x = graph.left() + qRound(xForFrequency(frequencies[i], graph.width(), m_maxFrequency));
+        p.setPen(lineColor);
+        p.drawLine(x, graph.top(), x, graph.bottom());
+        QString label = labels[i];
+        p.setPen(textColor);
+        p.drawText(x - fm.width(label) / 2, graph.bottom() + LABEL_PAD + fm.ascent(), label);
+    }
+    p.end();
+
+    m_mutex.lock();
+    m_graphRect = graph;
+    m_mutex.unlock();
 }
 
-void AudioSpectrumScopeWidget::refreshScope(const QSize& /*size*/, bool /*full*/)
+void AudioSpectrumScopeWidget::refreshScope(const QSize& size, bool full)
 {
-    bool refresh = false;
-    SharedFrame sFrame;
-
     while (m_queue.count() > 0) {
-        sFrame = m_queue.pop();
-        if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
-            mlt_audio_format format = mlt_audio_s16;
-            int channels = sFrame.get_audio_channels();
-            int frequency = sFrame.get_audio_frequency();
-            int samples = sFrame.get_audio_samples();
-            Mlt::Frame mFrame = sFrame.clone(true, false, false);
-            m_filter->process(mFrame);
-            mFrame.get_audio( format, frequency, channels, samples );
-            refresh = true;
+        AudioAnalysis::ResultPointer result = AudioAnalysis::singleton().result(m_queue.pop());
+        if (result)
+            m_result = result;
+    }
+    if (!m_result || m_result->spectrum.size() < 2)
+        return;
+
+    double maxFrequency = qMin(MAX_FREQUENCY, m_result->frequency / 2.0);
+    if (full || m_gridImage.size() != size || maxFrequency != m_maxFrequency) {
+        m_mutex.lock();
+        m_maxFrequency = maxFrequency;
+        m_mutex.unlock();
+        drawGrid(size);
+        m_columnsBinCount = 0;
+    }
+    m_mutex.lock();
+    QRect graph = m_graphRect;
+    m_mutex.unlock();
+    if (graph.width() < 2 || graph.height() < 2)
+        return;
+    if (m_columnsBinCount != m_result->spectrum.size() || m_columnsBinWidth != m_result->binWidth
+            || m_columns.size() != graph.width())
+        updateColumns(graph, m_result->binWidth, m_result->spectrum.size());
+
+    // Convert the bins to the level of each column.
+    double fall = FALL_DB_PER_SECOND * m_refreshTime.restart() / 1000.0;
+    const float* bins = m_result->spectrum.constData();
+    int width = m_columns.size();
+    for (int x = 0; x < width; x++) {
+        const Column& column = m_columns[x];
+        float magnitude;
+        if (column.last > column.first) {
+            magnitude = bins[column.first];
+            for (int bin = column.first + 1; bin <= column.last; bin++)
+                magnitude = qMax(magnitude, bins[bin]);
+        } else {
+            magnitude = bins[column.first] + (bins[column.first + 1] - bins[column.first]) * column.fraction;
         }
+        double db = magnitude > 0.0f? 20.0 * log10(magnitude) : MIN_DB;
+        m_levels[x] = qBound(MIN_DB, qMax(db, m_levels[x] - fall), MAX_DB);
+        double y = graph.top() + (MAX_DB - m_levels[x]) / (MAX_DB - MIN_DB) * graph.height();
+        m_polygon[x] = QPointF(graph.left() + x, y);
     }
+    m_polygon[width] = QPointF(graph.left() + width - 1, graph.bottom());
+    m_polygon[width + 1] = QPointF(graph.left(), graph.bottom());
+
+    if (m_renderImage.size() != size)
+        m_renderImage = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    m_renderImage.fill(Qt::transparent);
+    QPainter p(&m_renderImage);
+    p.drawImage(0, 0, m_gridImage);
+    p.setRenderHint(QPainter::Antialiasing, true);
+    QColor color = palette().highlight().color();
+    QColor fillColor = color;
+    fillColor.setAlpha(80);
+    p.setPen(Qt::NoPen);
+    p.setBrush(fillColor);
+    p.drawPolygon(m_polygon.constData(), width + 2);
+    p.setPen(QPen(color, 1.5));
+    p.setBrush(Qt::NoBrush);
+    p.drawPolyline(m_polygon.constData(), width);
+    p.end();
+
+    m_mutex.lock();
+    m_displayImage.swap(m_renderImage);
+    m_mutex.unlock();
+}
+
+void AudioSpectrumScopeWidget::paintEvent(QPaintEvent*)
+{
+    if (!isVisible())
+        return;
+    QPainter p(this);
+    m_mutex.lock();
+    p.drawImage(0, 0, m_displayImage);
+    m_mutex.unlock();
+}
+
+void AudioSpectrumScopeWidget::mouseMoveEvent(QMouseEvent* event)
+{
+    m_mutex.lock();
+    QRect graph = m_graphRect;
+    double maxFrequency = m_maxFrequency;
+    m_mutex.unlock();
+    if (!graph.contains(event->pos())) {
+        QToolTip::hideText();
+        return;
+    }
+    double frequency = frequencyAt(event->pos().x() - graph.left(), graph.width(), maxFrequency);
+    double db = MAX_DB - double(event->pos().y() - graph.top()) / graph.height() * (MAX_DB - MIN_DB);
+    QString text = frequency < 1000.0? tr("%1 Hz").arg(frequency, 0, 'f', 0)
+                                     : tr("%1 kHz").arg(frequency / 1000.0, 0, 'f', 2);
+    text += QString("\n%1 dB").arg(db, 0, 'f', 1);
+    QToolTip::showText(event->globalPos(), text);
+}
+
+void AudioSpectrumScopeWidget::contextMenuEvent(QContextMenuEvent* event)
+{
+    QMenu menu(this);
+    int size = Settings.audioSpectrumScopeSize();
+    FftEngine::Window window = windowFromString(Settings.audioSpectrumScopeWindow());
+    int overlap = Settings.audioSpectrumScopeOverlap();
 
-    if (refresh) {
-        processSpectrum();
+    QActionGroup sizeGroup(this);
+    connect(&sizeGroup, SIGNAL(triggered(QAction*)), SLOT(onSizeTriggered(QAction*)));
+    for (int i = 1024; i <= 32768; i *= 2) {
+        QAction* action = menu.addAction(tr("%1 Samples").arg(i));
+        action->setData(i);
+        action->setCheckable(true);
+        action->setChecked(i == size);
+        sizeGroup.addAction(action);
     }
+
+    menu.addSeparator();
+    QActionGroup windowGroup(this);
+    connect(&windowGroup, SIGNAL(triggered(QAction*)), SLOT(onWindowTriggered(QAction*)));
+    QAction* action = menu.addAction(tr("Rectangular Window"));
+    action->setData(FftEngine::RectangularWindow);
+    windowGroup.addAction(action);
+    action = menu.addAction(tr("Hann Window"));
+    action->setData(FftEngine::HannWindow);
+    windowGroup.addAction(action);
+    action = menu.addAction(tr("Hamming Window"));
+    action->setData(FftEngine::HammingWindow);
+    windowGroup.addAction(action);
+    action = menu.addAction(tr("Blackman-Harris Window"));
+    action->setData(FftEngine::BlackmanHarrisWindow);
+    windowGroup.addAction(action);
+    action = menu.addAction(tr("Flat Top Window"));
+    action->setData(FftEngine::FlatTopWindow);
+    windowGroup.addAction(action);
+    foreach (QAction* a, windowGroup.actions()) {
+        a->setCheckable(true);
+        a->setChecked(a->data().toInt() == window);
+    }
+
+    menu.addSeparator();
+    QActionGroup overlapGroup(this);
+    connect(&overlapGroup, SIGNAL(triggered(QAction*)), SLOT(onOverlapTriggered(QAction*)));
+    action = menu.addAction(tr("No Overlap"));
+    action->setData(0);
+    overlapGroup.addAction(action);
+    action = menu.addAction(tr("50% Overlap"));
+    action->setData(50);
+    overlapGroup.addAction(action);
+    action = menu.addAction(tr("75% Overlap"));
+    action->setData(75);
+    overlapGroup.addAction(action);
+    foreach (QAction* a, overlapGroup.actions()) {
+        a->setCheckable(true);
+        a->setChecked(a->data().toInt() == overlap);
+    }
+
+    menu.exec(event->globalPos());
+}
+
+void AudioSpectrumScopeWidget::onSizeTriggered(QAction* action)
+{
+    Settings.setAudioSpectrumScopeSize(action->data().toInt());
+    applySettings();
+}
+
+void AudioSpectrumScopeWidget::onWindowTriggered(QAction* action)
+{
+    Settings.setAudioSpectrumScopeWindow(windowToString(FftEngine::Window(action->data().toInt())));
+    applySettings();
+}
+
+void AudioSpectrumScopeWidget::onOverlapTriggered(QAction* action)
+{
+    Settings.setAudioSpectrumScopeOverlap(action->data().toInt());
+    applySettings();
 }
 
 QString AudioSpectrumScopeWidget::getTitle()
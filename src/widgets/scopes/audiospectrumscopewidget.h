@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015 Meltytech, LLC
+ * Copyright (c) 2015-2019 Meltytech, LLC
  * Author: Brian Matherly <code@brianmatherly.com>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -19,11 +19,25 @@
 #ifndef AUDIOSPECTRUMSCOPEWIDGET_H
 #define AUDIOSPECTRUMSCOPEWIDGET_H
 
-
 #include "scopewidget.h"
-#include <MltFilter.h>
+#include "audioanalysis.h"
+#include <QMutex>
+#include <QImage>
+#include <QPolygonF>
+#include <QTime>
+
+class QAction;
 
-class AudioMeterWidget;
+/*!
+  \class AudioSpectrumScopeWidget
+  \brief Shows the spectrum of the audio as a line on a log frequency scale.
+
+  The spectrum comes from AudioAnalysis, whose transform size, window and
+  overlap are chosen from the context menu. Each column of the graph maps to
+  a range of bins, which is computed once per size and transform: columns
+  covering several bins show the highest, and narrower columns interpolate
+  between the nearest bins. Drawing reuses its buffers between frames.
+*/
 
 class AudioSpectrumScopeWidget Q_DECL_FINAL : public ScopeWidget
 {
@@ -35,15 +49,44 @@ public:
     QString getTitle() Q_DECL_OVERRIDE;
 
 private:
+    struct Column {
+        int first;
+        int last;
+        float fraction;
+    };
+
     // Functions run in scope thread.
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
-    void processSpectrum();
+    void updateColumns(const QRect& graph, double binWidth, int binCount);
+    void drawGrid(const QSize& size);
 
-    // Members accessed by scope thread.
-    Mlt::Filter* m_filter;
+    // Functions run in GUI thread.
+    void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
+    void mouseMoveEvent(QMouseEvent* event) Q_DECL_OVERRIDE;
+    void contextMenuEvent(QContextMenuEvent* event) Q_DECL_OVERRIDE;
+
+private slots:
+    void onSizeTriggered(QAction* action);
+    void onWindowTriggered(QAction* action);
+    void onOverlapTriggered(QAction* action);
+
+private:
+    // Members accessed only in scope thread (no thread protection).
+    AudioAnalysis::ResultPointer m_result;
+    QVector<Column> m_columns;
+    QVector<float> m_levels;
+    QPolygonF m_polygon;
+    QImage m_renderImage;
+    QImage m_gridImage;
+    QTime m_refreshTime;
+    double m_columnsBinWidth;
+    int m_columnsBinCount;
 
-    // Members accessed only in the GUI thread
-    AudioMeterWidget* m_audioMeter;
+    // Members accessed in multiple threads (mutex protected).
+    QMutex m_mutex;
+    QImage m_displayImage;
+    QRect m_graphRect;
+    double m_maxFrequency;
 };
 
 #endif // AUDIOSPECTRUMSCOPEWIDGET_H
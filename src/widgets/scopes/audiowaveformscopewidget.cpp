@@ -21,7 +21,7 @@
 #include <QPainter>
 #include <QResizeEvent>
 
-static const qreal MAX_AMPLITUDE = 32768.0;
+static const qreal MAX_AMPLITUDE = 1.0;
 
 static int graphHeight(const QSize& widgetSize, int maxChan, int padding)
 {
@@ -110,10 +110,10 @@ void AudioWaveformScopeWidget::refreshScope(const QSize& size, bool full)
     pen.setWidth(0);
     p.setPen(pen);
 
-    if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
+    const float* audio = sFrame.is_valid()? sFrame.get_audio_float_planar() : 0;
+    if (audio && sFrame.get_audio_samples() > 0) {
 
         int samples = sFrame.get_audio_samples();
-        int16_t* audio = (int16_t*)sFrame.get_audio();
         int waveAmplitude = graphHeight(size, m_channels, m_graphTopPadding) / 2;
         qreal scaleFactor = (qreal)waveAmplitude / (qreal)MAX_AMPLITUDE;
 
@@ -129,7 +129,7 @@ void AudioWaveformScopeWidget::refreshScope(const QSize& size, bool full)
             QPoint high;
             QPoint low;
             int lastX = 0;
-            const int16_t* q = audio + c;
+            const float* q = audio + c * samples;
             qreal max = *q;
             qreal min = *q;
 
@@ -152,14 +152,16 @@ void AudioWaveformScopeWidget::refreshScope(const QSize& size, bool full)
 
                     // Swap max and min so that the next line picks up where
                     // this one left off.
-                    int tmp = max;
+                    qreal tmp = max;
                     max = min;
                     min = tmp;
                 }
 
-                if (*q > max) max = *q;
-                if (*q < min) min = *q;
-                q += m_channels;
+                if (i < samples) {
+                    if (*q > max) max = *q;
+                    if (*q < min) min = *q;
+                    q++;
+                }
             }
             p.restore();
         }
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scopeframecache.h"
+#include "videowaveformkernel.h"
+
+// The scopes queue up to 3 frames, and they may lag behind each other.
+static const int kMaxEntries = 4;
+
+static inline uint8_t clamp8(int value)
+{
+    return value < 0? 0 : (value > 255? 255 : value);
+}
+
+ScopeFrameCache::ScopeFrameCache()
+    : m_mutex(QMutex::NonRecursive)
+{
+}
+
+ScopeFrameCache& ScopeFrameCache::singleton()
+{
+    static ScopeFrameCache instance;
+    return instance;
+}
+
+int ScopeFrameCache::step(int width)
+{
+    return qMax(1, (width + kMaxWidth - 1) / kMaxWidth);
+}
+
+ScopeFrameCache::ImagePointer ScopeFrameCache::image(const SharedFrame& frame, Format format)
+{
+    if (!frame.is_valid() || frame.get_image_format() != mlt_image_yuv420p
+            || frame.get_image_width() < 2 || frame.get_image_height() < 2)
+        return ImagePointer();
+
+    // The lock is held during the conversion so that concurrent scopes wait
+    // for the result instead of converting the same frame again.
+    QMutexLocker locker(&m_mutex);
+    const uint8_t* source = frame.get_image();
+    int index = -1;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries.at(i).frame.get_image() == source) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        Entry entry;
+        entry.frame = frame;
+        m_entries.prepend(entry);
+        while (m_entries.size() > kMaxEntries)
+            m_entries.removeLast();
+        index = 0;
+    }
+    ImagePointer& cached = m_entries[index].images[format];
+    if (cached)
+        return cached;
+
+    int width = frame.get_image_width();
+    int height = frame.get_image_height();
+    int s = step(width);
+    Image* image = new Image;
+    image->sourceWidth = width;
+    image->sourceHeight = height;
+    image->width = (width + s - 1) / s;
+    image->height = (height + s - 1) / s;
+    int planeSize = image->width * image->height;
+    switch (format) {
+    case RgbFormat:
+        image->data.resize(planeSize * 3);
+        VideoWaveformKernel::convertToRgb(source, width, height, s, image->data.data(),
+                                           image->data.data() + planeSize, image->data.data() + planeSize * 2);
+        break;
+    case ChromaFormat:
+        image->data.resize(planeSize * 2);
+        extractChroma(source, width, height, s, image->data.data(), image->data.data() + planeSize);
+        break;
+    default:
+        break;
+    }
+    cached = ImagePointer(image);
+    return cached;
+}
+
+void ScopeFrameCache::extractChroma(const uint8_t* image, int width, int height, int step,
+                                    uint8_t* u, uint8_t* v)
+{
+    int chromaWidth = width / 2;
+    int chromaHeight = height / 2;
+    const uint8_t* uPlane = image + width * height;
+    const uint8_t* vPlane = uPlane + chromaWidth * chromaHeight;
+    int samples = (width + step - 1) / step;
+
+    for (int y = 0; y < height; y += step) {
+        int chromaRow = qMin(y / 2, chromaHeight - 1) * chromaWidth;
+        const uint8_t* uRow = uPlane + chromaRow;
+        const uint8_t* vRow = vPlane + chromaRow;
+        for (int i = 0; i < samples; ++i) {
+            int cx = qMin(i * step / 2, chromaWidth - 1);
+            u[i] = uRow[cx];
+            v[i] = vRow[cx];
+        }
+        u += samples;
+        v += samples;
+    }
+}
+
+void ScopeFrameCache::convertFromBgra(const uint8_t* bgra, int width, int height, uint8_t* yuv)
+{
+    // Limited range BT.709 for HD and BT.601 otherwise in 8.8 fixed point.
+    bool isHD = height > 576;
+    const int yr = isHD? 47 : 66,   yg = isHD? 157 : 129, yb = isHD? 16 : 25;
+    const int ur = isHD? -26 : -38, ug = isHD? -86 : -74, ub = 112;
+    const int vr = 112,             vg = isHD? -102 : -94, vb = isHD? -10 : -18;
+    int chromaWidth = width / 2;
+    uint8_t* yPlane = yuv;
+    uint8_t* uPlane = yPlane + width * height;
+    uint8_t* vPlane = uPlane + chromaWidth * (height / 2);
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* in = bgra + y * width * 4;
+        uint8_t* out = yPlane + y * width;
+        for (int x = 0; x < width; x++, in += 4)
+            out[x] = clamp8(((yr * in[2] + yg * in[1] + yb * in[0] + 128) >> 8) + 16);
+    }
+    // Average each 2x2 block for the chroma.
+    for (int y = 0; y < height / 2; y++) {
+        const uint8_t* in0 = bgra + y * 2 * width * 4;
+        const uint8_t* in1 = in0 + width * 4;
+        uint8_t* u = uPlane + y * chromaWidth;
+        uint8_t* v = vPlane + y * chromaWidth;
+        for (int x = 0; x < chromaWidth; x++, in0 += 8, in1 += 8) {
+            int b = (in0[0] + in0[4] + in1[0] + in1[4] + 2) >> 2;
+            int g = (in0[1] + in0[5] + in1[1] + in1[5] + 2) >> 2;
+            int r = (in0[2] + in0[6] + in1[2] + in1[6] + 2) >> 2;
+            u[x] = clamp8(((ur * r + ug * g + ub * b + 128) >> 8) + 128);
+            v[x] = clamp8(((vr * r + vg * g + vb * b + 128) >> 8) + 128);
+        }
+    }
+}
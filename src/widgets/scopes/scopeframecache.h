@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCOPEFRAMECACHE_H
+#define SCOPEFRAMECACHE_H
+
+#include "sharedframe.h"
+#include <QMutex>
+#include <QList>
+#include <QSharedPointer>
+#include <QVector>
+#include <stdint.h>
+
+/*!
+  \class ScopeFrameCache
+  \brief Shares the converted and downsampled images of a frame among scopes.
+
+  \threadsafe
+
+  Every video scope receives the same yuv420p SharedFrame. Scopes that need a
+  different format ask the cache for it from their refresh thread. The first
+  scope to ask converts the frame and the others reuse the result, so each
+  format is computed at most once per frame, and only if an open scope needs
+  it. Images are downsampled to at most kMaxWidth columns.
+*/
+
+class ScopeFrameCache
+{
+public:
+    enum Format {
+        //! Three planes: red, green and blue.
+        RgbFormat,
+        //! Two planes: U (Cb) and V (Cr) at the same size as the luma.
+        ChromaFormat,
+        FormatCount
+    };
+
+    struct Image {
+        int width;
+        int height;
+        int sourceWidth;
+        int sourceHeight;
+        QVector<uint8_t> data;
+
+        const uint8_t* plane(int i) const { return data.constData() + i * width * height; }
+    };
+    typedef QSharedPointer<const Image> ImagePointer;
+
+    static const int kMaxWidth = 960;
+
+    static ScopeFrameCache& singleton();
+
+    /*!
+      Returns the image of a yuv420p frame in the requested format, converting
+      it if no other scope already did. Returns a null pointer for an invalid
+      frame.
+    */
+    ImagePointer image(const SharedFrame& frame, Format format);
+
+    //! Returns the sampling step used to downsample an image of \a width.
+    static int step(int width);
+
+    /*!
+      Converts a BGRA image, such as one read back from OpenGL, to yuv420p
+      using the same color matrix as VideoWaveformKernel::convertToRgb().
+      \a width and \a height must be even.
+    */
+    static void convertFromBgra(const uint8_t* bgra, int width, int height, uint8_t* yuv);
+
+private:
+    ScopeFrameCache();
+    static void extractChroma(const uint8_t* image, int width, int height, int step,
+                              uint8_t* u, uint8_t* v);
+
+    struct Entry {
+        SharedFrame frame;
+        ImagePointer images[FormatCount];
+    };
+
+    QMutex m_mutex;
+    QList<Entry> m_entries;
+};
+
+#endif // SCOPEFRAMECACHE_H
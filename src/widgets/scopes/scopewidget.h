@@ -82,6 +82,13 @@ public:
     */
     virtual void setOrientation(Qt::Orientation) {};
 
+    /*!
+      Returns true if the scope uses the image of the frames.
+      Video scopes receive frames with a yuv420p image, which is a reduced
+      size copy when using GPU processing.
+    */
+    virtual bool isVideoScope() const { return false; }
+
 public slots:
     //! Provides a new frame to the scope. Should be called by the application.
     virtual void onNewFrame(const SharedFrame& frame) Q_DECL_FINAL;
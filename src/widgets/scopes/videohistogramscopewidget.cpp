@@ -16,6 +16,7 @@
  */
 
 #include "videohistogramscopewidget.h"
+#include "scopeframecache.h"
 #include <Logger.h>
 #include <QMouseEvent>
 #include <QPainter>
@@ -67,19 +68,22 @@ void VideoHistogramScopeWidget::refreshScope(const QSize& size, bool full)
             pYbin[*p++]++;
         }
 
-        // Create RGB frame and bin the values.
-        Mlt::Frame rgbFrame = m_frame.clone(false, true, false);
-        mlt_image_format format = mlt_image_rgb24;
-        p = (uint8_t*)rgbFrame.get_image(format, width, height, 0);
-        count = width * height;
-        unsigned int* pRbin = rBins.data();
-        unsigned int* pGbin = gBins.data();
-        unsigned int* pBbin = bBins.data();
-        while (count--)
-        {
-            pRbin[*p++]++;
-            pGbin[*p++]++;
-            pBbin[*p++]++;
+        // Bin the values of the RGB image shared with the other scopes.
+        ScopeFrameCache::ImagePointer rgb = ScopeFrameCache::singleton().image(m_frame, ScopeFrameCache::RgbFormat);
+        if (rgb) {
+            count = rgb->width * rgb->height;
+            const uint8_t* pR = rgb->plane(0);
+            const uint8_t* pG = rgb->plane(1);
+            const uint8_t* pB = rgb->plane(2);
+            unsigned int* pRbin = rBins.data();
+            unsigned int* pGbin = gBins.data();
+            unsigned int* pBbin = bBins.data();
+            while (count--)
+            {
+                pRbin[*pR++]++;
+                pGbin[*pG++]++;
+                pBbin[*pB++]++;
+            }
         }
     }
 
@@ -29,6 +29,7 @@ class VideoHistogramScopeWidget Q_DECL_FINAL : public ScopeWidget
 public:
     explicit VideoHistogramScopeWidget();
     QString getTitle() Q_DECL_OVERRIDE;
+    bool isVideoScope() const Q_DECL_OVERRIDE { return true; }
 
 private:
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEORGBPARADESCOPEWIDGET_H
+#define VIDEORGBPARADESCOPEWIDGET_H
+
+#include "videowaveformscopewidget.h"
+
+class VideoRgbParadeScopeWidget Q_DECL_FINAL : public VideoWaveformScopeWidget
+{
+    Q_OBJECT
+
+public:
+    explicit VideoRgbParadeScopeWidget();
+    QString getTitle() Q_DECL_OVERRIDE;
+};
+
+#endif // VIDEORGBPARADESCOPEWIDGET_H
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "videovectorscopewidget.h"
+#include "scopeframecache.h"
+#include <Logger.h>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QToolTip>
+#include <qmath.h>
+
+static const QColor TEXT_COLOR = {220, 220, 220};
+static const QColor GRATICULE_COLOR = {220, 220, 220, 128};
+// The angle of the skin tone line from the +U axis.
+static const qreal SKIN_TONE_DEGREES = 123.0;
+
+VideoVectorscopeWidget::VideoVectorscopeWidget()
+  : ScopeWidget("VideoVectorscope")
+  , m_frame()
+  , m_renderImg()
+  , m_counts()
+  , m_mutex(QMutex::NonRecursive)
+  , m_displayImg()
+  , m_isHD(true)
+{
+    LOG_DEBUG() << "begin";
+    setMouseTracking(true);
+    LOG_DEBUG() << "end";
+}
+
+void VideoVectorscopeWidget::refreshScope(const QSize& size, bool full)
+{
+    Q_UNUSED(size)
+    Q_UNUSED(full)
+
+    while (m_queue.count() > 0) {
+        m_frame = m_queue.pop();
+    }
+
+    ScopeFrameCache::ImagePointer chroma = ScopeFrameCache::singleton().image(m_frame, ScopeFrameCache::ChromaFormat);
+    bool isHD = m_frame.is_valid() && m_frame.get_image_height() > 576;
+    if (m_renderImg.isNull()) {
+        m_renderImg = QImage(256, 256, QImage::Format_ARGB32_Premultiplied);
+    }
+    m_renderImg.fill(0);
+
+    if (chroma) {
+        // U increases to the right and V increases upward.
+        m_counts.fill(0, 256 * 256);
+        quint32* counts = m_counts.data();
+        const uint8_t* u = chroma->plane(0);
+        const uint8_t* v = chroma->plane(1);
+        int count = chroma->width * chroma->height;
+        for (int i = 0; i < count; i++)
+            ++counts[(255 - v[i]) * 256 + u[i]];
+
+        // Any sample is visible, and the brightness increases with the count
+        // up to the saturation point.
+        quint32 saturation = qMax(1, count / 4096);
+        for (int y = 0; y < 256; y++) {
+            uint32_t* out = reinterpret_cast<uint32_t*>(m_renderImg.scanLine(y));
+            const quint32* row = counts + y * 256;
+            for (int x = 0; x < 256; x++) {
+                if (row[x]) {
+                    uint32_t value = 64 + 191 * qMin(row[x], saturation) / saturation;
+                    out[x] = value * 0x01010101u;
+                }
+            }
+        }
+    }
+
+    m_mutex.lock();
+    m_displayImg.swap(m_renderImg);
+    m_isHD = isHD;
+    m_mutex.unlock();
+}
+
+QRect VideoVectorscopeWidget::scopeRect() const
+{
+    int side = qMin(width(), height());
+    return QRect((width() - side) / 2, (height() - side) / 2, side, side);
+}
+
+QPointF VideoVectorscopeWidget::chromaToPoint(const QRect& rect, qreal u, qreal v) const
+{
+    return QPointF(rect.left() + rect.width() * (u + 0.5) / 256.0,
+                   rect.top() + rect.height() * (255.5 - v) / 256.0);
+}
+
+void VideoVectorscopeWidget::paintEvent(QPaintEvent*)
+{
+    if (!isVisible())
+        return;
+
+    // Create the painter
+    QPainter p(this);
+    p.setRenderHint(QPainter::Antialiasing, true);
+    QFont font = QWidget::font();
+    int fontSize = font.pointSize() - (font.pointSize() > 10? 2 : (font.pointSize() > 8? 1 : 0));
+    font.setPointSize(fontSize);
+    QFontMetrics fm(font);
+    p.setFont(font);
+
+    // Fill the background
+    p.fillRect(0, 0, width(), height(), QBrush(Qt::black, Qt::SolidPattern));
+    QRect rect = scopeRect();
+
+    // draw the vectorscope data
+    m_mutex.lock();
+    if(!m_displayImg.isNull()) {
+        p.drawImage(rect, m_displayImg, m_displayImg.rect());
+    }
+    bool isHD = m_isHD;
+    m_mutex.unlock();
+
+    // Draw the graticule: the axes and the limit of legal chroma.
+    QPen pen;
+    pen.setColor(GRATICULE_COLOR);
+    pen.setWidth(devicePixelRatio());
+    p.setPen(pen);
+    p.setBrush(Qt::NoBrush);
+    QPointF center = chromaToPoint(rect, 128, 128);
+    qreal radius = rect.width() * 112.0 / 256.0;
+    p.drawEllipse(center, radius, radius);
+    p.drawLine(chromaToPoint(rect, 16, 128), chromaToPoint(rect, 240, 128));
+    p.drawLine(chromaToPoint(rect, 128, 16), chromaToPoint(rect, 128, 240));
+    qreal skinTone = qDegreesToRadians(SKIN_TONE_DEGREES);
+    p.drawLine(center, center + QPointF(radius * qCos(skinTone), -radius * qSin(skinTone)));
+
+    // Draw the targets for 75% color bars.
+    const qreal kr = isHD? 0.2126 : 0.299;
+    const qreal kb = isHD? 0.0722 : 0.114;
+    struct { const char* name; qreal r, g, b; } targets[] = {
+        { QT_TR_NOOP("R"),  0.75, 0.0,  0.0  },
+        { QT_TR_NOOP("Mg"), 0.75, 0.0,  0.75 },
+        { QT_TR_NOOP("B"),  0.0,  0.0,  0.75 },
+        { QT_TR_NOOP("Cy"), 0.0,  0.75, 0.75 },
+        { QT_TR_NOOP("G"),  0.0,  0.75, 0.0  },
+        { QT_TR_NOOP("Yl"), 0.75, 0.75, 0.0  },
+    };
+    pen.setColor(TEXT_COLOR);
+    p.setPen(pen);
+    qreal box = qMax(4.0, rect.width() / 40.0);
+    for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+        qreal y = kr * targets[i].r + (1.0 - kr - kb) * targets[i].g + kb * targets[i].b;
+        qreal u = 128 + 224 * (targets[i].b - y) / (2.0 * (1.0 - kb));
+        qreal v = 128 + 224 * (targets[i].r - y) / (2.0 * (1.0 - kr));
+        QPointF target = chromaToPoint(rect, u, v);
+        p.drawRect(QRectF(target.x() - box / 2, target.y() - box / 2, box, box));
+        // Place the label outside of the target, away from the center.
+        QPointF direction = target - center;
+        qreal length = qSqrt(direction.x() * direction.x() + direction.y() * direction.y());
+        if (length > 0)
+            direction /= length;
+        QString label = tr(targets[i].name);
+        QRect labelRect = fm.tightBoundingRect(label);
+        QPointF labelCenter = target + direction * (box + labelRect.width());
+        p.drawText(QPointF(labelCenter.x() - labelRect.width() / 2,
+                           labelCenter.y() + labelRect.height() / 2), label);
+    }
+
+    p.end();
+}
+
+void VideoVectorscopeWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    QRect rect = scopeRect();
+    if (!rect.contains(event->pos()) || rect.width() <= 0) {
+        QToolTip::hideText();
+        return;
+    }
+    int u = qBound(0, 256 * (event->pos().x() - rect.left()) / rect.width(), 255);
+    int v = qBound(0, 255 - 256 * (event->pos().y() - rect.top()) / rect.height(), 255);
+    qreal hue = qRadiansToDegrees(qAtan2(v - 128, u - 128));
+    if (hue < 0)
+        hue += 360.0;
+    QString text = QString(tr("U: %1\nV: %2\nAngle: %3°"))
+            .arg(QString::number(u), QString::number(v), QString::number(qRound(hue)));
+    QToolTip::showText(event->globalPos(), text);
+}
+
+QString VideoVectorscopeWidget::getTitle()
+{
+   return tr("Video Vectorscope");
+}
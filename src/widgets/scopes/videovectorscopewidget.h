@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEOVECTORSCOPEWIDGET_H
+#define VIDEOVECTORSCOPEWIDGET_H
+
+#include "scopewidget.h"
+#include <QMutex>
+#include <QImage>
+#include <QVector>
+
+class VideoVectorscopeWidget Q_DECL_FINAL : public ScopeWidget
+{
+    Q_OBJECT
+
+public:
+    explicit VideoVectorscopeWidget();
+    QString getTitle() Q_DECL_OVERRIDE;
+    bool isVideoScope() const Q_DECL_OVERRIDE { return true; }
+
+private:
+    void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
+    void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
+    void mouseMoveEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
+    QRect scopeRect() const;
+    QPointF chromaToPoint(const QRect& rect, qreal u, qreal v) const;
+
+    SharedFrame m_frame;
+    QImage m_renderImg;
+    QVector<quint32> m_counts;
+
+    // Variables accessed from multiple threads (mutex protected)
+    QMutex m_mutex;
+    QImage m_displayImg;
+    bool m_isHD;
+};
+
+#endif // VIDEOVECTORSCOPEWIDGET_H
@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "videowaveformkernel.h"
+#include "scopeframecache.h"
+#include <Logger.h>
+#include <QElapsedTimer>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define WAVEFORM_SSE2
+#   include <emmintrin.h>
+#   if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#       define WAVEFORM_AVX2
+#       include <immintrin.h>
+#   endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#   define WAVEFORM_NEON
+#   include <arm_neon.h>
+#endif
+
+// The number of samples in a column that saturates a pixel when every row
+// lands in the same place. This matches the previous waveform brightness.
+static const int kSaturationSamples = 17;
+
+typedef void (*ToneMapRowFunction)(const quint16* counts, uint32_t* out, int n,
+                                   quint16 saturation, quint16 gain, uint32_t color);
+
+static inline uint8_t clamp8(int value)
+{
+    return value < 0? 0 : (value > 255? 255 : value);
+}
+
+// The count is limited to saturation and scaled by gain / 256, which the
+// caller chooses so the product fits in 16 bits. The resulting value is
+// replicated into every byte and masked by the (premultiplied) color.
+static void toneMapRowScalar(const quint16* counts, uint32_t* out, int n,
+                             quint16 saturation, quint16 gain, uint32_t color)
+{
+    for (int i = 0; i < n; ++i) {
+        uint32_t count = counts[i] < saturation? counts[i] : saturation;
+        uint32_t value = (count * gain) >> 8;
+        out[i] = (value * 0x01010101u) & color;
+    }
+}
+
+#ifdef WAVEFORM_SSE2
+static void toneMapRowSse2(const quint16* counts, uint32_t* out, int n,
+                           quint16 saturation, quint16 gain, uint32_t color)
+{
+    const __m128i vSaturation = _mm_set1_epi16(short(saturation));
+    const __m128i vGain = _mm_set1_epi16(short(gain));
+    const __m128i vColor = _mm_set1_epi32(int(color));
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i count = _mm_loadu_si128((const __m128i*) (counts + i));
+        // Unsigned minimum, which SSE2 does not have for 16-bit lanes.
+        count = _mm_sub_epi16(count, _mm_subs_epu16(count, vSaturation));
+        __m128i value = _mm_srli_epi16(_mm_mullo_epi16(count, vGain), 8);
+        __m128i bytes = _mm_packus_epi16(value, zero);
+        bytes = _mm_unpacklo_epi8(bytes, bytes);
+        __m128i lo = _mm_unpacklo_epi16(bytes, bytes);
+        __m128i hi = _mm_unpackhi_epi16(bytes, bytes);
+        _mm_storeu_si128((__m128i*) (out + i), _mm_and_si128(lo, vColor));
+        _mm_storeu_si128((__m128i*) (out + i + 4), _mm_and_si128(hi, vColor));
+    }
+    toneMapRowScalar(counts + i, out + i, n - i, saturation, gain, color);
+}
+#endif
+
+#ifdef WAVEFORM_AVX2
+__attribute__((target("avx2")))
+static void toneMapRowAvx2(const quint16* counts, uint32_t* out, int n,
+                           quint16 saturation, quint16 gain, uint32_t color)
+{
+    const __m256i vSaturation = _mm256_set1_epi16(short(saturation));
+    const __m256i vGain = _mm256_set1_epi16(short(gain));
+    const __m256i vColor = _mm256_set1_epi32(int(color));
+    const __m256i vSpread = _mm256_set1_epi32(0x01010101);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i count = _mm256_loadu_si256((const __m256i*) (counts + i));
+        count = _mm256_min_epu16(count, vSaturation);
+        __m256i value = _mm256_srli_epi16(_mm256_mullo_epi16(count, vGain), 8);
+        __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(value));
+        __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(value, 1));
+        lo = _mm256_and_si256(_mm256_mullo_epi32(lo, vSpread), vColor);
+        hi = _mm256_and_si256(_mm256_mullo_epi32(hi, vSpread), vColor);
+        _mm256_storeu_si256((__m256i*) (out + i), lo);
+        _mm256_storeu_si256((__m256i*) (out + i + 8), hi);
+    }
+    toneMapRowSse2(counts + i, out + i, n - i, saturation, gain, color);
+}
+#endif
+
+#ifdef WAVEFORM_NEON
+static void toneMapRowNeon(const quint16* counts, uint32_t* out, int n,
+                           quint16 saturation, quint16 gain, uint32_t color)
+{
+    const uint16x8_t vSaturation = vdupq_n_u16(saturation);
+    const uint16x8_t vGain = vdupq_n_u16(gain);
+    const uint32x4_t vColor = vdupq_n_u32(color);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t count = vminq_u16(vld1q_u16(counts + i), vSaturation);
+        uint16x8_t value = vshrq_n_u16(vmulq_u16(count, vGain), 8);
+        uint32x4_t lo = vmulq_n_u32(vmovl_u16(vget_low_u16(value)), 0x01010101u);
+        uint32x4_t hi = vmulq_n_u32(vmovl_u16(vget_high_u16(value)), 0x01010101u);
+        vst1q_u32(out + i, vandq_u32(lo, vColor));
+        vst1q_u32(out + i + 4, vandq_u32(hi, vColor));
+    }
+    toneMapRowScalar(counts + i, out + i, n - i, saturation, gain, color);
+}
+#endif
+
+static ToneMapRowFunction selectToneMapRow(const char** name)
+{
+#if defined(WAVEFORM_AVX2)
+    // This runs during static initialization, which may precede GCC's own CPU detection.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        *name = "AVX2";
+        return toneMapRowAvx2;
+    }
+#endif
+#if defined(WAVEFORM_SSE2)
+    *name = "SSE2";
+    return toneMapRowSse2;
+#elif defined(WAVEFORM_NEON)
+    *name = "NEON";
+    return toneMapRowNeon;
+#else
+    *name = "scalar";
+    return toneMapRowScalar;
+#endif
+}
+
+static const char* toneMapRowName = 0;
+static const ToneMapRowFunction toneMapRow = selectToneMapRow(&toneMapRowName);
+
+VideoWaveformKernel::VideoWaveformKernel()
+    : m_countsWidth(0)
+{
+    for (int i = 0; i < 256; ++i)
+        m_rowOffset[i] = 0;
+}
+
+int VideoWaveformKernel::outputWidth(Mode mode, int width, int decimation)
+{
+    int columns = qMax(1, width / qMax(1, decimation));
+    int panels = panelCount(mode);
+    return qMax(1, columns / panels) * panels;
+}
+
+int VideoWaveformKernel::panelCount(Mode mode)
+{
+    return mode == LumaMode? 1 : 3;
+}
+
+const char* VideoWaveformKernel::instructionSet()
+{
+    return toneMapRowName;
+}
+
+void VideoWaveformKernel::render(Mode mode, const uint8_t* image, int width, int height, int decimation,
+                                 uint32_t* out, int outStride)
+{
+    int step = qMax(1, decimation);
+    m_countsWidth = outputWidth(mode, width, step);
+    int panelWidth = m_countsWidth / panelCount(mode);
+    m_counts.fill(0, kHeight * m_countsWidth);
+    // Brighter values are drawn higher.
+    for (int i = 0; i < 256; ++i)
+        m_rowOffset[i] = (255 - i) * m_countsWidth;
+
+    int sampledRows = (height + step - 1) / step;
+    int sampledColumns = (width + step - 1) / step;
+    int samplesPerColumn = sampledRows * sampledColumns / panelWidth;
+
+    switch (mode) {
+    case LumaMode:
+        accumulatePlane(image, width, height, step, 0, panelWidth);
+        toneMap(0, panelWidth, samplesPerColumn, height, 0xffffffff, out, outStride);
+        break;
+    case YuvParadeMode: {
+        int chromaWidth = width / 2;
+        int chromaHeight = height / 2;
+        const uint8_t* u = image + width * height;
+        const uint8_t* v = u + chromaWidth * chromaHeight;
+        accumulatePlane(image, width, height, step, 0, panelWidth);
+        accumulatePlane(u, chromaWidth, chromaHeight, step, 1, panelWidth);
+        accumulatePlane(v, chromaWidth, chromaHeight, step, 2, panelWidth);
+        int chromaSamplesPerColumn = ((chromaHeight + step - 1) / step)
+                * ((chromaWidth + step - 1) / step) / panelWidth;
+        toneMap(0, panelWidth, samplesPerColumn, height, 0xffffffff, out, outStride);
+        toneMap(1, panelWidth, chromaSamplesPerColumn, chromaHeight, 0xff0000ff, out, outStride);
+        toneMap(2, panelWidth, chromaSamplesPerColumn, chromaHeight, 0xffff0000, out, outStride);
+        break;
+    }
+    case RgbParadeMode:
+        accumulatePlane(image, width, height, step, 0, panelWidth);
+        accumulatePlane(image + width * height, width, height, step, 1, panelWidth);
+        accumulatePlane(image + width * height * 2, width, height, step, 2, panelWidth);
+        toneMap(0, panelWidth, samplesPerColumn, height, 0xffff0000, out, outStride);
+        toneMap(1, panelWidth, samplesPerColumn, height, 0xff00ff00, out, outStride);
+        toneMap(2, panelWidth, samplesPerColumn, height, 0xff0000ff, out, outStride);
+        break;
+    }
+}
+
+void VideoWaveformKernel::buildColumnMap(int samples, int panel, int panelWidth)
+{
+    m_columns.resize(samples);
+    int* columns = m_columns.data();
+    for (int i = 0; i < samples; ++i)
+        columns[i] = panel * panelWidth + int(qint64(i) * panelWidth / samples);
+}
+
+void VideoWaveformKernel::accumulateRow(const uint8_t* row, int count, const int* columns)
+{
+    quint16* counts = m_counts.data();
+    for (int i = 0; i < count; ++i)
+        ++counts[m_rowOffset[row[i]] + columns[i]];
+}
+
+void VideoWaveformKernel::accumulatePlane(const uint8_t* plane, int width, int height, int step,
+                                          int panel, int panelWidth)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    int samples = (width + step - 1) / step;
+    buildColumnMap(samples, panel, panelWidth);
+    const int* columns = m_columns.constData();
+    quint16* counts = m_counts.data();
+
+    for (int y = 0; y < height; y += step) {
+        const uint8_t* row = plane + y * width;
+        if (step == 1) {
+            accumulateRow(row, samples, columns);
+        } else {
+            for (int i = 0, x = 0; i < samples; ++i, x += step)
+                ++counts[m_rowOffset[row[x]] + columns[i]];
+        }
+    }
+}
+
+void VideoWaveformKernel::convertToRgb(const uint8_t* image, int width, int height, int step,
+                                       uint8_t* r, uint8_t* g, uint8_t* b)
+{
+    int chromaWidth = width / 2;
+    int chromaHeight = height / 2;
+    if (chromaWidth <= 0 || chromaHeight <= 0)
+        return;
+    const uint8_t* uPlane = image + width * height;
+    const uint8_t* vPlane = uPlane + chromaWidth * chromaHeight;
+    int samples = (width + step - 1) / step;
+
+    // Limited range BT.709 for HD and BT.601 otherwise in 8.8 fixed point.
+    bool isHD = height > 576;
+    const int rv = isHD? 459 : 409;
+    const int gu = isHD? 55 : 100;
+    const int gv = isHD? 136 : 208;
+    const int bu = isHD? 541 : 516;
+    int luma[256];
+    for (int i = 0; i < 256; ++i)
+        luma[i] = 298 * (i - 16) + 128;
+    // The chroma contributions are computed once per chroma sample of a row.
+    QVector<int> chroma(chromaWidth * 3);
+    int* rChroma = chroma.data();
+    int* gChroma = rChroma + chromaWidth;
+    int* bChroma = gChroma + chromaWidth;
+    // Samples beyond the last chroma column (odd widths) reuse it.
+    int evenSamples = qMin(samples, (chromaWidth * 2 + step - 1) / step);
+
+    for (int y = 0; y < height; y += step) {
+        const uint8_t* yRow = image + y * width;
+        int chromaRow = qMin(y / 2, chromaHeight - 1) * chromaWidth;
+        const uint8_t* uRow = uPlane + chromaRow;
+        const uint8_t* vRow = vPlane + chromaRow;
+        for (int cx = 0; cx < chromaWidth; ++cx) {
+            int d = uRow[cx] - 128;
+            int e = vRow[cx] - 128;
+            rChroma[cx] = rv * e;
+            gChroma[cx] = -gu * d - gv * e;
+            bChroma[cx] = bu * d;
+        }
+        for (int i = 0; i < samples; ++i) {
+            int x = i * step;
+            int cx = i < evenSamples? x >> 1 : chromaWidth - 1;
+            int c = luma[yRow[x]];
+            r[i] = clamp8((c + rChroma[cx]) >> 8);
+            g[i] = clamp8((c + gChroma[cx]) >> 8);
+            b[i] = clamp8((c + bChroma[cx]) >> 8);
+        }
+        r += samples;
+        g += samples;
+        b += samples;
+    }
+}
+
+void VideoWaveformKernel::toneMap(int panel, int panelWidth, int samplesPerColumn, int planeHeight,
+                                  uint32_t color, uint32_t* out, int outStride)
+{
+    // Scale the saturation point by the sampling density so that decimation
+    // and parade panel widths keep about the same brightness.
+    int saturation = qBound(1, (kSaturationSamples * samplesPerColumn + planeHeight / 2) / qMax(1, planeHeight),
+                            255 * 256);
+    quint16 gain = (255 * 256) / saturation;
+    const quint16* counts = m_counts.constData() + panel * panelWidth;
+    out += panel * panelWidth;
+    for (int row = 0; row < kHeight; ++row)
+        toneMapRow(counts + row * m_countsWidth, out + row * outStride, panelWidth,
+                   quint16(saturation), gain, color);
+}
+
+int VideoWaveformKernel::benchmark()
+{
+    static const int kFrames = 60;
+    static const int sizes[][2] = { {1920, 1080}, {3840, 2160} };
+    static const Mode modes[] = { LumaMode, YuvParadeMode, RgbParadeMode };
+    static const char* modeNames[] = { "luma", "yuv parade", "rgb parade" };
+    static const int decimations[] = { 1, 2, 4 };
+
+    printf("video waveform benchmark (%s)\n", instructionSet());
+    LOG_INFO() << "video waveform benchmark" << instructionSet();
+    VideoWaveformKernel kernel;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        int width = sizes[s][0];
+        int height = sizes[s][1];
+        // A gradient with some pseudo-random noise so the histogram is not degenerate.
+        QVector<uint8_t> image(width * height * 3 / 2);
+        uint32_t seed = 1;
+        for (int i = 0; i < image.size(); ++i) {
+            seed = seed * 1103515245u + 12345u;
+            image[i] = uint8_t((i % width) * 219 / width + 16 + ((seed >> 16) & 15));
+        }
+        QVector<uint32_t> out(width * kHeight);
+        // The RGB parade renders the shared, downsampled RGB image, and the
+        // conversion is included in its time.
+        int rgbStep = ScopeFrameCache::step(width);
+        int rgbWidth = (width + rgbStep - 1) / rgbStep;
+        int rgbHeight = (height + rgbStep - 1) / rgbStep;
+        QVector<uint8_t> rgb(rgbWidth * rgbHeight * 3);
+        uint8_t* r = rgb.data();
+        uint8_t* g = r + rgbWidth * rgbHeight;
+        uint8_t* b = g + rgbWidth * rgbHeight;
+
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+            for (size_t d = 0; d < sizeof(decimations) / sizeof(decimations[0]); ++d) {
+                bool isRgb = modes[m] == RgbParadeMode;
+                int outWidth = outputWidth(modes[m], isRgb? rgbWidth : width, decimations[d]);
+                QElapsedTimer timer;
+                timer.start();
+                for (int frame = 0; frame < kFrames; ++frame) {
+                    if (isRgb) {
+                        convertToRgb(image.constData(), width, height, rgbStep, r, g, b);
+                        kernel.render(modes[m], rgb.constData(), rgbWidth, rgbHeight, decimations[d],
+                                      out.data(), outWidth);
+                    } else {
+                        kernel.render(modes[m], image.constData(), width, height, decimations[d],
+                                      out.data(), outWidth);
+                    }
+                }
+                double ms = double(timer.nsecsElapsed()) / 1000000.0 / kFrames;
+                printf("%dx%d %-10s decimation %d: %.3f ms/frame\n", width, height,
+                       modeNames[m], decimations[d], ms);
+                LOG_INFO() << width << "x" << height << modeNames[m] << "decimation" << decimations[d]
+                           << ms << "ms/frame";
+            }
+        }
+    }
+    fflush(stdout);
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2019 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEOWAVEFORMKERNEL_H
+#define VIDEOWAVEFORMKERNEL_H
+
+#include <QVector>
+#include <stdint.h>
+
+/*!
+  \class VideoWaveformKernel
+  \brief Computes a video waveform from an 8-bit image into an ARGB32 buffer.
+
+  The image is read row by row and each sample increments a 16-bit counter in
+  a per-column histogram laid out like the output image. The histogram is then
+  converted to premultiplied ARGB pixels with SSE2, AVX2 or NEON when available.
+  The scatter increments themselves remain scalar since the target addresses
+  depend on the sample values.
+
+  An optional decimation factor samples every Nth row and column.
+*/
+
+class VideoWaveformKernel
+{
+public:
+    enum Mode {
+        LumaMode,
+        YuvParadeMode,
+        RgbParadeMode
+    };
+
+    static const int kHeight = 256;
+
+    VideoWaveformKernel();
+
+    //! Returns the width of the output image for a source image width.
+    static int outputWidth(Mode mode, int width, int decimation);
+    //! Returns the number of side by side panels (channels) of the mode.
+    static int panelCount(Mode mode);
+    //! Returns the name of the instruction set used for the conversion.
+    static const char* instructionSet();
+
+    /*!
+      Renders the waveform of an image, which is yuv420p for LumaMode and
+      YuvParadeMode and planar RGB (see convertToRgb()) for RgbParadeMode.
+
+      \a out must hold outputWidth() x kHeight pixels, and \a outStride is
+      the distance between its rows in pixels.
+    */
+    void render(Mode mode, const uint8_t* image, int width, int height, int decimation,
+                uint32_t* out, int outStride);
+
+    /*!
+      Converts a yuv420p image to planar RGB using limited range BT.709 for HD
+      and BT.601 otherwise, sampling every \a step rows and columns.
+    */
+    static void convertToRgb(const uint8_t* image, int width, int height, int step,
+                             uint8_t* r, uint8_t* g, uint8_t* b);
+
+    //! Prints the time per frame at 1080p and 2160p to stdout and the log.
+    static int benchmark();
+
+private:
+    void accumulatePlane(const uint8_t* plane, int width, int height, int step, int panel, int panelWidth);
+    void accumulateRow(const uint8_t* row, int count, const int* columns);
+    void buildColumnMap(int samples, int panel, int panelWidth);
+    void toneMap(int panel, int panelWidth, int samplesPerColumn, int planeHeight,
+                 uint32_t color, uint32_t* out, int outStride);
+
+    QVector<quint16> m_counts;
+    QVector<int> m_columns;
+    int m_rowOffset[256];
+    int m_countsWidth;
+};
+
+#endif // VIDEOWAVEFORMKERNEL_H
@@ -17,28 +17,73 @@
  */
 
 #include "videowaveformscopewidget.h"
+#include "scopeframecache.h"
+#include "settings.h"
 #include <Logger.h>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QToolTip>
+#include <QMenu>
+#include <QActionGroup>
 
 static const qreal IRE0 = 16;
 static const qreal IRE100 = 235;
 static const QColor TEXT_COLOR = {220, 220, 220};
 
+static VideoWaveformKernel::Mode modeFromString(const QString& mode)
+{
+    if (mode == "yuv")
+        return VideoWaveformKernel::YuvParadeMode;
+    else if (mode == "rgb")
+        return VideoWaveformKernel::RgbParadeMode;
+    return VideoWaveformKernel::LumaMode;
+}
+
+static QString modeToString(VideoWaveformKernel::Mode mode)
+{
+    switch (mode) {
+    case VideoWaveformKernel::YuvParadeMode:
+        return "yuv";
+    case VideoWaveformKernel::RgbParadeMode:
+        return "rgb";
+    default:
+        return "luma";
+    }
+}
+
 
 VideoWaveformScopeWidget::VideoWaveformScopeWidget()
   : ScopeWidget("VideoZoom")
   , m_frame()
   , m_renderImg()
+  , m_isFixedMode(false)
   , m_mutex(QMutex::NonRecursive)
   , m_displayImg()
+  , m_mode(modeFromString(Settings.videoWaveformScopeMode()))
+  , m_displayMode(m_mode)
+  , m_displaySourceWidth(0)
+  , m_decimation(Settings.videoWaveformScopeDecimation())
 {
     LOG_DEBUG() << "begin";
     setMouseTracking(true);
     LOG_DEBUG() << "end";
 }
 
+VideoWaveformScopeWidget::VideoWaveformScopeWidget(const QString& name, VideoWaveformKernel::Mode mode)
+  : ScopeWidget(name)
+  , m_frame()
+  , m_renderImg()
+  , m_isFixedMode(true)
+  , m_mutex(QMutex::NonRecursive)
+  , m_displayImg()
+  , m_mode(mode)
+  , m_displayMode(mode)
+  , m_displaySourceWidth(0)
+  , m_decimation(1)
+{
+    setMouseTracking(true);
+}
+
 
 void VideoWaveformScopeWidget::refreshScope(const QSize& size, bool full)
 {
@@ -49,31 +94,42 @@ void VideoWaveformScopeWidget::refreshScope(const QSize& size, bool full)
         m_frame = m_queue.pop();
     }
 
+    m_mutex.lock();
+    VideoWaveformKernel::Mode mode = m_mode;
+    int decimation = m_decimation;
+    m_mutex.unlock();
+
+    int sourceWidth = 0;
     if (m_frame.is_valid() && m_frame.get_image_width() && m_frame.get_image_height()) {
-        int columns = m_frame.get_image_width();
-        if (m_renderImg.width() != columns) {
-            m_renderImg = QImage(columns, 256, QImage::Format_ARGB32_Premultiplied);
-        }
-        QColor bgColor( 0, 0, 0 ,0 );
-        m_renderImg.fill(bgColor);
-
-        const uint8_t* yData = m_frame.get_image();
-
-        for (int x = 0; x < columns; x++) {
-            int pixels = m_frame.get_image_height();
-            for (int j = 0; j < pixels; j++) {
-                int y = 255 - (yData[j * columns + x]);
-                QRgb currentVal = m_renderImg.pixel(x,y);
-                if (currentVal < 0xffffffff) {
-                    currentVal += 0x0f0f0f0f;
-                    m_renderImg.setPixel(x, y, currentVal);
-                }
+        const uint8_t* image = m_frame.get_image();
+        int width = m_frame.get_image_width();
+        int height = m_frame.get_image_height();
+        sourceWidth = width;
+        // The RGB planes are shared with the other scopes.
+        ScopeFrameCache::ImagePointer rgb;
+        if (mode == VideoWaveformKernel::RgbParadeMode) {
+            rgb = ScopeFrameCache::singleton().image(m_frame, ScopeFrameCache::RgbFormat);
+            if (rgb) {
+                image = rgb->data.constData();
+                width = rgb->width;
+                height = rgb->height;
+            } else {
+                mode = VideoWaveformKernel::YuvParadeMode;
             }
         }
+        int columns = VideoWaveformKernel::outputWidth(mode, width, decimation);
+        if (m_renderImg.width() != columns) {
+            m_renderImg = QImage(columns, VideoWaveformKernel::kHeight, QImage::Format_ARGB32_Premultiplied);
+        }
+        m_kernel.render(mode, image, width, height, decimation,
+                        reinterpret_cast<uint32_t*>(m_renderImg.bits()),
+                        m_renderImg.bytesPerLine() / 4);
     }
 
     m_mutex.lock();
     m_displayImg.swap(m_renderImg);
+    m_displayMode = mode;
+    m_displaySourceWidth = sourceWidth;
     m_mutex.unlock();
 }
 
@@ -103,10 +159,29 @@ void VideoWaveformScopeWidget::paintEvent(QPaintEvent*)
     if(!m_displayImg.isNull()) {
         p.drawImage(rect(), m_displayImg, m_displayImg.rect());
     }
+    VideoWaveformKernel::Mode mode = m_displayMode;
     m_mutex.unlock();
 
-    // Add IRE lines
+    // Separate and label the parade panels
     int textpad = 3;
+    int panels = VideoWaveformKernel::panelCount(mode);
+    if (panels > 1) {
+        QStringList labels;
+        if (mode == VideoWaveformKernel::RgbParadeMode)
+            labels << tr("R") << tr("G") << tr("B");
+        else
+            labels << tr("Y") << tr("U") << tr("V");
+        for (int i = 0; i < panels; i++) {
+            qreal x = qreal(width()) * i / panels;
+            if (i > 0)
+                p.drawLine(QPointF(x, 0), QPointF(x, height()));
+            QRect labelRect = fm.tightBoundingRect(labels[i]);
+            p.drawText(x + width() / panels - labelRect.width() - textpad,
+                       labelRect.height() + textpad, labels[i]);
+        }
+    }
+
+    // Add IRE lines
     // 100
     qreal ire100y = height() - (height() * IRE100 / 255);
     p.drawLine(QPointF(0, ire100y), QPointF(width(), ire100y));
@@ -130,11 +205,16 @@ void VideoWaveformScopeWidget::mouseMoveEvent(QMouseEvent *event)
 
     m_mutex.lock();
     int frameWidth = m_displayImg.width();
+    int sourceWidth = m_displaySourceWidth;
+    int panels = VideoWaveformKernel::panelCount(m_displayMode);
     m_mutex.unlock();
 
     if(frameWidth != 0)
     {
-        int pixel = frameWidth * event->pos().x() / width();
+        // Map the position to a source pixel within its parade panel.
+        int panelWidth = qMax(1, frameWidth / panels);
+        int column = qMin(frameWidth * event->pos().x() / width(), frameWidth - 1);
+        int pixel = (column % panelWidth) * sourceWidth / panelWidth;
         text =  QString(tr("Pixel: %1\nIRE: %2")).arg(QString::number(pixel), QString::number(ire));
     }
     else
@@ -144,6 +224,73 @@ void VideoWaveformScopeWidget::mouseMoveEvent(QMouseEvent *event)
     QToolTip::showText(event->globalPos(), text);
 }
 
+void VideoWaveformScopeWidget::contextMenuEvent(QContextMenuEvent* event)
+{
+    if (m_isFixedMode) {
+        ScopeWidget::contextMenuEvent(event);
+        return;
+    }
+    QMenu menu(this);
+    m_mutex.lock();
+    VideoWaveformKernel::Mode mode = m_mode;
+    int decimation = m_decimation;
+    m_mutex.unlock();
+
+    QActionGroup modeGroup(this);
+    connect(&modeGroup, SIGNAL(triggered(QAction*)), SLOT(onModeTriggered(QAction*)));
+    QAction* action = menu.addAction(tr("Luma"));
+    action->setData(VideoWaveformKernel::LumaMode);
+    modeGroup.addAction(action);
+    action = menu.addAction(tr("YUV Parade"));
+    action->setData(VideoWaveformKernel::YuvParadeMode);
+    modeGroup.addAction(action);
+    action = menu.addAction(tr("RGB Parade"));
+    action->setData(VideoWaveformKernel::RgbParadeMode);
+    modeGroup.addAction(action);
+    foreach (QAction* a, modeGroup.actions()) {
+        a->setCheckable(true);
+        a->setChecked(a->data().toInt() == mode);
+    }
+
+    menu.addSeparator();
+    QActionGroup decimationGroup(this);
+    connect(&decimationGroup, SIGNAL(triggered(QAction*)), SLOT(onDecimationTriggered(QAction*)));
+    action = menu.addAction(tr("Full Resolution"));
+    action->setData(1);
+    decimationGroup.addAction(action);
+    action = menu.addAction(tr("Half Resolution"));
+    action->setData(2);
+    decimationGroup.addAction(action);
+    action = menu.addAction(tr("Quarter Resolution"));
+    action->setData(4);
+    decimationGroup.addAction(action);
+    foreach (QAction* a, decimationGroup.actions()) {
+        a->setCheckable(true);
+        a->setChecked(a->data().toInt() == decimation);
+    }
+
+    menu.exec(event->globalPos());
+}
+
+void VideoWaveformScopeWidget::onModeTriggered(QAction* action)
+{
+    VideoWaveformKernel::Mode mode = VideoWaveformKernel::Mode(action->data().toInt());
+    Settings.setVideoWaveformScopeMode(modeToString(mode));
+    m_mutex.lock();
+    m_mode = mode;
+    m_mutex.unlock();
+    requestRefresh();
+}
+
+void VideoWaveformScopeWidget::onDecimationTriggered(QAction* action)
+{
+    Settings.setVideoWaveformScopeDecimation(action->data().toInt());
+    m_mutex.lock();
+    m_decimation = action->data().toInt();
+    m_mutex.unlock();
+    requestRefresh();
+}
+
 QString VideoWaveformScopeWidget::getTitle()
 {
    return tr("Video Waveform");
@@ -20,28 +20,46 @@
 #define VIDEOWAVEFORMSCOPEWIDGET_H
 
 #include "scopewidget.h"
+#include "videowaveformkernel.h"
 #include <QMutex>
 #include <QImage>
 
-class VideoWaveformScopeWidget Q_DECL_FINAL : public ScopeWidget
+class VideoWaveformScopeWidget : public ScopeWidget
 {
     Q_OBJECT
     
 public:
     explicit VideoWaveformScopeWidget();
     QString getTitle() Q_DECL_OVERRIDE;
+    bool isVideoScope() const Q_DECL_OVERRIDE { return true; }
+
+protected:
+    //! Constructs a scope that always uses \a mode and has no context menu.
+    VideoWaveformScopeWidget(const QString& name, VideoWaveformKernel::Mode mode);
 
 private:
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
     void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
     void mouseMoveEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
+    void contextMenuEvent(QContextMenuEvent* event) Q_DECL_OVERRIDE;
+
+private slots:
+    void onModeTriggered(QAction* action);
+    void onDecimationTriggered(QAction* action);
 
+private:
     SharedFrame m_frame;
     QImage m_renderImg;
+    VideoWaveformKernel m_kernel;
+    const bool m_isFixedMode;
 
     // Variables accessed from multiple threads (mutex protected)
     QMutex m_mutex;
     QImage m_displayImg;
+    VideoWaveformKernel::Mode m_mode;
+    VideoWaveformKernel::Mode m_displayMode;
+    int m_displaySourceWidth;
+    int m_decimation;
 };
 
 #endif // VIDEOWAVEFORMSCOPEWIDGET_H